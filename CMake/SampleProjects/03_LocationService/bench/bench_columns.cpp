@@ -0,0 +1,118 @@
+// bench_columns.cpp
+//
+// Compares nmea_parse_columns with the nmeaINFO path: every row of the
+// columns must match the nmeaINFO state at the end of its epoch. Reports
+// parse throughput of both and the cost of scanning positions as
+// nmeaINFO snapshots versus contiguous columns.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+struct EpochSnapshots
+{
+    std::vector<nmeaINFO> fixes;
+    long long tod;
+};
+
+// Keep nmeaINFO as it is at the end of every epoch, the way columns keep one row per epoch
+static int snapshotEpoch(int ptype, const void *, const nmeaINFO *info, void *userData)
+{
+    EpochSnapshots *epochs = static_cast<EpochSnapshots *>(userData);
+    const long long tod = info->utc_us % NMEA_TIME_DAY_US;
+
+    if (ptype == GPGGA || ptype == GPRMC)
+    {
+        if (epochs->fixes.empty() || tod != epochs->tod)
+            epochs->fixes.push_back(*info);
+        else
+            epochs->fixes.back() = *info;
+        epochs->tod = tod;
+    }
+    else if (ptype == GPVTG && !epochs->fixes.empty())
+    {
+        epochs->fixes.back() = *info;
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    const long sentences = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    const std::string stream = benchMakeStream(sentences);
+    nmeaPARSER parser;
+    nmeaINFO info;
+    nmeaFIXCOLUMNS cols;
+    EpochSnapshots epochs;
+    int failures = 0;
+
+    nmea_zero_INFO(&info);
+    nmea_parser_init(&parser);
+    epochs.fixes.reserve(sentences / 2);
+    epochs.tod = 0;
+
+    BenchTimer infoTimer;
+    nmea_parse_mapped(&parser, stream.data(), static_cast<long long>(stream.size()), &info, &snapshotEpoch, &epochs, 0);
+    benchReport("nmea_parse + nmeaINFO snapshots", sentences, static_cast<long>(stream.size()), infoTimer.seconds());
+
+    nmea_columns_init(&cols, 0);
+    BenchTimer colsTimer;
+    const long parsed = nmea_parse_columns(&parser, stream.data(), static_cast<int>(stream.size()), &cols);
+    benchReport("nmea_parse_columns", parsed, static_cast<long>(stream.size()), colsTimer.seconds());
+    nmea_parser_destroy(&parser);
+
+    long mismatches = (static_cast<size_t>(cols.use) == epochs.fixes.size()) ? 0 : 1;
+    for (int row = 0; !mismatches && row < cols.use; ++row)
+    {
+        const nmeaINFO &fix = epochs.fixes[row];
+        if (cols.lat[row] != fix.lat || cols.lon[row] != fix.lon || cols.elv[row] != fix.elv ||
+            cols.speed[row] != fix.speed || cols.direction[row] != fix.direction ||
+            cols.sig[row] != fix.sig || cols.utc_us[row] != fix.utc_us)
+        {
+            ++mismatches;
+        }
+    }
+    std::printf("columns: %d rows, %zu epochs, %ld mismatches\n", cols.use, epochs.fixes.size(), mismatches);
+    failures += (mismatches != 0);
+
+    // Mean position in degrees, over snapshots and over columns
+    const int scans = 50;
+    double sumInfo = 0, sumCols = 0;
+
+    BenchTimer scanInfoTimer;
+    for (int scan = 0; scan < scans; ++scan)
+    {
+        for (const nmeaINFO &fix : epochs.fixes)
+        {
+            sumInfo += nmea_ndeg2degree(fix.lat) + nmea_ndeg2degree(fix.lon);
+        }
+    }
+    const double scanInfoSeconds = scanInfoTimer.seconds();
+
+    std::vector<double> latDeg(cols.use), lonDeg(cols.use);
+    BenchTimer scanColsTimer;
+    for (int scan = 0; scan < scans; ++scan)
+    {
+        nmea_columns_degrees(&cols, latDeg.data(), lonDeg.data());
+        for (int row = 0; row < cols.use; ++row)
+        {
+            sumCols += latDeg[row] + lonDeg[row];
+        }
+    }
+    const double scanColsSeconds = scanColsTimer.seconds();
+
+    std::printf("position scan: nmeaINFO %.3f s, columns %.3f s (%zu-byte rows vs %zu bytes per row)\n",
+                scanInfoSeconds, scanColsSeconds, sizeof(nmeaINFO), 2 * sizeof(double));
+    if (std::fabs(sumInfo - sumCols) > 1e-6 * std::fabs(sumInfo))
+    {
+        std::printf("  position sums differ: %f vs %f\n", sumInfo, sumCols);
+        ++failures;
+    }
+
+    nmea_columns_destroy(&cols);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// bench_common.h
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Sample receiver burst, the same sentences LocationService used for its demo output
+static const char *const benchSentences[] = {
+    "$GPRMC,173843,A,3349.896,N,11808.521,W,000.0,360.0,230108,013.4,E*69\r\n",
+    "$GPGGA,111609.14,5001.27,N,3613.06,E,3,08,0.0,10.2,M,0.0,M,0.0,0000*70\r\n",
+    "$GPGSV,2,1,08,01,05,005,80,02,05,050,80,03,05,095,80,04,05,140,80*7f\r\n",
+    "$GPGSV,2,2,08,05,05,185,80,06,05,230,80,07,05,275,80,08,05,320,80*71\r\n",
+    "$GPGSA,A,3,01,02,03,04,05,06,07,08,00,00,00,00,0.0,0.0,0.0*3a\r\n",
+    "$GPRMC,111609.14,A,5001.27,N,3613.06,E,11.2,0.0,261206,0.0,E*50\r\n",
+    "$GPVTG,217.5,T,208.8,M,000.00,N,000.01,K*4C\r\n"
+};
+
+static const int benchSentenceCount = sizeof(benchSentences) / sizeof(benchSentences[0]);
+
+// Concatenate the sample burst until the stream holds at least minSentences sentences
+inline std::string benchMakeStream(long minSentences)
+{
+    std::string stream;
+    for (long i = 0; i < minSentences; ++i)
+    {
+        stream += benchSentences[i % benchSentenceCount];
+    }
+    return stream;
+}
+
+class BenchTimer
+{
+public:
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+    double seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+inline void benchReport(const char *name, long sentences, long bytes, double seconds)
+{
+    std::printf("%-32s %10ld sentences %8.3f s %12.0f sentences/s %8.1f MB/s\n",
+                name, sentences, seconds,
+                sentences / seconds, bytes / seconds / (1024.0 * 1024.0));
+}
+
+#endif // BENCH_COMMON_H
@@ -0,0 +1,175 @@
+// bench_corpus.cpp
+//
+// Parser throughput over the data sets of nmea_corpus (clean, noisy and
+// GSV heavy), read from the directory given as argument or the one written
+// by the corpus target. Checks that the parser returns exactly the
+// sentences whose checksum matches, and that nmeaGENCONTEXT streams do not
+// depend on other generators running on the same thread.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+static bool readFile(const std::string &path, std::string &data)
+{
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+    char buff[65536];
+    size_t count;
+    while ((count = std::fread(buff, 1, sizeof(buff), file)) > 0)
+        data.append(buff, count);
+    std::fclose(file);
+    return true;
+}
+
+static int hexValue(char ch)
+{
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    return -1;
+}
+
+struct LineCount
+{
+    long lines = 0;
+    long valid = 0;
+    long gsv = 0;
+};
+
+// Checksums verified here, independent of the parser
+static LineCount countLines(const std::string &data)
+{
+    LineCount count;
+    for (size_t line = 0; line < data.size();)
+    {
+        const char *tail = static_cast<const char *>(memchr(data.data() + line, '\n', data.size() - line));
+        const size_t end = tail ? static_cast<size_t>(tail - data.data()) + 1 : data.size();
+        const char *star = static_cast<const char *>(memchr(data.data() + line, '*', end - line));
+        count.lines++;
+        if (star != NULL && star + 2 < data.data() + end)
+        {
+            int crc = 0;
+            for (const char *ch = data.data() + line + 1; ch < star; ++ch)
+                crc ^= static_cast<unsigned char>(*ch);
+            if (hexValue(star[1]) == (crc >> 4) && hexValue(star[2]) == (crc & 0xf))
+                count.valid++;
+        }
+        if (data.compare(line + 3, 3, "GSV") == 0)
+            count.gsv++;
+        line = end;
+    }
+    return count;
+}
+
+static long parseAll(const std::string &data, double &seconds)
+{
+    nmeaPARSER parser;
+    void *pack = NULL;
+    long packets = 0;
+    nmea_parser_init(&parser);
+
+    BenchTimer timer;
+    for (size_t done = 0; done < data.size();)
+    {
+        done += nmea_parser_real_push(&parser, data.data() + done, static_cast<int>(std::min<size_t>(data.size() - done, INT_MAX)));
+        while (nmea_parser_pop(&parser, &pack) != GPNON)
+            packets++;
+    }
+    seconds = timer.seconds();
+
+    nmea_parser_destroy(&parser);
+    return packets;
+}
+
+static std::string generateDevice(unsigned long long device, long epochs, bool disturb)
+{
+    nmeaGENCONTEXT ctx, other;
+    nmeaINFO info, otherInfo;
+    char buff[4096];
+    std::string out;
+
+    nmea_gen_context_init(&ctx, 7, device, 1704067200000LL, 1000);
+    nmea_gen_context_init(&other, 7, device + 1, 1704067200000LL, 1000);
+    nmeaGENERATOR *gen = nmea_create_generator(NMEA_GEN_ROTATE, &info);
+    nmeaGENERATOR *otherGen = nmea_create_generator(NMEA_GEN_ROTATE, &otherInfo);
+    for (long it = 0; it < epochs; ++it)
+    {
+        if (disturb)
+        {
+            nmea_random(0, 1);
+            nmea_generate_ctx(buff, sizeof(buff), &otherInfo, otherGen, &other, GPGGA | GPRMC);
+        }
+        out.append(buff, nmea_generate_ctx(buff, sizeof(buff), &info, gen, &ctx, GPGGA | GPGSV | GPRMC | GPVTG));
+    }
+    nmea_destroy_generator(otherGen);
+    nmea_destroy_generator(gen);
+    return out;
+}
+
+int main(int argc, char *argv[])
+{
+    const std::string dir = (argc > 1) ? argv[1] : NMEA_CORPUS_DIR;
+    static const char *const sets[] = { "clean", "noisy", "gsv" };
+    int errors = 0;
+
+    for (const char *set : sets)
+    {
+        std::string data;
+        if (!readFile(dir + "/" + set + ".nmea", data))
+        {
+            std::printf("%s/%s.nmea: cannot read\n", dir.c_str(), set);
+            errors++;
+            continue;
+        }
+
+        const LineCount count = countLines(data);
+        double seconds = 0;
+        const long packets = parseAll(data, seconds);
+        benchReport(set, count.lines, static_cast<long>(data.size()), seconds);
+        std::printf("%-32s %10ld valid %10ld corrupted %10ld GSV %10ld packets\n",
+                    "", count.valid, count.lines - count.valid, count.gsv, packets);
+
+        if (packets != count.valid)
+        {
+            std::printf("%s: %ld packets of %ld valid sentences\n", set, packets, count.valid);
+            errors++;
+        }
+        if ((std::strcmp(set, "noisy") == 0) == (count.valid == count.lines))
+        {
+            std::printf("%s: unexpected number of corrupted sentences\n", set);
+            errors++;
+        }
+        if (std::strcmp(set, "gsv") == 0 && count.gsv * 2 < count.lines)
+        {
+            std::printf("%s: only %ld GSV of %ld sentences\n", set, count.gsv, count.lines);
+            errors++;
+        }
+    }
+
+    // Same (seed, device, epoch) gives the same bytes, whatever else draws random numbers meanwhile
+    for (unsigned long long device = 0; device < 4; ++device)
+    {
+        if (generateDevice(device, 1000, false) != generateDevice(device, 1000, true))
+        {
+            std::printf("device %llu: stream depends on other generators\n", device);
+            errors++;
+        }
+    }
+    if (generateDevice(0, 10, false) == generateDevice(1, 10, false))
+    {
+        std::printf("devices 0 and 1 generate the same stream\n");
+        errors++;
+    }
+
+    std::printf("corpus: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
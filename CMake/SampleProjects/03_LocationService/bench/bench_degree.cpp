@@ -0,0 +1,114 @@
+// bench_degree.cpp
+//
+// Inline and array degree conversions (degree.h) against the gmath.cpp
+// functions: largest relative difference and throughput, plus exactness
+// of micro-degrees decoded straight from NDEG text (nmea_atoudeg).
+
+#include "bench_common.h"
+#include "nmea.h"
+#include "tok.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+static unsigned long long rngState = 0x2545F4914F6CDD1Dull;
+
+static unsigned long long nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+static double relDiff(double a, double b)
+{
+    return (a == b) ? 0 : std::fabs(a - b) / std::fmax(std::fabs(a), std::fabs(b));
+}
+
+static void report(const char *name, size_t count, double seconds, double checksum)
+{
+    std::printf("%-36s %10zu values %8.3f s %12.0f values/s (sum %.6g)\n",
+                name, count, seconds, count / seconds, checksum);
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t count = (argc > 1) ? std::strtoul(argv[1], 0, 10) : 4000000;
+    const int rounds = 10;
+    std::vector<double> ndeg(count), out(count);
+    std::vector<int> udeg(count);
+    int failures = 0;
+
+    // NDEG values as receivers print them: dddmm.mmmm
+    for (size_t i = 0; i < count; ++i)
+    {
+        ndeg[i] = (nextRandom() % 180) * 100 + (nextRandom() % 600000) / 10000.0;
+    }
+
+    double maxNdeg = 0, maxDeg = 0, maxRad = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const double deg = nmea_ndeg2degree(ndeg[i]);
+        maxNdeg = std::fmax(maxNdeg, relDiff(nmea_ndeg2degree(ndeg[i]), nmea_fast_ndeg2degree(ndeg[i])));
+        maxDeg = std::fmax(maxDeg, relDiff(nmea_degree2ndeg(deg), nmea_fast_degree2ndeg(deg)));
+        maxRad = std::fmax(maxRad, relDiff(nmea_ndeg2radian(ndeg[i]), nmea_fast_ndeg2radian(ndeg[i])));
+    }
+    std::printf("max relative difference: ndeg2degree %.3g, degree2ndeg %.3g, ndeg2radian %.3g\n", maxNdeg, maxDeg, maxRad);
+    failures += (maxNdeg > 1e-15 || maxDeg > 1e-15 || maxRad > 1e-15);
+
+    double sum = 0;
+    BenchTimer scalarTimer;
+    for (int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < count; ++i)
+            sum += nmea_ndeg2degree(ndeg[i]);
+    report("nmea_ndeg2degree", count * rounds, scalarTimer.seconds(), sum);
+
+    sum = 0;
+    BenchTimer inlineTimer;
+    for (int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < count; ++i)
+            sum += nmea_fast_ndeg2degree(ndeg[i]);
+    report("nmea_fast_ndeg2degree", count * rounds, inlineTimer.seconds(), sum);
+
+    sum = 0;
+    BenchTimer batchTimer;
+    for (int r = 0; r < rounds; ++r)
+    {
+        nmea_ndeg2degree_batch(ndeg.data(), out.data(), static_cast<int>(count));
+        sum += out[r];
+    }
+    report("nmea_ndeg2degree_batch", count * rounds, batchTimer.seconds(), sum);
+
+    sum = 0;
+    BenchTimer udegTimer;
+    for (int r = 0; r < rounds; ++r)
+    {
+        nmea_ndeg2udeg_batch(ndeg.data(), udeg.data(), static_cast<int>(count));
+        sum += udeg[r];
+    }
+    report("nmea_ndeg2udeg_batch", count * rounds, udegTimer.seconds(), sum);
+
+    // Text with up to 5 decimals, micro-degrees from text must be exact (rounded half up)
+    long textMismatches = 0;
+    for (size_t i = 0; i < count / 4; ++i)
+    {
+        const long long degrees = nextRandom() % 180;
+        const long long minutes5 = nextRandom() % 6000000;
+        char text[32];
+        const int size = std::snprintf(text, sizeof(text), "%lld%02lld.%05lld", degrees, minutes5 / 100000, minutes5 % 100000);
+        const long long exact = degrees * 1000000 + (minutes5 * 1000000 + 3000000) / 6000000;
+        const int fromText = nmea_atoudeg(text, size);
+        const int fromDouble = nmea_fast_ndeg2udeg(std::atof(text));
+        if (fromText != exact || std::abs(fromDouble - fromText) > 1)
+        {
+            if (++textMismatches <= 5)
+                std::printf("  %s: text %d, double %d, exact %lld\n", text, fromText, fromDouble, exact);
+        }
+    }
+    std::printf("micro-degrees from text: %zu values, %ld mismatches\n", count / 4, textMismatches);
+    failures += (textMismatches != 0);
+
+    return failures == 0 ? 0 : 1;
+}
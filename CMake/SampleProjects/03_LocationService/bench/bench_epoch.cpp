@@ -0,0 +1,299 @@
+// bench_epoch.cpp
+//
+// Receiver bursts (GGA, GSA, GSV sequence, RMC, VTG of one UTC time)
+// assembled by nmeaEPOCH. Checks that every epoch is handed over exactly
+// once with the time, position, DOP, VTG speed and satellite list of its
+// own burst: with complete bursts (closed by the next epoch, or early with
+// a mask of every sentence), with GSV packets lost (the previous list is
+// kept instead of a half updated one) and with RMC delayed past the epoch
+// timeout. A mask missing VTG must count every VTG as late and drop it.
+// Reports the cost per sentence next to the plain nmeaINFO merge and how
+// many updates a consumer sees with each.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const int kTimeoutMs = NMEA_DEF_EPOCH_TIMEOUT;
+static const int kBurstMask = GPGGA | GPGSA | GPGSV | GPRMC | GPVTG;
+
+static int satCount(long epoch)
+{
+    return 9 + static_cast<int>(epoch % 4);
+}
+
+static int satId(long epoch, int index)
+{
+    return 1 + static_cast<int>((epoch + index) % 32);
+}
+
+// Sentences of one burst per epoch, epoch k is k seconds after midnight
+static std::vector<std::vector<std::string>> makeBursts(long epochs)
+{
+    std::vector<std::vector<std::string>> bursts(epochs);
+    nmeaINFO info;
+    char buff[4096];
+
+    nmea_zero_INFO(&info);
+    info.sig = NMEA_SIG_MID;
+    info.fix = NMEA_FIX_3D;
+    for (long it = 0; it < epochs; ++it)
+    {
+        info.utc.hour = static_cast<int>(it / 3600 % 24);
+        info.utc.min = static_cast<int>(it / 60 % 60);
+        info.utc.sec = static_cast<int>(it % 60);
+        info.lat = 5000.0 + static_cast<double>(it % 50);
+        info.lon = 3600.0 + static_cast<double>(it % 40);
+        info.elv = static_cast<double>(it % 1000);
+        // Whole km/h and DOP survive VTG and GSA exactly, RMC knots do not
+        info.speed = static_cast<double>(it % 100);
+        info.PDOP = static_cast<double>(1 + it % 9);
+        info.satinfo.inview = satCount(it);
+        info.satinfo.inuse = 0;
+        for (int sat = 0; sat < info.satinfo.inview; ++sat)
+        {
+            info.satinfo.sat[sat].id = satId(it, sat);
+            info.satinfo.sat[sat].elv = 10 + sat;
+            info.satinfo.sat[sat].azimuth = 30 * sat;
+            info.satinfo.sat[sat].sig = 40;
+        }
+
+        const int size = nmea_generate(buff, sizeof(buff), &info, kBurstMask);
+        for (const char *line = buff, *end = buff + size; line < end;)
+        {
+            const char *tail = static_cast<const char *>(memchr(line, '\n', end - line));
+            tail = tail ? tail + 1 : end;
+            bursts[it].push_back(std::string(line, tail - line));
+            line = tail;
+        }
+    }
+    return bursts;
+}
+
+static bool isType(const std::string &sentence, const char *type)
+{
+    return sentence.compare(3, 3, type) == 0;
+}
+
+struct Assembler
+{
+    nmeaPARSER parser;
+    nmeaEPOCH epoch;
+    std::vector<nmeaINFO> fixes;
+
+    explicit Assembler(int mask = NMEA_DEF_EPOCH_MASK)
+    {
+        nmea_parser_init(&parser);
+        nmea_epoch_init(&epoch, mask, kTimeoutMs);
+    }
+
+    ~Assembler()
+    {
+        nmea_parser_destroy(&parser);
+    }
+
+    void pop()
+    {
+        const nmeaINFO *info;
+        while ((info = nmea_epoch_pop(&epoch)) != NULL)
+        {
+            if (info->smask & (GPGGA | GPRMC))
+                fixes.push_back(*info);
+        }
+    }
+
+    void push(const std::string &sentence, long long nowMs)
+    {
+        void *pack = NULL;
+        int ptype;
+        nmea_parser_real_push(&parser, sentence.data(), static_cast<int>(sentence.size()));
+        while ((ptype = nmea_parser_pop(&parser, &pack)) != GPNON)
+        {
+            if (nmea_epoch_push(&epoch, ptype, pack, nowMs))
+                pop();
+        }
+    }
+};
+
+// Every fix must be its epoch: time, position, and satellites of the epoch or, when its GSV was lost, of the one before
+static int checkFixes(const char *name, const Assembler &assembler, long epochs, long gsvLostEvery)
+{
+    int errors = 0;
+    if (static_cast<long>(assembler.fixes.size()) != epochs)
+    {
+        std::printf("%s: %zu fixes of %ld epochs\n", name, assembler.fixes.size(), epochs);
+        return 1;
+    }
+
+    for (long it = 0; it < epochs && errors < 10; ++it)
+    {
+        const nmeaINFO &fix = assembler.fixes[it];
+        const long satEpoch = (gsvLostEvery > 0 && it % gsvLostEvery == gsvLostEvery - 1) ? it - 1 : it;
+        bool ok = fix.utc.hour == it / 3600 % 24 && fix.utc.min == it / 60 % 60 && fix.utc.sec == it % 60 &&
+                  fix.lat == 5000.0 + static_cast<double>(it % 50) && fix.lon == 3600.0 + static_cast<double>(it % 40) &&
+                  fix.elv == static_cast<double>(it % 1000) && fix.PDOP == static_cast<double>(1 + it % 9) &&
+                  (!(fix.smask & GPVTG) || fix.speed == static_cast<double>(it % 100)) &&
+                  fix.satinfo.inview == satCount(satEpoch);
+        for (int sat = 0; ok && sat < fix.satinfo.inview; ++sat)
+            ok = fix.satinfo.sat[sat].id == satId(satEpoch, sat);
+        if (!ok)
+        {
+            std::printf("%s: fix %ld does not match its epoch\n", name, it);
+            errors++;
+        }
+    }
+    return errors;
+}
+
+static void report(const char *name, const nmeaEPOCH &epoch)
+{
+    std::printf("%-28s %8lu epochs %6lu partial %6lu timeouts %6lu late %6lu broken GSV\n",
+                name, epoch.epochs, epoch.partial, epoch.timeouts, epoch.late, epoch.broken);
+}
+
+int main(int argc, char *argv[])
+{
+    const long epochs = (argc > 1) ? std::atol(argv[1]) : 100000;
+    const std::vector<std::vector<std::string>> bursts = makeBursts(epochs);
+    int errors = 0;
+
+    {
+        // Closed by the next epoch, early with the mask of every sentence, and with a mask missing VTG
+        static const struct { const char *name; int mask; bool lateVtg; } runs[] = {
+            { "complete bursts", NMEA_DEF_EPOCH_MASK, false },
+            { "complete bursts, full mask", kBurstMask, false },
+            { "complete bursts, GGA|RMC mask", GPGGA | GPRMC, true },
+        };
+        for (const auto &run : runs)
+        {
+            Assembler assembler(run.mask);
+            for (long it = 0; it < epochs; ++it)
+                for (const std::string &sentence : bursts[it])
+                    assembler.push(sentence, 0);
+            nmea_epoch_flush(&assembler.epoch);
+            assembler.pop();
+            report(run.name, assembler.epoch);
+            errors += checkFixes(run.name, assembler, epochs, 0);
+            const unsigned long late = run.lateVtg ? static_cast<unsigned long>(epochs) : 0;
+            if (assembler.epoch.partial != 0 || assembler.epoch.broken != 0 || assembler.epoch.late != late)
+                errors++;
+        }
+    }
+
+    {
+        // Second GSV of every tenth epoch is lost
+        const long every = 10;
+        Assembler assembler;
+        for (long it = 0; it < epochs; ++it)
+        {
+            int gsv = 0;
+            for (const std::string &sentence : bursts[it])
+            {
+                if (isType(sentence, "GSV") && ++gsv == 2 && it % every == every - 1)
+                    continue;
+                assembler.push(sentence, 0);
+            }
+        }
+        nmea_epoch_flush(&assembler.epoch);
+        assembler.pop();
+        report("GSV lost", assembler.epoch);
+        errors += checkFixes("GSV lost", assembler, epochs, every);
+        if (assembler.epoch.broken == 0 || assembler.epoch.partial != 0 || assembler.epoch.late != 0)
+            errors++;
+    }
+
+    {
+        // RMC of every tenth epoch arrives after the timeout, the epoch is handed over without it
+        // and the RMC is late. Epochs are 2 s apart, the others are closed by the next epoch.
+        const long every = 10;
+        Assembler assembler;
+        for (long it = 0; it < epochs; ++it)
+        {
+            const long long nowMs = it * 2000;
+            std::string delayed;
+            for (const std::string &sentence : bursts[it])
+            {
+                if (isType(sentence, "RMC") && it % every == every - 1)
+                    delayed = sentence;
+                else
+                    assembler.push(sentence, nowMs);
+            }
+            if (!delayed.empty())
+            {
+                if (nmea_epoch_poll(&assembler.epoch, nowMs + kTimeoutMs))
+                    assembler.pop();
+                assembler.push(delayed, nowMs + kTimeoutMs + 1);
+            }
+        }
+        nmea_epoch_flush(&assembler.epoch);
+        assembler.pop();
+        report("RMC past timeout", assembler.epoch);
+        errors += checkFixes("RMC past timeout", assembler, epochs, 0);
+        const unsigned long delayed = static_cast<unsigned long>(epochs / every);
+        if (assembler.epoch.timeouts != delayed || assembler.epoch.partial != delayed || assembler.epoch.late != delayed)
+            errors++;
+    }
+
+    {
+        std::string stream;
+        for (const std::vector<std::string> &burst : bursts)
+            for (const std::string &sentence : burst)
+                stream += sentence;
+
+        // Every sentence updates nmeaINFO, a consumer sees each half updated state
+        nmeaPARSER parser;
+        nmeaINFO info;
+        void *pack = NULL;
+        int ptype;
+        unsigned long long updates = 0;
+        nmea_parser_init(&parser);
+        nmea_zero_INFO(&info);
+        BenchTimer mergeTimer;
+        for (size_t done = 0; done < stream.size();)
+        {
+            done += nmea_parser_real_push(&parser, stream.data() + done, static_cast<int>(std::min<size_t>(stream.size() - done, INT_MAX)));
+            while ((ptype = nmea_parser_pop(&parser, &pack)) != GPNON)
+            {
+                nmea_pack2info(ptype, pack, &info);
+                updates++;
+            }
+        }
+        const double mergeSeconds = mergeTimer.seconds();
+        nmea_parser_destroy(&parser);
+
+        // Consumer takes the fix where it is, like the nmeaINFO one above
+        Assembler assembler;
+        const nmeaINFO *fix;
+        long fixes = 0;
+        BenchTimer epochTimer;
+        for (size_t done = 0; done < stream.size();)
+        {
+            done += nmea_parser_real_push(&assembler.parser, stream.data() + done, static_cast<int>(std::min<size_t>(stream.size() - done, INT_MAX)));
+            while ((ptype = nmea_parser_pop(&assembler.parser, &pack)) != GPNON)
+            {
+                if (!nmea_epoch_push(&assembler.epoch, ptype, pack, 0))
+                    continue;
+                while ((fix = nmea_epoch_pop(&assembler.epoch)) != NULL)
+                    fixes += (fix->smask & (GPGGA | GPRMC)) != 0;
+            }
+        }
+        nmea_epoch_flush(&assembler.epoch);
+        while ((fix = nmea_epoch_pop(&assembler.epoch)) != NULL)
+            fixes += (fix->smask & (GPGGA | GPRMC)) != 0;
+        const double epochSeconds = epochTimer.seconds();
+
+        benchReport("nmea_pack2info", static_cast<long>(updates), static_cast<long>(stream.size()), mergeSeconds);
+        benchReport("nmea_epoch_push", static_cast<long>(updates), static_cast<long>(stream.size()), epochSeconds);
+        std::printf("consumer updates: %llu nmeaINFO states, %ld epoch fixes\n", updates, fixes);
+        if (fixes != epochs)
+            errors++;
+    }
+
+    std::printf("epoch: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+// bench_event_loop.cpp
+//
+// EventLoop over thousands of local sources: socketpairs, a pseudo-terminal
+// and a regular file (not pollable) are filled with sentences and drained by
+// one thread, with read() and with io_uring multishot reads. Checks that
+// every line of every source is handed over once and that SIGTERM stops the
+// loop through its signalfd.
+
+#include "bench_common.h"
+#include "EventLoop.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+static bool writeAll(int fd, const std::string &data)
+{
+    size_t done = 0;
+    while (done < data.size())
+    {
+        ssize_t nwritten = write(fd, data.data() + done, data.size() - done);
+        if (nwritten <= 0)
+            return false;
+        done += nwritten;
+    }
+    return true;
+}
+
+// Raw pseudo-terminal, returns master and keeps slave in *slave
+static int openPty(int *slave)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+        return -1;
+    *slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    struct termios tio;
+    if (*slave < 0 || tcgetattr(*slave, &tio) != 0)
+        return -1;
+    cfmakeraw(&tio);
+    tcsetattr(*slave, TCSANOW, &tio);
+    return master;
+}
+
+int main(int argc, char *argv[])
+{
+    long sourceCount = (argc > 1) ? std::atol(argv[1]) : 2000;
+    const long linesPerSource = 20;
+    int errors = 0;
+
+    // Two descriptors per socketpair
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (static_cast<rlim_t>(sourceCount * 2 + 64) > limit.rlim_cur)
+        sourceCount = (static_cast<long>(limit.rlim_cur) - 64) / 2;
+
+    const std::string payload = benchMakeStream(linesPerSource);
+
+    // Per-line echo and fixes are not part of the measurement
+    OutputBuffer sink(open("/dev/null", O_WRONLY));
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        const bool useUring = pass == 1;
+        EventLoop loop(sink);
+        if (useUring && !loop.enableUring())
+        {
+            std::printf("io_uring not available, read() only\n");
+            break;
+        }
+        long expectedLines = 0, expectedBytes = 0;
+
+        for (long it = 0; it < sourceCount; ++it)
+        {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+            {
+                errors++;
+                break;
+            }
+            if (!writeAll(pair[1], payload) || !loop.addSource(pair[0], "socketpair"))
+                errors++;
+            close(pair[1]);
+            expectedLines += linesPerSource;
+            expectedBytes += static_cast<long>(payload.size());
+        }
+
+        // Pseudo-terminal gets the last line without line end, master hang up flushes it
+        int slave = -1;
+        int master = openPty(&slave);
+        if (master < 0 || !loop.addSource(slave, "pty"))
+            errors++;
+        const std::string ptyPayload = payload + "$GPVTG";
+        expectedLines += linesPerSource + 1;
+        expectedBytes += static_cast<long>(ptyPayload.size());
+
+        char path[] = "/tmp/bench_event_loopXXXXXX";
+        int file = mkstemp(path);
+        unlink(path);
+        if (file < 0 || !writeAll(file, payload) || lseek(file, 0, SEEK_SET) != 0 || !loop.addSource(file, "file"))
+            errors++;
+        expectedLines += linesPerSource;
+        expectedBytes += static_cast<long>(payload.size());
+
+        // Terminal is written in small pieces while the loop runs, the master is closed
+        // only after the loop took everything since hang up discards unread input
+        std::thread writer([master, slave, &ptyPayload]() {
+            for (size_t done = 0; done < ptyPayload.size(); done += 37)
+            {
+                writeAll(master, ptyPayload.substr(done, 37));
+                usleep(100);
+            }
+            int pending = 1;
+            while (ioctl(slave, FIONREAD, &pending) == 0 && pending > 0)
+                usleep(1000);
+            close(master);
+        });
+
+        BenchTimer runTimer;
+        const int signal = loop.run();
+        const double seconds = runTimer.seconds();
+        writer.join();
+
+        if (signal != 0 || loop.sourceCount() != 0 ||
+            loop.lineCount() != static_cast<unsigned long long>(expectedLines) ||
+            loop.byteCount() != static_cast<unsigned long long>(expectedBytes))
+        {
+            std::printf("event loop: signal %d, %zu sources left, %llu/%ld lines, %llu/%ld bytes\n",
+                        signal, loop.sourceCount(), loop.lineCount(), expectedLines,
+                        loop.byteCount(), expectedBytes);
+            errors++;
+        }
+
+        std::printf("%ld socketpairs + pty + file\n", sourceCount);
+        benchReport(useUring ? "EventLoop::run (io_uring)" : "EventLoop::run (read)",
+                    static_cast<long>(loop.lineCount()), static_cast<long>(loop.byteCount()), seconds);
+    }
+
+    // Idle source, pending SIGTERM has to stop the loop
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        EventLoop loop(sink);
+        if (pass == 1 && !loop.enableUring())
+            break;
+        int pair[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, pair);
+        loop.addSource(pair[0], "idle");
+        raise(SIGTERM);
+        const int signal = loop.run();
+        close(pair[1]);
+        if (signal != SIGTERM)
+        {
+            std::printf("signalfd%s: loop returned %d instead of SIGTERM\n", pass ? " (io_uring)" : "", signal);
+            errors++;
+        }
+    }
+
+    std::printf("event loop: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+// bench_fix_record.cpp
+//
+// Downstream ingest of fixes: text reports ("lat: ... lon: ... alt: ...")
+// parsed back with strtod against binary FixRecords read through
+// FixRecordReader, over a pipe, a UNIX socket and a file. Reports consumer
+// CPU time per fix and stream size, and checks that every record arrives
+// unchanged. A slow reader of a small non-blocking pipe must receive whole
+// records in order, only some of them missing, and the writer must count
+// exactly the records the reader got as written and the rest as dropped.
+
+#include "bench_common.h"
+#include "FixRecordReader.h"
+#include "FixRecordWriter.h"
+#include "LocationService.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static double threadCpuSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Fixes of a moving receiver as LocationService reports them
+static std::vector<LocationFix> makeFixes(long epochs)
+{
+    nmeaINFO info;
+    nmea_zero_INFO(&info);
+    nmeaGENERATOR *gen = nmea_create_generator(NMEA_GEN_POS_RANDMOVE, &info);
+    std::vector<LocationFix> fixes;
+    LocationService service;
+    service.setFixHandler([&](const LocationFix &fix) { fixes.push_back(fix); });
+    char buff[2048];
+    for (long it = 0; it < epochs; ++it)
+    {
+        info.utc.hsec = static_cast<int>(it % 100);
+        const int size = nmea_generate_from(buff, sizeof(buff), &info, gen, GPGGA | GPRMC);
+        service.parseNMEAMessage(buff, size);
+    }
+    nmea_destroy_generator(gen);
+    return fixes;
+}
+
+static bool sameRecord(const FixRecord &a, const FixRecord &b)
+{
+    return memcmp(&a, &b, sizeof(FixRecord)) == 0;
+}
+
+// Text reports through a pipe, consumer parses every line back
+static int runText(const std::vector<LocationFix> &fixes)
+{
+    int fds[2];
+    if (pipe(fds) < 0)
+        return 1;
+
+    size_t bytes = 0;
+    std::thread producer([&]() {
+        OutputBuffer output(fds[1]);
+        char report[128];
+        for (const LocationFix &fix : fixes)
+        {
+            const size_t size = LocationService::formatFix(fix, report, sizeof(report));
+            output.append(report, size);
+            bytes += size;
+        }
+        output.flush();
+        close(fds[1]);
+    });
+
+    const double cpu = threadCpuSeconds();
+    BenchTimer timer;
+    std::vector<char> buffer(64 * 1024);
+    size_t used = 0, parsed = 0, mismatches = 0;
+    ssize_t nread;
+    while ((nread = read(fds[0], buffer.data() + used, buffer.size() - used)) > 0)
+    {
+        used += nread;
+        char *begin = buffer.data();
+        char *end = buffer.data() + used;
+        char *eol;
+        while ((eol = static_cast<char *>(memchr(begin, '\n', end - begin))) != NULL)
+        {
+            *eol = '\0';
+            char *field = begin + 5;
+            const double lat = strtod(field, &field);
+            const double lon = strtod(field + 6, &field);
+            const double elv = strtod(field + 6, &field);
+            // %g keeps 6 significant digits
+            const LocationFix &fix = fixes[parsed++];
+            if (std::fabs(lat - fix.lat) > 1e-3 || std::fabs(lon - fix.lon) > 1e-3 ||
+                std::fabs(elv - fix.elv) > 1e-3 * std::fabs(fix.elv) + 1e-6)
+                mismatches++;
+            begin = eol + 1;
+        }
+        used = end - begin;
+        memmove(buffer.data(), begin, used);
+    }
+    const double cpuSeconds = threadCpuSeconds() - cpu;
+    const double seconds = timer.seconds();
+    producer.join();
+    close(fds[0]);
+
+    std::printf("%-24s %8zu fixes %10zu bytes %8.3f s   consumer %7.1f ns/fix\n",
+                "text over pipe", parsed, bytes, seconds, cpuSeconds * 1e9 / parsed);
+    return (parsed == fixes.size() && mismatches == 0) ? 0 : 1;
+}
+
+// Binary records from writer to reader, a file is read once the writer is done
+static int runBinary(const char *name, int readFd, int writeFd, const std::vector<LocationFix> &fixes,
+                     const std::vector<FixRecord> &expected, bool afterWriter = false)
+{
+    unsigned long long writes = 0;
+    std::thread producer([&]() {
+        FixRecordWriter writer(writeFd);
+        for (size_t it = 0; it < fixes.size(); ++it)
+        {
+            // Most fixes one by one, some arrays are handed over without copying
+            if (it % 1000 == 0 && it + 100 <= fixes.size())
+            {
+                writer.write(&expected[it], 100);
+                it += 99;
+                continue;
+            }
+            writer.append(fixes[it]);
+        }
+        writer.flush();
+        writes = writer.writeCount();
+        close(writeFd);
+    });
+    if (afterWriter)
+        producer.join();
+
+    const double cpu = threadCpuSeconds();
+    BenchTimer timer;
+    FixRecordReader reader(readFd);
+    std::vector<FixRecord> records(512);
+    size_t received = 0, mismatches = 0;
+    ssize_t count;
+    while ((count = reader.read(records.data(), records.size())) > 0)
+    {
+        for (ssize_t it = 0; it < count; ++it)
+        {
+            if (received >= expected.size() || !sameRecord(records[it], expected[received]))
+                mismatches++;
+            received++;
+        }
+    }
+    const double cpuSeconds = threadCpuSeconds() - cpu;
+    const double seconds = timer.seconds();
+    if (!afterWriter)
+        producer.join();
+    close(readFd);
+
+    std::printf("%-24s %8zu fixes %10zu bytes %8.3f s   consumer %7.1f ns/fix   %llu writev\n",
+                name, received, sizeof(FixStreamHeader) + received * sizeof(FixRecord), seconds,
+                cpuSeconds * 1e9 / (received ? received : 1), writes);
+    return (count == 0 && received == expected.size() && mismatches == 0) ? 0 : 1;
+}
+
+// Non-blocking writer ahead of a slow reader: dropped records leave no cut record behind
+static int runDropping(const std::vector<LocationFix> &fixes, const std::vector<FixRecord> &expected)
+{
+    int fds[2];
+    if (pipe(fds) < 0)
+        return 1;
+    fcntl(fds[1], F_SETPIPE_SZ, 4096);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+    bool broken = false;
+    unsigned long long written = 0, dropped = 0;
+    std::thread producer([&]() {
+        FixRecordWriter writer(fds[1]);
+        for (const LocationFix &fix : fixes)
+            writer.append(fix);
+        writer.flush();
+        broken = writer.isBroken();
+        written = writer.recordCount();
+        dropped = writer.droppedCount();
+        close(fds[1]);
+    });
+
+    FixRecordReader reader(fds[0]);
+    std::vector<FixRecord> records(64);
+    size_t received = 0, next = 0, misplaced = 0;
+    ssize_t count;
+    while ((count = reader.read(records.data(), records.size())) > 0)
+    {
+        for (ssize_t it = 0; it < count; ++it, ++received)
+        {
+            while (next < expected.size() && !sameRecord(records[it], expected[next]))
+                next++;
+            if (next == expected.size())
+                misplaced++;
+            else
+                next++;
+        }
+        usleep(100);
+    }
+    producer.join();
+    close(fds[0]);
+
+    std::printf("%-24s %8zu fixes of %zu, %llu dropped, %zu misplaced%s\n", "binary, slow reader", received,
+                expected.size(), dropped, misplaced, broken ? ", stream broken" : "");
+    if (written != received || written + dropped != expected.size())
+        std::printf("writer counted %llu written and %llu dropped, reader got %zu\n", written, dropped, received);
+    return (count == 0 && received > 0 && misplaced == 0 && !broken && written == received &&
+            written + dropped == expected.size()) ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    const long epochs = (argc > 1) ? std::atol(argv[1]) : 500000;
+    const std::vector<LocationFix> fixes = makeFixes(epochs);
+    std::vector<FixRecord> expected;
+    int errors = 0;
+
+    for (const LocationFix &fix : fixes)
+    {
+        expected.push_back(FixRecord::fromFix(fix));
+        const LocationFix back = expected.back().toFix();
+        if (std::fabs(back.lat - fix.lat) > 0.5e-6 || std::fabs(back.lon - fix.lon) > 0.5e-6 ||
+            back.utcUs != fix.utcUs || back.satinuse != fix.satinuse || back.fix != fix.fix)
+            errors++;
+    }
+    if (errors)
+        std::printf("%d fixes do not survive FixRecord round trip\n", errors);
+
+    errors += runText(fixes);
+
+    int fds[2];
+    if (pipe(fds) == 0)
+        errors += runBinary("binary over pipe", fds[0], fds[1], fixes, expected);
+    else
+        errors++;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0)
+        errors += runBinary("binary over UNIX socket", fds[0], fds[1], fixes, expected);
+    else
+        errors++;
+
+    char path[] = "/tmp/bench_fix_record.XXXXXX";
+    const int writeFd = mkstemp(path);
+    const int readFd = writeFd >= 0 ? open(path, O_RDONLY) : -1;
+    if (readFd >= 0)
+    {
+        unlink(path);
+        errors += runBinary("binary to file", readFd, writeFd, fixes, expected, true);
+    }
+    else
+    {
+        errors++;
+    }
+
+    errors += runDropping(fixes, expected);
+
+    std::printf("fix_record: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// bench_framing.cpp
+//
+// Differential fuzz of nmea_find_tail / nmea_calc_crc on every available
+// instruction set against the original byte by byte implementation,
+// followed by framing throughput of a long recorded-like stream.
+
+#include "bench_common.h"
+#include "nmea.h"
+#include "tok.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Original implementation of nmea_find_tail
+static int referenceFindTail(const char *buff, int buff_sz, int *res_crc)
+{
+    static const int tail_sz = 3 /* *[CRC] */ + 2 /* \r\n */;
+
+    const char *end_buff = buff + buff_sz;
+    int nread = 0;
+    int crc = 0;
+
+    *res_crc = -1;
+
+    for (; buff < end_buff; ++buff, ++nread)
+    {
+        if (('$' == *buff) && nread)
+        {
+            buff = 0;
+            break;
+        }
+        else if ('*' == *buff)
+        {
+            if (buff + tail_sz <= end_buff && '\r' == buff[3] && '\n' == buff[4])
+            {
+                *res_crc = nmea_atoi(buff + 1, 2, 16);
+                nread = buff_sz - (int)(end_buff - (buff + tail_sz));
+                if (*res_crc != crc)
+                {
+                    *res_crc = -1;
+                    buff = 0;
+                }
+            }
+
+            break;
+        }
+        else if (nread)
+            crc ^= (int)*buff;
+    }
+
+    if (*res_crc < 0 && buff)
+        nread = 0;
+
+    return nread;
+}
+
+// Original implementation of nmea_calc_crc
+static int referenceCalcCrc(const char *buff, int buff_sz)
+{
+    int chsum = 0;
+    for (int it = 0; it < buff_sz; ++it)
+        chsum ^= (int)buff[it];
+    return chsum;
+}
+
+static unsigned int rngState = 88172645u;
+
+static unsigned int nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static std::string randomBuffer()
+{
+    static const char alphabet[] = "$*\r\n,.0123456789ABCDEFGPabcdef\x80\xff";
+    std::string res;
+
+    if (nextRandom() % 2)
+    {
+        // valid sentences with noise around
+        const int count = 1 + nextRandom() % 4;
+        for (int it = 0; it < count; ++it)
+            res += benchSentences[nextRandom() % benchSentenceCount];
+    }
+
+    const int noise = nextRandom() % 96;
+    for (int it = 0; it < noise; ++it)
+    {
+        const size_t pos = nextRandom() % (res.size() + 1);
+        if (nextRandom() % 3 == 0)
+            res.insert(pos, 1, static_cast<char>(nextRandom() & 0xff));
+        else
+            res.insert(pos, 1, alphabet[nextRandom() % (sizeof(alphabet) - 1)]);
+    }
+
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *const levelNames[] = { "scalar", "sse2", "avx2" };
+    const long iterations = (argc > 1) ? std::atol(argv[1]) : 200000;
+    const int bestLevel = nmea_simd_level();
+    long mismatches = 0;
+
+    for (long it = 0; it < iterations; ++it)
+    {
+        const std::string buff = randomBuffer();
+        const int size = static_cast<int>(buff.size());
+        const int offset = size ? static_cast<int>(nextRandom() % size) : 0;
+        int refCrc = 0;
+        const int refRead = referenceFindTail(buff.data() + offset, size - offset, &refCrc);
+        const int refSum = referenceCalcCrc(buff.data() + offset, size - offset);
+
+        for (int level = NMEA_SIMD_NONE; level <= bestLevel; ++level)
+        {
+            nmea_simd_select(level);
+            int crc = 0;
+            const int read = nmea_find_tail(buff.data() + offset, size - offset, &crc);
+            const int sum = nmea_calc_crc(buff.data() + offset, size - offset);
+            if (read != refRead || crc != refCrc || sum != refSum)
+            {
+                if (++mismatches <= 10)
+                    std::printf("mismatch on %s: read %d/%d crc %d/%d sum %d/%d\n",
+                                levelNames[level], read, refRead, crc, refCrc, sum, refSum);
+            }
+        }
+    }
+
+    std::printf("differential: %ld buffers, levels up to %s, %ld mismatches\n",
+                iterations, levelNames[bestLevel], mismatches);
+
+    // Framing throughput: walk a long stream sentence by sentence
+    const std::string stream = benchMakeStream(2000000);
+    const int size = static_cast<int>(stream.size());
+
+    for (int level = NMEA_SIMD_NONE; level <= bestLevel; ++level)
+    {
+        nmea_simd_select(level);
+        long sentences = 0;
+        int crc, nread;
+        BenchTimer timer;
+        for (int off = 0; off < size && 0 != (nread = nmea_find_tail(stream.data() + off, size - off, &crc)); off += nread)
+            sentences += (crc >= 0);
+        std::string name = std::string("nmea_find_tail (") + levelNames[level] + ")";
+        benchReport(name.c_str(), sentences, size, timer.seconds());
+    }
+
+    nmea_simd_select(bestLevel);
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,335 @@
+// bench_generate.cpp
+//
+// Differential check of the nmea_gen_GPxxx encoders against the nmea_printf
+// formats they replaced: random and edge packets (rounding ties, values one
+// ulp around them, negative zero, huge, infinite and NaN numbers, NUL and
+// non-ASCII characters) must give the same bytes and size for every buffer
+// size up to the sentence length. Reports sentences/s of both.
+
+#include "bench_common.h"
+#include "nmea.h"
+#include "tok.h"
+
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+// The encoders as they were, through vsnprintf
+static int refGPGGA(char *buff, int buff_sz, nmeaGPGGA *pack)
+{
+    return nmea_printf(buff, buff_sz,
+        "$GPGGA,%02d%02d%02d.%02d,%07.4f,%C,%07.4f,%C,%1d,%02d,%03.1f,%03.1f,%C,%03.1f,%C,%03.1f,%04d",
+        pack->utc.hour, pack->utc.min, pack->utc.sec, pack->utc.hsec,
+        pack->lat, pack->ns, pack->lon, pack->ew,
+        pack->sig, pack->satinuse, pack->HDOP, pack->elv, pack->elv_units,
+        pack->diff, pack->diff_units, pack->dgps_age, pack->dgps_sid);
+}
+
+static int refGPGSA(char *buff, int buff_sz, nmeaGPGSA *pack)
+{
+    return nmea_printf(buff, buff_sz,
+        "$GPGSA,%C,%1d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%03.1f,%03.1f,%03.1f",
+        pack->fix_mode, pack->fix_type,
+        pack->sat_prn[0], pack->sat_prn[1], pack->sat_prn[2], pack->sat_prn[3], pack->sat_prn[4], pack->sat_prn[5],
+        pack->sat_prn[6], pack->sat_prn[7], pack->sat_prn[8], pack->sat_prn[9], pack->sat_prn[10], pack->sat_prn[11],
+        pack->PDOP, pack->HDOP, pack->VDOP);
+}
+
+static int refGPGSV(char *buff, int buff_sz, nmeaGPGSV *pack)
+{
+    return nmea_printf(buff, buff_sz,
+        "$GPGSV,%1d,%1d,%02d,"
+        "%02d,%02d,%03d,%02d,"
+        "%02d,%02d,%03d,%02d,"
+        "%02d,%02d,%03d,%02d,"
+        "%02d,%02d,%03d,%02d",
+        pack->pack_count, pack->pack_index + 1, pack->sat_count,
+        pack->sat_data[0].id, pack->sat_data[0].elv, pack->sat_data[0].azimuth, pack->sat_data[0].sig,
+        pack->sat_data[1].id, pack->sat_data[1].elv, pack->sat_data[1].azimuth, pack->sat_data[1].sig,
+        pack->sat_data[2].id, pack->sat_data[2].elv, pack->sat_data[2].azimuth, pack->sat_data[2].sig,
+        pack->sat_data[3].id, pack->sat_data[3].elv, pack->sat_data[3].azimuth, pack->sat_data[3].sig);
+}
+
+static int refGPRMC(char *buff, int buff_sz, nmeaGPRMC *pack)
+{
+    return nmea_printf(buff, buff_sz,
+        "$GPRMC,%02d%02d%02d.%02d,%C,%07.4f,%C,%07.4f,%C,%03.1f,%03.1f,%02d%02d%02d,%03.1f,%C,%C",
+        pack->utc.hour, pack->utc.min, pack->utc.sec, pack->utc.hsec,
+        pack->status, pack->lat, pack->ns, pack->lon, pack->ew,
+        pack->speed, pack->direction,
+        pack->utc.day, pack->utc.mon + 1, pack->utc.year - 100,
+        pack->declination, pack->declin_ew, pack->mode);
+}
+
+static int refGPVTG(char *buff, int buff_sz, nmeaGPVTG *pack)
+{
+    return nmea_printf(buff, buff_sz,
+        "$GPVTG,%.1f,%C,%.1f,%C,%.1f,%C,%.1f,%C",
+        pack->dir, pack->dir_t,
+        pack->dec, pack->dec_m,
+        pack->spn, pack->spn_n,
+        pack->spk, pack->spk_k);
+}
+
+class Random
+{
+public:
+    explicit Random(unsigned seed) : engine(seed) {}
+
+    int below(int n) { return static_cast<int>(engine() % static_cast<unsigned>(n)); }
+
+    // Mostly receiver-like values, sometimes rounding ties, their neighbours and special values
+    double real(double range, int prec)
+    {
+        static const double scales[] = { 1.0, 10.0, 100.0, 1000.0, 10000.0 };
+        const double value = std::uniform_real_distribution<double>(-range, range)(engine);
+        switch (below(16))
+        {
+        case 0:
+            return (std::floor(value * scales[prec]) + 0.5) / scales[prec];
+        case 1:
+            return std::nextafter((std::floor(value * scales[prec]) + 0.5) / scales[prec], 1e300);
+        case 2:
+            return std::nextafter((std::floor(value * scales[prec]) + 0.5) / scales[prec], -1e300);
+        case 3:
+            return (std::floor(value) + 0.5) / 4.0; // exact ties of %.1f
+        case 4:
+        {
+            static const double specials[] = { 0.0, -0.0, 1e15, -1e16, 1e300, -1e300, 5e-324, 0.05, 0.95, 9.95, 99.95,
+                                               std::numeric_limits<double>::infinity(),
+                                               -std::numeric_limits<double>::infinity(),
+                                               std::numeric_limits<double>::quiet_NaN() };
+            return specials[below(sizeof(specials) / sizeof(specials[0]))];
+        }
+        default:
+            return value;
+        }
+    }
+
+    int integer(int range)
+    {
+        switch (below(32))
+        {
+        case 0:
+            return INT_MIN;
+        case 1:
+            return INT_MAX;
+        case 2:
+            return -below(range);
+        default:
+            return below(range);
+        }
+    }
+
+    char character(const char *usual)
+    {
+        switch (below(64))
+        {
+        case 0:
+            return 0;
+        case 1:
+            return static_cast<char>(0xb0);
+        default:
+            return usual[below(static_cast<int>(std::strlen(usual)))];
+        }
+    }
+
+    void time(nmeaTIME &utc)
+    {
+        utc.year = 100 + integer(100);
+        utc.mon = integer(12);
+        utc.day = 1 + integer(31);
+        utc.hour = integer(24);
+        utc.min = integer(60);
+        utc.sec = integer(60);
+        utc.hsec = integer(100);
+    }
+
+private:
+    std::mt19937 engine;
+};
+
+static void randomGGA(Random &random, nmeaGPGGA &pack)
+{
+    nmea_zero_GPGGA(&pack);
+    random.time(pack.utc);
+    pack.lat = random.real(9000.0, 4);
+    pack.ns = random.character("NS");
+    pack.lon = random.real(18000.0, 4);
+    pack.ew = random.character("EW");
+    pack.sig = random.integer(4);
+    pack.satinuse = random.integer(40);
+    pack.HDOP = random.real(50.0, 1);
+    pack.elv = random.real(9000.0, 1);
+    pack.elv_units = random.character("M");
+    pack.diff = random.real(100.0, 1);
+    pack.diff_units = random.character("M");
+    pack.dgps_age = random.real(100.0, 1);
+    pack.dgps_sid = random.integer(1024);
+}
+
+static void randomGSA(Random &random, nmeaGPGSA &pack)
+{
+    nmea_zero_GPGSA(&pack);
+    pack.fix_mode = random.character("AM");
+    pack.fix_type = random.integer(4);
+    for (int it = 0; it < NMEA_PRNINPACK; ++it)
+        pack.sat_prn[it] = random.integer(200);
+    pack.PDOP = random.real(50.0, 1);
+    pack.HDOP = random.real(50.0, 1);
+    pack.VDOP = random.real(50.0, 1);
+}
+
+static void randomGSV(Random &random, nmeaGPGSV &pack)
+{
+    nmea_zero_GPGSV(&pack);
+    pack.pack_count = random.integer(10);
+    pack.pack_index = random.integer(10);
+    pack.sat_count = random.integer(64);
+    for (int it = 0; it < NMEA_SATINPACK; ++it)
+    {
+        pack.sat_data[it].id = random.integer(200);
+        pack.sat_data[it].elv = random.integer(91);
+        pack.sat_data[it].azimuth = random.integer(360);
+        pack.sat_data[it].sig = random.integer(100);
+    }
+}
+
+static void randomRMC(Random &random, nmeaGPRMC &pack)
+{
+    nmea_zero_GPRMC(&pack);
+    random.time(pack.utc);
+    pack.status = random.character("AV");
+    pack.lat = random.real(9000.0, 4);
+    pack.ns = random.character("NS");
+    pack.lon = random.real(18000.0, 4);
+    pack.ew = random.character("EW");
+    pack.speed = random.real(1000.0, 1);
+    pack.direction = random.real(360.0, 1);
+    pack.declination = random.real(180.0, 1);
+    pack.declin_ew = random.character("EW");
+    pack.mode = random.character("ADEN");
+}
+
+static void randomVTG(Random &random, nmeaGPVTG &pack)
+{
+    nmea_zero_GPVTG(&pack);
+    pack.dir = random.real(360.0, 1);
+    pack.dir_t = random.character("T");
+    pack.dec = random.real(360.0, 1);
+    pack.dec_m = random.character("M");
+    pack.spn = random.real(1000.0, 1);
+    pack.spn_n = random.character("N");
+    pack.spk = random.real(2000.0, 1);
+    pack.spk_k = random.character("K");
+}
+
+// Both encoders must write the same bytes of the buffer and return the same size for every buffer size
+template <typename Pack>
+static int compare(const char *name, Pack &pack, int (*encode)(char *, int, Pack *), int (*reference)(char *, int, Pack *))
+{
+    // nmea_printf writes past buffers too small for the sentence body, so its buffer has room to spare
+    static char expected[2048], actual[2048];
+    std::memset(expected, '#', sizeof(expected));
+    const int full = reference(expected, 1024, &pack);
+    const int sizes[] = { 0, 1, 2, full / 2, full - 6, full - 5, full - 4, full - 1, full, full + 1, full + 2, 1024 };
+
+    for (int size : sizes)
+    {
+        if (size < 0)
+            continue;
+        Pack copy = pack;
+        std::memset(expected, '#', sizeof(expected));
+        std::memset(actual, '#', sizeof(actual));
+        const int expectedSize = reference(expected, size, &pack);
+        const int actualSize = encode(actual, size, &copy);
+        if (expectedSize != actualSize || std::memcmp(expected, actual, static_cast<size_t>(size)) != 0)
+        {
+            std::printf("%s differs in buffer of %d bytes (size %d, expected %d)\n  expected: %.*s\n  actual:   %.*s\n",
+                        name, size, actualSize, expectedSize, size < 200 ? size : 200, expected, size < 200 ? size : 200, actual);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+template <typename Pack>
+static double timeEncoder(std::vector<Pack> &packs, int (*encode)(char *, int, Pack *), long &bytes)
+{
+    char buff[256];
+    bytes = 0;
+    BenchTimer timer;
+    for (Pack &pack : packs)
+        bytes += encode(buff, sizeof(buff), &pack);
+    return timer.seconds();
+}
+
+int main(int argc, char *argv[])
+{
+    const long samples = (argc > 1) ? std::atol(argv[1]) : 200000;
+    Random random(20080311);
+    int errors = 0;
+
+    for (long it = 0; it < samples && errors < 10; ++it)
+    {
+        nmeaGPGGA gga;
+        nmeaGPGSA gsa;
+        nmeaGPGSV gsv;
+        nmeaGPRMC rmc;
+        nmeaGPVTG vtg;
+        randomGGA(random, gga);
+        randomGSA(random, gsa);
+        randomGSV(random, gsv);
+        randomRMC(random, rmc);
+        randomVTG(random, vtg);
+        errors += compare("GPGGA", gga, &nmea_gen_GPGGA, &refGPGGA);
+        errors += compare("GPGSA", gsa, &nmea_gen_GPGSA, &refGPGSA);
+        errors += compare("GPGSV", gsv, &nmea_gen_GPGSV, &refGPGSV);
+        errors += compare("GPRMC", rmc, &nmea_gen_GPRMC, &refGPRMC);
+        errors += compare("GPVTG", vtg, &nmea_gen_GPVTG, &refGPVTG);
+    }
+    std::printf("differential: %ld packets of every type, every buffer size around the sentence\n", samples);
+
+    // Throughput on receiver-like packets, the bursts nmea_generate writes
+    nmeaINFO info;
+    nmea_zero_INFO(&info);
+    std::vector<nmeaGPGGA> ggas(samples);
+    std::vector<nmeaGPRMC> rmcs(samples);
+    std::vector<nmeaGPGSV> gsvs(samples);
+    std::mt19937 engine(1);
+    std::uniform_real_distribution<double> lat(-9000.0, 9000.0), lon(-18000.0, 18000.0), small(0.0, 500.0);
+    for (long it = 0; it < samples; ++it)
+    {
+        info.lat = lat(engine);
+        info.lon = lon(engine);
+        info.elv = small(engine);
+        info.speed = small(engine);
+        info.direction = small(engine);
+        info.sig = NMEA_SIG_MID;
+        info.satinfo.inview = 12;
+        nmea_info2GPGGA(&info, &ggas[it]);
+        nmea_info2GPRMC(&info, &rmcs[it]);
+        nmea_info2GPGSV(&info, &gsvs[it], static_cast<int>(it % 3));
+    }
+
+    long bytes = 0;
+    double seconds = timeEncoder(ggas, &refGPGGA, bytes);
+    benchReport("GPGGA nmea_printf", samples, bytes, seconds);
+    seconds = timeEncoder(ggas, &nmea_gen_GPGGA, bytes);
+    benchReport("GPGGA nmea_gen_GPGGA", samples, bytes, seconds);
+    seconds = timeEncoder(rmcs, &refGPRMC, bytes);
+    benchReport("GPRMC nmea_printf", samples, bytes, seconds);
+    seconds = timeEncoder(rmcs, &nmea_gen_GPRMC, bytes);
+    benchReport("GPRMC nmea_gen_GPRMC", samples, bytes, seconds);
+    seconds = timeEncoder(gsvs, &refGPGSV, bytes);
+    benchReport("GPGSV nmea_printf", samples, bytes, seconds);
+    seconds = timeEncoder(gsvs, &nmea_gen_GPGSV, bytes);
+    benchReport("GPGSV nmea_gen_GPGSV", samples, bytes, seconds);
+
+    std::printf("generate: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// bench_output.cpp
+//
+// Per-line echo and fix report through std::cout with std::endl (a flush per
+// line) against the batched OutputBuffer, for the same text. Both outputs are
+// written to files and compared byte by byte, then timed on /dev/null.
+
+#include "bench_common.h"
+#include "OutputBuffer.h"
+#include "nmea.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+struct Report
+{
+    std::string line;
+    double lat;
+    double lon;
+    double elv;
+};
+
+static void writeEndl(std::ostream &out, const std::vector<Report> &reports)
+{
+    for (const Report &report : reports)
+    {
+        out << "Receive user input: " << report.line << std::endl;
+        out << "lat: " << report.lat << " lon: " << report.lon << " alt: " << report.elv << std::endl;
+    }
+}
+
+static void writeBuffered(OutputBuffer &out, const std::vector<Report> &reports)
+{
+    char text[128];
+    for (const Report &report : reports)
+    {
+        out.append("Receive user input: ");
+        out.append(report.line);
+        out.append("\n");
+        int size = std::snprintf(text, sizeof(text), "lat: %g lon: %g alt: %g\n", report.lat, report.lon, report.elv);
+        out.append(text, size);
+    }
+    out.flush();
+}
+
+static std::string readFile(const char *path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+int main(int argc, char *argv[])
+{
+    const long count = (argc > 1) ? std::atol(argv[1]) : 200000;
+
+    std::vector<Report> reports;
+    for (long it = 0; it < count; ++it)
+    {
+        std::string line = benchSentences[it % benchSentenceCount];
+        line.resize(line.size() - 2);
+        reports.push_back({ line, 50.0 + it * 1e-5, 36.2177 - it * 1e-5, 10.2 + it % 100 });
+    }
+
+    // Same text from both paths
+    char endlPath[] = "/tmp/bench_output_endlXXXXXX";
+    char bufferedPath[] = "/tmp/bench_output_bufferedXXXXXX";
+    close(mkstemp(endlPath));
+    {
+        std::ofstream out(endlPath, std::ios::binary);
+        writeEndl(out, reports);
+    }
+    {
+        OutputBuffer out(mkstemp(bufferedPath));
+        writeBuffered(out, reports);
+    }
+    const bool same = readFile(endlPath) == readFile(bufferedPath);
+    unlink(endlPath);
+    unlink(bufferedPath);
+
+    long bytes = 0;
+    for (const Report &report : reports)
+        bytes += static_cast<long>(report.line.size());
+
+    // std::cout on /dev/null flushes to the descriptor on every std::endl
+    const int savedStdout = dup(STDOUT_FILENO);
+    const int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDOUT_FILENO);
+    BenchTimer endlTimer;
+    writeEndl(std::cout, reports);
+    const double endlSeconds = endlTimer.seconds();
+    dup2(savedStdout, STDOUT_FILENO);
+
+    OutputBuffer buffered(devNull);
+    BenchTimer bufferedTimer;
+    writeBuffered(buffered, reports);
+    const double bufferedSeconds = bufferedTimer.seconds();
+
+    benchReport("std::cout + std::endl", count, bytes, endlSeconds);
+    benchReport("OutputBuffer", count, bytes, bufferedSeconds);
+    std::printf("writes: %ld with std::endl, %llu batched\n", count * 2, buffered.writeCount());
+
+    if (!same)
+        std::printf("buffered output differs from std::endl output\n");
+    return same ? 0 : 1;
+}
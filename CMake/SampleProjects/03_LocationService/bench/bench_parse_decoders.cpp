@@ -0,0 +1,233 @@
+// bench_parse_decoders.cpp
+//
+// Differential check and throughput of the table driven sentence decoders
+// (nmea_parse_GPxxx) against the nmea_scanf reference decoders (nmea_scanf_GPxxx).
+// Micro-degree fields are decoded from text by the table decoders and from
+// the parsed double by the reference ones, so they may differ by one on ties.
+// Reference decoders know GP talker only, so sentences of other registered
+// talkers are checked against them with talker rewritten to GP.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+struct Decoder
+{
+    const char *name;
+    size_t packSize;
+    int (*fast)(const char *, int, void *);
+    int (*reference)(const char *, int, void *);
+    size_t udegOffsets[2];
+    size_t talkerOffset;
+};
+
+#define BENCH_DECODER(type) \
+    { #type, sizeof(nmea##type), \
+      reinterpret_cast<int (*)(const char *, int, void *)>(&nmea_parse_##type), \
+      reinterpret_cast<int (*)(const char *, int, void *)>(&nmea_scanf_##type), { 0, 0 }, 0 }
+
+#define BENCH_DECODER_TALKER(type) \
+    { #type, sizeof(nmea##type), \
+      reinterpret_cast<int (*)(const char *, int, void *)>(&nmea_parse_##type), \
+      reinterpret_cast<int (*)(const char *, int, void *)>(&nmea_scanf_##type), { 0, 0 }, \
+      offsetof(nmea##type, talker) }
+
+#define BENCH_DECODER_UDEG(type) \
+    { #type, sizeof(nmea##type), \
+      reinterpret_cast<int (*)(const char *, int, void *)>(&nmea_parse_##type), \
+      reinterpret_cast<int (*)(const char *, int, void *)>(&nmea_scanf_##type), \
+      { offsetof(nmea##type, lat_udeg), offsetof(nmea##type, lon_udeg) }, 0 }
+
+static const Decoder decoders[] = {
+    BENCH_DECODER_UDEG(GPGGA),
+    BENCH_DECODER_TALKER(GPGSA),
+    BENCH_DECODER_TALKER(GPGSV),
+    BENCH_DECODER_UDEG(GPRMC),
+    BENCH_DECODER(GPVTG)
+};
+
+// Accept micro-degrees of reference pack which differ from decoded text by rounding only
+static void alignUdeg(const Decoder &decoder, const unsigned char *fastPack, unsigned char *refPack)
+{
+    for (size_t offset : decoder.udegOffsets)
+    {
+        int fastUdeg, refUdeg;
+        if (!offset)
+            continue;
+        std::memcpy(&fastUdeg, fastPack + offset, sizeof(int));
+        std::memcpy(&refUdeg, refPack + offset, sizeof(int));
+        if (std::abs(fastUdeg - refUdeg) <= 1)
+            std::memcpy(refPack + offset, &fastUdeg, sizeof(int));
+    }
+}
+
+// Talker of decoded sentence is reported by table decoders only
+static void alignTalker(const Decoder &decoder, const std::string &sentence, int refRes, unsigned char *refPack)
+{
+    if (!decoder.talkerOffset || !refRes)
+        return;
+    const int talker = nmea_talker_type(sentence.data() + 1, static_cast<int>(sentence.size()) - 1);
+    std::memcpy(refPack + decoder.talkerOffset, &talker, sizeof(int));
+}
+
+// Sentence of registered talker as the GP reference decoders expect it
+static std::string asGPTalker(const std::string &sentence)
+{
+    std::string res = sentence;
+    if (res.size() > 2 && nmea_talker_type(res.data() + 1, static_cast<int>(res.size()) - 1) >= 0)
+        res.replace(1, 2, "GP");
+    return res;
+}
+
+static unsigned int rngState = 2463534242u;
+
+static unsigned int nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// Split nmea_generate output into single sentences
+static void appendSentences(std::vector<std::string> &corpus, const char *buff, int size)
+{
+    const char *end = buff + size;
+    while (buff < end)
+    {
+        const char *tail = static_cast<const char *>(std::memchr(buff, '\n', end - buff));
+        tail = tail ? tail + 1 : end;
+        corpus.push_back(std::string(buff, tail));
+        buff = tail;
+    }
+}
+
+static std::string mutate(const std::string &sentence)
+{
+    static const char alphabet[] = ",*.-+0123456789eEAZNSx \r\n$";
+    std::string res = sentence;
+    const size_t pos = nextRandom() % (res.size() + 1);
+
+    switch (nextRandom() % 4)
+    {
+    case 0:
+        res.resize(pos);
+        break;
+    case 1:
+        if (pos < res.size())
+            res[pos] = alphabet[nextRandom() % (sizeof(alphabet) - 1)];
+        break;
+    case 2:
+        res.insert(pos, 1, alphabet[nextRandom() % (sizeof(alphabet) - 1)]);
+        break;
+    default:
+        if (pos < res.size())
+            res.erase(pos, 1 + nextRandom() % 8);
+        break;
+    }
+
+    return res;
+}
+
+static long compareDecoders(const std::vector<std::string> &corpus)
+{
+    std::vector<unsigned char> fastPack(512), refPack(512);
+    long mismatches = 0;
+
+    for (size_t it = 0; it < corpus.size(); ++it)
+    {
+        const std::string &sentence = corpus[it];
+        const std::string refSentence = asGPTalker(sentence);
+        for (const Decoder &decoder : decoders)
+        {
+            const int fastRes = decoder.fast(sentence.data(), static_cast<int>(sentence.size()), fastPack.data());
+            const int refRes = decoder.reference(refSentence.data(), static_cast<int>(refSentence.size()), refPack.data());
+            alignUdeg(decoder, fastPack.data(), refPack.data());
+            alignTalker(decoder, sentence, refRes, refPack.data());
+            if (fastRes != refRes || 0 != std::memcmp(fastPack.data(), refPack.data(), decoder.packSize))
+            {
+                if (++mismatches <= 10)
+                    std::printf("mismatch %s: %s", decoder.name, sentence.c_str());
+            }
+        }
+    }
+
+    return mismatches;
+}
+
+static double timeDecoder(const std::vector<std::string> &corpus, bool fast, long &parsed)
+{
+    std::vector<unsigned char> pack(512);
+    BenchTimer timer;
+    parsed = 0;
+
+    for (size_t it = 0; it < corpus.size(); ++it)
+    {
+        const std::string &sentence = corpus[it];
+        const int size = static_cast<int>(sentence.size());
+        for (const Decoder &decoder : decoders)
+        {
+            if (0 != std::strncmp(sentence.data() + 1, decoder.name, 5))
+                continue;
+            parsed += fast ? decoder.fast(sentence.data(), size, pack.data())
+                           : decoder.reference(sentence.data(), size, pack.data());
+        }
+    }
+
+    return timer.seconds();
+}
+
+int main(int argc, char *argv[])
+{
+    const long iterations = (argc > 1) ? std::atol(argv[1]) : 20000;
+
+    std::vector<std::string> corpus;
+    for (int it = 0; it < benchSentenceCount; ++it)
+        corpus.push_back(benchSentences[it]);
+
+    nmeaINFO info;
+    nmea_zero_INFO(&info);
+    nmeaGENERATOR *noise = nmea_create_generator(NMEA_GEN_NOISE, &info);
+    nmeaGENERATOR *rotate = nmea_create_generator(NMEA_GEN_ROTATE, &info);
+    char buff[2048];
+    for (long it = 0; it < iterations; ++it)
+    {
+        const int size = nmea_generate_from(buff, sizeof(buff), &info, (it % 2) ? noise : rotate,
+                                            GPGGA | GPGSA | GPGSV | GPRMC | GPVTG);
+        appendSentences(corpus, buff, size);
+    }
+    nmea_destroy_generator(noise);
+    nmea_destroy_generator(rotate);
+
+    const size_t clean = corpus.size();
+    for (size_t it = 0; it < clean; ++it)
+        corpus.push_back(mutate(corpus[it]));
+
+    const long mismatches = compareDecoders(corpus);
+    std::printf("differential: %zu sentences (%zu mutated), %ld mismatches\n",
+                corpus.size(), corpus.size() - clean, mismatches);
+
+    // Throughput on the GGA/RMC mix
+    std::vector<std::string> mix;
+    long bytes = 0;
+    for (size_t it = 0; it < clean; ++it)
+    {
+        if (0 == corpus[it].compare(0, 6, "$GPGGA") || 0 == corpus[it].compare(0, 6, "$GPRMC"))
+        {
+            mix.push_back(corpus[it]);
+            bytes += static_cast<long>(corpus[it].size());
+        }
+    }
+
+    long parsed = 0;
+    double seconds = timeDecoder(mix, false, parsed);
+    benchReport("nmea_scanf_GPxxx (GGA/RMC)", parsed, bytes, seconds);
+    seconds = timeDecoder(mix, true, parsed);
+    benchReport("nmea_parse_GPxxx (GGA/RMC)", parsed, bytes, seconds);
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// bench_parse_parallel.cpp
+//
+// Scaling of nmea_parse_parallel from 1 to 64 worker threads on an
+// in-memory log. Every run must decode the same packets in the same order
+// and end with the same nmeaINFO as a single nmea_parse of the whole log,
+// on a clean log and on a log with corrupted bytes.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <cstdlib>
+#include <cstring>
+
+struct OrderHash
+{
+    unsigned long long hash;
+};
+
+// Fold every packet type and the merged fix into a hash, so reordered packets are detected
+static int hashPacket(int ptype, const void *, const nmeaINFO *info, void *userData)
+{
+    OrderHash *order = static_cast<OrderHash *>(userData);
+    unsigned long long fields[4];
+    std::memcpy(&fields[0], &info->lat, sizeof(double));
+    std::memcpy(&fields[1], &info->lon, sizeof(double));
+    fields[2] = static_cast<unsigned long long>(ptype) << 32 | static_cast<unsigned int>(info->smask);
+    fields[3] = static_cast<unsigned long long>(info->utc.hour * 3600 + info->utc.min * 60 + info->utc.sec) << 32 |
+                static_cast<unsigned int>(info->satinfo.inview);
+    for (unsigned long long field : fields)
+    {
+        order->hash = (order->hash ^ field) * 1099511628211ull;
+    }
+    return 1;
+}
+
+static int check(const char *name, const std::string &stream, int threadCounts[], int threadCountSize)
+{
+    nmeaINFO refInfo;
+    nmeaPARSER parser;
+    OrderHash refOrder = { 14695981039346656037ull };
+    int failures = 0;
+
+    nmea_zero_INFO(&refInfo);
+    nmea_parser_init(&parser);
+
+    BenchTimer timer;
+    const long refParsed = nmea_parse(&parser, stream.data(), static_cast<int>(stream.size()), &refInfo);
+    benchReport(name, refParsed, static_cast<long>(stream.size()), timer.seconds());
+    nmea_parser_destroy(&parser);
+
+    nmea_zero_INFO(&refInfo);
+    nmea_parser_init(&parser);
+    nmea_parse_mapped(&parser, stream.data(), static_cast<long long>(stream.size()), &refInfo, &hashPacket, &refOrder, 0);
+    nmea_parser_destroy(&parser);
+
+    for (int i = 0; i < threadCountSize; ++i)
+    {
+        nmeaINFO info;
+        nmeaREPLAYSTAT stat;
+        OrderHash order = { 14695981039346656037ull };
+        char label[64];
+
+        nmea_zero_INFO(&info);
+        const int parsed = nmea_parse_parallel(stream.data(), static_cast<long long>(stream.size()), &info,
+                                               threadCounts[i], 0, 0, &stat);
+        std::snprintf(label, sizeof(label), "  parallel, %d threads", threadCounts[i]);
+        benchReport(label, parsed, static_cast<long>(stat.bytes), stat.seconds);
+
+        nmea_zero_INFO(&info);
+        nmea_parse_parallel(stream.data(), static_cast<long long>(stream.size()), &info,
+                            threadCounts[i], &hashPacket, &order, 0);
+
+        if (parsed != refParsed || order.hash != refOrder.hash || std::memcmp(&info, &refInfo, sizeof(nmeaINFO)) != 0)
+        {
+            std::printf("  mismatch: %d of %ld packets, order %s, final nmeaINFO %s\n", parsed, refParsed,
+                        order.hash == refOrder.hash ? "same" : "differs",
+                        std::memcmp(&info, &refInfo, sizeof(nmeaINFO)) == 0 ? "same" : "differs");
+            ++failures;
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    static int threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    const int threadCountSize = sizeof(threadCounts) / sizeof(threadCounts[0]);
+    const long sentences = (argc > 1) ? std::atol(argv[1]) : 2000000;
+    std::string stream = benchMakeStream(sentences);
+    int failures = 0;
+
+    failures += check("nmea_parse (clean log)", stream, threadCounts, threadCountSize);
+
+    // Corrupt one byte in ~every 200 sentences, including delimiters
+    unsigned int rng = 2166136261u;
+    for (size_t i = 0; i < stream.size() / 13000; ++i)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        const char noise[] = "$*\r\n,0A";
+        stream[rng % stream.size()] = noise[(rng >> 8) % (sizeof(noise) - 1)];
+    }
+
+    failures += check("nmea_parse (corrupted log)", stream, threadCounts, threadCountSize);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// bench_parser_alloc.cpp
+//
+// Counts heap allocations made by nmea_parse in steady state.
+// malloc/calloc/realloc are interposed for the whole process (glibc),
+// so the counters include allocations made inside libnmeaparser.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <cstdlib>
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static long allocCount = 0;
+
+extern "C" void *malloc(size_t size)
+{
+    ++allocCount;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    ++allocCount;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    ++allocCount;
+    return __libc_realloc(ptr, size);
+}
+
+int main(int argc, char *argv[])
+{
+    const long sentences = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    const std::string stream = benchMakeStream(sentences);
+
+    nmeaINFO info;
+    nmeaPARSER parser;
+    nmea_zero_INFO(&info);
+    nmea_parser_init(&parser);
+
+    // Warm up so lazily allocated runtime state does not count
+    nmea_parse(&parser, stream.data(), static_cast<int>(stream.size() < 4096 ? stream.size() : 4096), &info);
+
+    long parsed = 0;
+    const long allocBefore = allocCount;
+    BenchTimer timer;
+    for (size_t off = 0; off < stream.size(); off += NMEA_DEF_PARSEBUFF)
+    {
+        const size_t len = (stream.size() - off < NMEA_DEF_PARSEBUFF) ? stream.size() - off : NMEA_DEF_PARSEBUFF;
+        parsed += nmea_parse(&parser, stream.data() + off, static_cast<int>(len), &info);
+    }
+    const double seconds = timer.seconds();
+    const long allocs = allocCount - allocBefore;
+
+    nmea_parser_destroy(&parser);
+
+    benchReport("nmea_parse (1 KB chunks)", parsed, static_cast<long>(stream.size()), seconds);
+    std::printf("heap allocations: %ld total, %.6f per sentence\n",
+                allocs, parsed ? static_cast<double>(allocs) / parsed : 0.0);
+
+    return allocs == 0 ? 0 : 1;
+}
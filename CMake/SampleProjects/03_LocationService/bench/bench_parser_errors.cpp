@@ -0,0 +1,266 @@
+// bench_parser_errors.cpp
+//
+// Per parser error sinks (nmeaPARSERCONFIG). A stream of the sample burst
+// with bad sentences at known places (control sum, unknown type, bad
+// field, bad time, bad VTG unit) is pushed in random chunks: the sink has
+// to see every error once with its code, type and stream offset. Checks
+// that the rate limit reports at most error_rate errors a second and counts
+// the rest as dropped, and that parsers of two threads keep their own
+// sinks. Reports the parse cost with no sink, with a rate limited sink and
+// with every error formatted for the global nmea_property() error_func.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct Expected
+{
+    int code;
+    int ptype;
+    long long offset;
+};
+
+static std::string withCrc(const std::string &body)
+{
+    unsigned char crc = 0;
+    for (size_t it = 1; it < body.size(); ++it)
+        crc ^= static_cast<unsigned char>(body[it]);
+    char tail[8];
+    std::snprintf(tail, sizeof(tail), "*%02X\r\n", crc);
+    return body + tail;
+}
+
+// Sample bursts with one bad sentence after every `every` good ones
+static std::string makeStream(long sentences, long every, std::vector<Expected> &expected)
+{
+    static const struct
+    {
+        int code;
+        int ptype;
+        const char *sentence;
+        bool fixCrc;
+    } faults[] = {
+        { NMEA_ERR_CRC, GPNON, "$GPGGA,111609.14,5001.27,N,3613.06,E,3,08,0.0,10.2,M,0.0,M,0.0,0000*71\r\n", false },
+        { NMEA_ERR_TYPE, GPNON, "$GPXTE,A,A,0.67,L,N", true },
+        { NMEA_ERR_FIELDS, GPGGA, "$GPGGA,111609.14,5001.27,N,3613.06,E,3", true },
+        { NMEA_ERR_TIME, GPRMC, "$GPRMC,11160,A,5001.27,N,3613.06,E,11.2,0.0,261206,0.0,E", true },
+        { NMEA_ERR_FORMAT, GPVTG, "$GPVTG,217.5,T,208.8,X,000.00,N,000.01,K", true },
+    };
+    static const int faultCount = sizeof(faults) / sizeof(faults[0]);
+
+    std::string stream;
+    for (long it = 0; it < sentences; ++it)
+    {
+        if (it % every == every - 1)
+        {
+            const int fault = static_cast<int>((it / every) % faultCount);
+            expected.push_back({ faults[fault].code, faults[fault].ptype, static_cast<long long>(stream.size()) });
+            stream += faults[fault].fixCrc ? withCrc(faults[fault].sentence) : std::string(faults[fault].sentence);
+        }
+        else
+            stream += benchSentences[it % benchSentenceCount];
+    }
+    return stream;
+}
+
+struct Sink
+{
+    const std::string *stream = NULL;
+    std::vector<Expected> errors;
+    unsigned long dropped = 0;
+    int badText = 0;
+
+    static void report(void *user, const nmeaERROR *error)
+    {
+        Sink *sink = static_cast<Sink *>(user);
+        sink->errors.push_back({ error->code, error->ptype, error->offset });
+        sink->dropped += error->dropped;
+        if (sink->stream && error->sentence &&
+            sink->stream->compare(static_cast<size_t>(error->offset), static_cast<size_t>(error->sentence_sz),
+                                  error->sentence, static_cast<size_t>(error->sentence_sz)) != 0)
+            sink->badText++;
+    }
+};
+
+static unsigned int rngState = 2166136261u;
+
+static unsigned int nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static long parseStream(nmeaPARSER &parser, const std::string &stream, bool randomChunks)
+{
+    void *pack = NULL;
+    long packets = 0;
+    for (size_t done = 0; done < stream.size();)
+    {
+        size_t len = randomChunks ? 1 + nextRandom() % 700 : std::min<size_t>(stream.size() - done, INT_MAX);
+        len = std::min(len, stream.size() - done);
+        const int taken = nmea_parser_real_push(&parser, stream.data() + done, static_cast<int>(len));
+        done += static_cast<size_t>(taken);
+        while (nmea_parser_pop(&parser, &pack) != GPNON)
+            packets++;
+    }
+    return packets;
+}
+
+static long globalMessages = 0;
+
+static void countMessage(const char *str, int str_size)
+{
+    if (str && str_size > 0)
+        globalMessages++;
+}
+
+int main(int argc, char *argv[])
+{
+    const long sentences = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    int errors = 0;
+
+    {
+        std::vector<Expected> expected;
+        const std::string stream = makeStream(sentences, 10, expected);
+        Sink sink;
+        sink.stream = &stream;
+        nmeaPARSERCONFIG config;
+        nmea_parser_config(&config);
+        config.error_sink = &Sink::report;
+        config.error_user = &sink;
+        nmeaPARSER parser;
+        nmea_parser_init_config(&parser, &config);
+        const long packets = parseStream(parser, stream, true);
+        nmea_parser_destroy(&parser);
+
+        bool same = sink.errors.size() == expected.size();
+        for (size_t it = 0; same && it < expected.size(); ++it)
+            same = sink.errors[it].code == expected[it].code && sink.errors[it].ptype == expected[it].ptype &&
+                   sink.errors[it].offset == expected[it].offset;
+        std::printf("random chunks: %ld packets, %zu errors reported of %zu\n", packets, sink.errors.size(), expected.size());
+        if (!same || sink.badText != 0 || packets != sentences - static_cast<long>(expected.size()))
+        {
+            std::printf("random chunks: errors do not match the stream\n");
+            errors++;
+        }
+
+        char text[256];
+        nmeaERROR error = { NMEA_ERR_FIELDS, GPGGA, 1, 1234, NULL, 0, 0 };
+        nmea_error_format(&error, text, sizeof(text));
+        if (std::strcmp(text, "GPGGA parse error! (offset 1234, field 1)") != 0)
+        {
+            std::printf("nmea_error_format: \"%s\"\n", text);
+            errors++;
+        }
+    }
+
+    {
+        // Every sentence bad, far more than the limit within the run
+        std::vector<Expected> expected;
+        const std::string stream = makeStream(200000, 1, expected);
+        Sink sink;
+        nmeaPARSERCONFIG config;
+        nmea_parser_config(&config);
+        config.error_sink = &Sink::report;
+        config.error_user = &sink;
+        config.error_rate = 10;
+        nmeaPARSER parser;
+        nmea_parser_init_config(&parser, &config);
+        BenchTimer timer;
+        parseStream(parser, stream, false);
+        const double seconds = timer.seconds();
+        const unsigned long pending = parser.error_dropped;
+        nmea_parser_destroy(&parser);
+
+        std::printf("rate limit: %zu reported, %lu dropped of %zu in %.3f s\n",
+                    sink.errors.size(), sink.dropped + pending, expected.size(), seconds);
+        if (sink.errors.size() > static_cast<size_t>(10 * (seconds + 2)) ||
+            sink.errors.size() + sink.dropped + pending != expected.size())
+        {
+            std::printf("rate limit: not respected\n");
+            errors++;
+        }
+    }
+
+    {
+        // Two threads, each parser reports only its own stream
+        std::vector<Expected> expectedA, expectedB;
+        const std::string streamA = makeStream(200000, 7, expectedA);
+        const std::string streamB = makeStream(200000, 13, expectedB);
+        Sink sinkA, sinkB;
+        sinkA.stream = &streamA;
+        sinkB.stream = &streamB;
+        auto run = [](const std::string *stream, Sink *sink)
+        {
+            nmeaPARSERCONFIG config;
+            nmea_parser_config(&config);
+            config.error_sink = &Sink::report;
+            config.error_user = sink;
+            nmeaPARSER parser;
+            nmea_parser_init_config(&parser, &config);
+            parseStream(parser, *stream, false);
+            nmea_parser_destroy(&parser);
+        };
+        std::thread a(run, &streamA, &sinkA);
+        std::thread b(run, &streamB, &sinkB);
+        a.join();
+        b.join();
+        if (sinkA.errors.size() != expectedA.size() || sinkB.errors.size() != expectedB.size() ||
+            sinkA.badText != 0 || sinkB.badText != 0)
+        {
+            std::printf("threads: %zu and %zu errors reported of %zu and %zu\n",
+                        sinkA.errors.size(), sinkB.errors.size(), expectedA.size(), expectedB.size());
+            errors++;
+        }
+    }
+
+    {
+        std::vector<Expected> expected;
+        const std::string stream = makeStream(sentences, 10, expected);
+        double seconds;
+        nmeaPARSER parser;
+        nmeaPARSERCONFIG config;
+
+        nmea_parser_init(&parser);
+        BenchTimer plainTimer;
+        parseStream(parser, stream, false);
+        seconds = plainTimer.seconds();
+        nmea_parser_destroy(&parser);
+        benchReport("no sink", sentences, static_cast<long>(stream.size()), seconds);
+
+        Sink sink;
+        nmea_parser_config(&config);
+        config.error_sink = &Sink::report;
+        config.error_user = &sink;
+        config.error_rate = 100;
+        nmea_parser_init_config(&parser, &config);
+        BenchTimer limitTimer;
+        parseStream(parser, stream, false);
+        seconds = limitTimer.seconds();
+        nmea_parser_destroy(&parser);
+        benchReport("sink, 100 errors/s", sentences, static_cast<long>(stream.size()), seconds);
+
+        nmea_property()->error_func = &countMessage;
+        nmea_parser_init(&parser);
+        BenchTimer globalTimer;
+        parseStream(parser, stream, false);
+        seconds = globalTimer.seconds();
+        nmea_parser_destroy(&parser);
+        nmea_property()->error_func = NULL;
+        benchReport("nmea_property() error_func", sentences, static_cast<long>(stream.size()), seconds);
+        std::printf("%-32s %ld messages to error_func of %zu errors\n", "", globalMessages, expected.size());
+        if (globalMessages != static_cast<long>(expected.size()))
+            errors++;
+    }
+
+    std::printf("parser errors: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+// bench_parser_push.cpp
+//
+// Feeds the same stream to nmea_parse in chunks of different sizes,
+// including bursts much larger than the parser buffer, and checks that
+// no sentence is lost at chunk boundaries.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <cstdlib>
+
+static unsigned int rngState = 2166136261u;
+
+static unsigned int nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// chunkSize 0 means random chunk sizes in [1, 8192]
+static long parseInChunks(const std::string &stream, int chunkSize, double &seconds)
+{
+    nmeaINFO info;
+    nmeaPARSER parser;
+    long parsed = 0;
+
+    nmea_zero_INFO(&info);
+    nmea_parser_init(&parser);
+
+    BenchTimer timer;
+    for (size_t off = 0; off < stream.size();)
+    {
+        size_t len = chunkSize ? chunkSize : 1 + nextRandom() % 8192;
+        if (len > stream.size() - off)
+            len = stream.size() - off;
+        parsed += nmea_parse(&parser, stream.data() + off, static_cast<int>(len), &info);
+        off += len;
+    }
+    seconds = timer.seconds();
+
+    nmea_parser_destroy(&parser);
+
+    return parsed;
+}
+
+int main(int argc, char *argv[])
+{
+    static const int chunkSizes[] = { 1, 7, 64, 1024, 65536, 1 << 24, 0 };
+    const long sentences = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    const std::string stream = benchMakeStream(sentences);
+    int failures = 0;
+
+    for (int chunkSize : chunkSizes)
+    {
+        double seconds = 0;
+        const long parsed = parseInChunks(stream, chunkSize, seconds);
+        char name[64];
+        std::snprintf(name, sizeof(name), chunkSize ? "nmea_parse (%d B chunks)" : "nmea_parse (random chunks)", chunkSize);
+        benchReport(name, parsed, static_cast<long>(stream.size()), seconds);
+        if (parsed != sentences)
+        {
+            std::printf("  lost %ld of %ld sentences\n", sentences - parsed, sentences);
+            ++failures;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+// bench_pipeline.cpp
+//
+// Bursty receiver input with a slow publisher: per-fix latency (arrival of
+// the burst to publication) of the serial LocationService against the
+// LocationPipeline (I/O -> raw ring -> parse -> fix ring -> publish).
+// Checks that the Block pipeline publishes every fix and that the
+// drop counters account for everything in Drop mode.
+
+#include "bench_common.h"
+#include "LocationPipeline.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+static long long nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Publisher which needs some work per fix and sometimes stalls
+static void slowPublish(long index)
+{
+    const long long until = nowNs() + ((index % 500 == 0) ? 500000 : 2000);
+    while (nowNs() < until)
+    {
+    }
+}
+
+// Sleeps so the waiting thread does not take the CPU from pipeline stages
+static void sleepUntil(long long deadlineNs)
+{
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000LL);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static std::vector<std::string> makeBursts(long epochs, long epochsPerBurst)
+{
+    nmeaINFO info;
+    nmea_zero_INFO(&info);
+    nmeaGENERATOR *gen = nmea_create_generator(NMEA_GEN_ROTATE, &info);
+    std::vector<std::string> bursts;
+    char buff[2048];
+    for (long it = 0; it < epochs; ++it)
+    {
+        if (it % epochsPerBurst == 0)
+            bursts.push_back(std::string());
+        const int size = nmea_generate_from(buff, sizeof(buff), &info, gen, GPGGA | GPGSA | GPGSV | GPRMC | GPVTG);
+        bursts.back().append(buff, size);
+    }
+    nmea_destroy_generator(gen);
+    return bursts;
+}
+
+static void reportLatency(const char *name, std::vector<long long> &latency, double seconds)
+{
+    if (latency.empty())
+        return;
+    std::sort(latency.begin(), latency.end());
+    std::printf("%-28s %8zu fixes %8.3f s   p50 %8.1f us   p99 %8.1f us   max %8.1f us\n",
+                name, latency.size(), seconds,
+                latency[latency.size() / 2] / 1e3,
+                latency[latency.size() * 99 / 100] / 1e3,
+                latency.back() / 1e3);
+}
+
+int main(int argc, char *argv[])
+{
+    const long epochs = (argc > 1) ? std::atol(argv[1]) : 20000;
+    const long epochsPerBurst = 50;
+    const long long burstPeriodNs = 1000000;
+    const std::vector<std::string> bursts = makeBursts(epochs, epochsPerBurst);
+    OutputBuffer sink(open("/dev/null", O_WRONLY));
+    int errors = 0;
+
+    // Serial: reading waits for parsing and publishing of the previous burst
+    {
+        std::vector<long long> latency;
+        long long arrival = 0;
+        long index = 0;
+        LocationService service;
+        service.setFixHandler([&](const LocationFix &) {
+            slowPublish(index++);
+            latency.push_back(nowNs() - arrival);
+        });
+
+        BenchTimer timer;
+        const long long start = nowNs();
+        for (size_t it = 0; it < bursts.size(); ++it)
+        {
+            // Burst arrived on schedule even if the service is late to read it
+            arrival = start + static_cast<long long>(it) * burstPeriodNs;
+            sleepUntil(arrival);
+            service.parseNMEAMessage(bursts[it]);
+        }
+        service.finishEpoch();
+        reportLatency("serial LocationService", latency, timer.seconds());
+        if (latency.size() != static_cast<size_t>(epochs))
+            errors++;
+    }
+
+    // Pipeline with backpressure, every fix must be published
+    {
+        std::vector<long long> latency;
+        long index = 0;
+        LocationPipeline pipeline(sink, 256, 4096, LocationPipeline::kBlock);
+        pipeline.setFixHandler([&](const LocationFix &fix) {
+            slowPublish(index++);
+            latency.push_back(nowNs() - fix.ingestNs);
+        });
+
+        BenchTimer timer;
+        const long long start = nowNs();
+        for (size_t it = 0; it < bursts.size(); ++it)
+        {
+            sleepUntil(start + static_cast<long long>(it) * burstPeriodNs);
+            pipeline.submit(bursts[it].data(), bursts[it].size());
+        }
+        pipeline.stop();
+        reportLatency("LocationPipeline (block)", latency, timer.seconds());
+
+        const LocationPipeline::Stats stats = pipeline.stats();
+        std::printf("  %llu chunks, %llu stalls, %llu fixes, %llu fix drops, %llu published\n",
+                    stats.rawChunks, stats.rawStalls, stats.fixes, stats.fixDrops, stats.published);
+        if (stats.fixes != static_cast<unsigned long long>(epochs) ||
+            stats.published + stats.fixDrops != stats.fixes || stats.rawDroppedBytes != 0)
+            errors++;
+    }
+
+    // Tiny rings in Drop mode, everything is either published or counted
+    {
+        LocationPipeline pipeline(sink, 2, 4, LocationPipeline::kDrop);
+        long index = 0;
+        pipeline.setFixHandler([&](const LocationFix &) { slowPublish(index++); });
+        unsigned long long accepted = 0, submitted = 0;
+        for (const std::string &burst : bursts)
+        {
+            accepted += pipeline.submit(burst.data(), burst.size());
+            submitted += burst.size();
+        }
+        pipeline.stop();
+
+        const LocationPipeline::Stats stats = pipeline.stats();
+        std::printf("LocationPipeline (drop)      %llu/%llu bytes accepted, %llu stalls, %llu fixes, %llu fix drops\n",
+                    accepted, submitted, stats.rawStalls, stats.fixes, stats.fixDrops);
+        if (accepted + stats.rawDroppedBytes != submitted || stats.published + stats.fixDrops != stats.fixes)
+            errors++;
+    }
+
+    std::printf("pipeline: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
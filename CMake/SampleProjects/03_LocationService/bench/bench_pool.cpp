@@ -0,0 +1,179 @@
+// bench_pool.cpp
+//
+// 10k simulated receivers, each with its own nmea_create_generator track,
+// fed through a LocationServicePool with a growing number of workers.
+// Reports fixes/s when submitting as fast as possible and the p99 latency
+// (submit to fix) at a fixed offered load. Checks that every epoch becomes
+// a fix and that the aggregated queries return the same last fix as a
+// serial LocationService for a sample of devices.
+
+#include "bench_common.h"
+#include "LocationServicePool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+static long long nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleepUntil(long long deadlineNs)
+{
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000LL);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static const uint64_t kFirstDeviceId = 350000000000000ULL;
+
+// Pre-generated output of every simulated device, epochs[device][epoch]
+struct LoadGenerator
+{
+    LoadGenerator(long devices, long epochs) : epochs(devices)
+    {
+        char buff[2048];
+        for (long dev = 0; dev < devices; ++dev)
+        {
+            nmeaINFO info;
+            nmea_zero_INFO(&info);
+            info.lat = 4807.038 + (dev % 100) * 10;
+            info.lon = 1131.000 + (dev / 100) * 10;
+            nmeaGENERATOR *gen = nmea_create_generator((dev % 2) ? NMEA_GEN_POS_RANDMOVE : NMEA_GEN_ROTATE, &info);
+            for (long it = 0; it < epochs; ++it)
+            {
+                const int size = nmea_generate_from(buff, sizeof(buff), &info, gen, GPGGA | GPGSA | GPGSV | GPRMC | GPVTG);
+                this->epochs[dev].push_back(std::string(buff, size));
+                bytes += size;
+            }
+            nmea_destroy_generator(gen);
+        }
+    }
+
+    std::vector<std::vector<std::string>> epochs;
+    size_t bytes = 0;
+};
+
+static long long percentile(std::vector<std::vector<long long>> &perWorker, size_t pct, size_t &count)
+{
+    std::vector<long long> all;
+    for (std::vector<long long> &latency : perWorker)
+        all.insert(all.end(), latency.begin(), latency.end());
+    count = all.size();
+    if (all.empty())
+        return 0;
+    std::sort(all.begin(), all.end());
+    return all[all.size() * pct / 100];
+}
+
+int main(int argc, char *argv[])
+{
+    const long devices = (argc > 1) ? std::atol(argv[1]) : 10000;
+    const long epochs = (argc > 2) ? std::atol(argv[2]) : 4;
+    const long maxWorkers = (argc > 3) ? std::atol(argv[3]) : 8;
+    const long offeredPerMs = 20; // epochs per millisecond for the latency run
+    int errors = 0;
+
+    LoadGenerator load(devices, epochs);
+    std::printf("%ld devices x %ld epochs, %zu bytes\n", devices, epochs, load.bytes);
+
+    // Serial reference for the last fix of some devices
+    std::vector<long> sample;
+    std::vector<LocationFix> expected;
+    for (long dev = 0; dev < devices; dev += 97)
+    {
+        LocationFix last = {};
+        LocationService service;
+        service.setFixHandler([&](const LocationFix &fix) { last = fix; });
+        for (const std::string &epoch : load.epochs[dev])
+            service.parseNMEAMessage(epoch);
+        service.finishEpoch();
+        sample.push_back(dev);
+        expected.push_back(last);
+    }
+
+    for (long workers = 1; workers <= maxWorkers; workers *= 2)
+    {
+        double fixesPerSecond = 0;
+
+        // Throughput, the I/O thread only waits on full worker rings
+        {
+            LocationServicePool pool(static_cast<size_t>(workers));
+            BenchTimer timer;
+            for (long it = 0; it < epochs; ++it)
+                for (long dev = 0; dev < devices; ++dev)
+                {
+                    const std::string &epoch = load.epochs[dev][it];
+                    pool.submit(kFirstDeviceId + dev, epoch.data(), epoch.size());
+                }
+            pool.stop();
+            const double seconds = timer.seconds();
+
+            const LocationServicePool::Stats stats = pool.stats();
+            fixesPerSecond = stats.fixes / seconds;
+            if (stats.fixes != static_cast<unsigned long long>(devices * epochs) ||
+                stats.devices != static_cast<size_t>(devices))
+            {
+                std::printf("  %ld workers: %llu fixes from %zu devices\n", workers, stats.fixes, stats.devices);
+                errors++;
+            }
+
+            size_t withFix = 0;
+            pool.forEachFix([&](uint64_t, const LocationFix &) { withFix++; });
+            if (withFix != static_cast<size_t>(devices))
+                errors++;
+            for (size_t it = 0; it < sample.size(); ++it)
+            {
+                LocationFix fix;
+                if (!pool.getFix(kFirstDeviceId + sample[it], fix) || fix.lat != expected[it].lat ||
+                    fix.lon != expected[it].lon || fix.elv != expected[it].elv ||
+                    fix.satinview != expected[it].satinview)
+                {
+                    std::printf("  %ld workers: device %ld last fix differs\n", workers, sample[it]);
+                    errors++;
+                    break;
+                }
+            }
+        }
+
+        // Latency at a fixed offered load, recorded per worker so handlers share nothing
+        {
+            std::vector<std::vector<long long>> latency(static_cast<size_t>(workers));
+            LocationServicePool pool(static_cast<size_t>(workers));
+            // Every sentence of the generated epochs, a fix is handed over with its last one
+            // instead of with the next epoch of its device
+            pool.setEpochMask(GPGGA | GPGSA | GPGSV | GPRMC | GPVTG);
+            pool.setFixHandler([&](size_t worker, uint64_t, const LocationFix &fix) {
+                latency[worker].push_back(nowNs() - fix.ingestNs);
+            });
+
+            const long total = std::min(devices * epochs, 20000L);
+            const long long start = nowNs();
+            for (long it = 0; it < total; ++it)
+            {
+                if (it % offeredPerMs == 0)
+                    sleepUntil(start + (it / offeredPerMs) * 1000000LL);
+                const long dev = it % devices;
+                const std::string &epoch = load.epochs[dev][(it / devices) % epochs];
+                pool.submit(kFirstDeviceId + dev, epoch.data(), epoch.size());
+            }
+            pool.stop();
+
+            size_t count = 0;
+            const long long p50 = percentile(latency, 50, count);
+            const long long p99 = percentile(latency, 99, count);
+            std::printf("%2ld workers  %10.0f fixes/s   %ld fixes/s offered: p50 %8.1f us   p99 %8.1f us\n",
+                        workers, fixesPerSecond, offeredPerMs * 1000, p50 / 1e3, p99 / 1e3);
+            if (count != static_cast<size_t>(total))
+                errors++;
+        }
+    }
+
+    std::printf("pool: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
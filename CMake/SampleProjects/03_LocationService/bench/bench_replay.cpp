@@ -0,0 +1,135 @@
+// bench_replay.cpp
+//
+// Writes a recorded log to a temporary file and replays it with
+// nmea_parse_file (memory mapped, decoded in place) and with the classic
+// fread + nmea_parse loop, checking both decode the same packets and fixes.
+// The log is also replayed from a FIFO, which can not be mapped and has no
+// size, and a missing file must fail.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+static long parseByFread(const char *path, size_t chunkSize, nmeaINFO &info, double &seconds)
+{
+    nmeaPARSER parser;
+    std::vector<char> buff(chunkSize);
+    long parsed = 0;
+    size_t size;
+
+    nmea_zero_INFO(&info);
+    nmea_parser_init(&parser);
+
+    BenchTimer timer;
+    FILE *file = std::fopen(path, "rb");
+    if (!file)
+        return -1;
+    while ((size = std::fread(buff.data(), 1, buff.size(), file)) > 0)
+    {
+        parsed += nmea_parse(&parser, buff.data(), static_cast<int>(size), &info);
+    }
+    std::fclose(file);
+    seconds = timer.seconds();
+
+    nmea_parser_destroy(&parser);
+
+    return parsed;
+}
+
+int main(int argc, char *argv[])
+{
+    const long sentences = (argc > 1) ? std::atol(argv[1]) : 2000000;
+    const std::string stream = benchMakeStream(sentences);
+    char path[] = "/tmp/bench_replay_XXXXXX";
+    int failures = 0;
+
+    FILE *file = fdopen(mkstemp(path), "wb");
+    if (!file || std::fwrite(stream.data(), 1, stream.size(), file) != stream.size())
+    {
+        std::printf("can not write %s\n", path);
+        return 1;
+    }
+    std::fclose(file);
+
+    nmeaINFO freadInfo, mappedInfo;
+    nmeaREPLAYSTAT stat;
+    double seconds = 0;
+
+    const long freadParsed = parseByFread(path, 1024, freadInfo, seconds);
+    benchReport("fread + nmea_parse (1 KB)", freadParsed, static_cast<long>(stream.size()), seconds);
+
+    nmea_zero_INFO(&mappedInfo);
+    const int mappedParsed = nmea_parse_file(path, &mappedInfo, 0, 0, &stat);
+    benchReport("nmea_parse_file", mappedParsed, static_cast<long>(stat.bytes), stat.seconds);
+
+    if (freadParsed != sentences || mappedParsed != sentences || stat.sentences != sentences)
+    {
+        std::printf("  decoded %ld / %d of %ld sentences\n", freadParsed, mappedParsed, sentences);
+        ++failures;
+    }
+    if (std::memcmp(&freadInfo, &mappedInfo, sizeof(nmeaINFO)) != 0)
+    {
+        std::printf("  final nmeaINFO differs\n");
+        ++failures;
+    }
+
+    // Each burst of the sample log carries two epochs, RMC alone and GGA with RMC of one time
+    std::vector<nmeaINFO> fixes(1000);
+    const int fixCount = nmea_parse_file_fixes(path, fixes.data(), static_cast<int>(fixes.size()), &stat);
+    if (fixCount != static_cast<int>(fixes.size()) || !(fixes[1].smask & GPGGA) ||
+        fixes[1].utc_us == fixes[2].utc_us || fixes[1].utc.sec != fixes[3].utc.sec)
+    {
+        std::printf("  nmea_parse_file_fixes returned %d fixes\n", fixCount);
+        ++failures;
+    }
+
+    // FIFO written by a child process, read() blocks instead of mapping
+    const std::string fifo = std::string(path) + ".fifo";
+    if (mkfifo(fifo.c_str(), 0600) == 0)
+    {
+        std::fflush(stdout);
+        pid_t child = fork();
+        if (child == 0)
+        {
+            FILE *out = std::fopen(fifo.c_str(), "wb");
+            const bool written = out && std::fwrite(stream.data(), 1, stream.size(), out) == stream.size();
+            if (out)
+                std::fclose(out);
+            _exit(written ? 0 : 1);
+        }
+        nmeaINFO fifoInfo;
+        nmea_zero_INFO(&fifoInfo);
+        const int fifoParsed = nmea_parse_file(fifo.c_str(), &fifoInfo, 0, 0, &stat);
+        int status = 0;
+        waitpid(child, &status, 0);
+        benchReport("nmea_parse_file (FIFO)", fifoParsed, static_cast<long>(stat.bytes), stat.seconds);
+        if (fifoParsed != sentences || stat.bytes != static_cast<long long>(stream.size()) ||
+            std::memcmp(&freadInfo, &fifoInfo, sizeof(nmeaINFO)) != 0)
+        {
+            std::printf("  FIFO replay decoded %d of %ld sentences\n", fifoParsed, sentences);
+            ++failures;
+        }
+        std::remove(fifo.c_str());
+    }
+    else
+    {
+        ++failures;
+    }
+
+    if (nmea_parse_file(fifo.c_str(), 0, 0, 0, 0) != -1)
+    {
+        std::printf("  missing log file was replayed\n");
+        ++failures;
+    }
+
+    std::remove(path);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// bench_snapshot.cpp
+//
+// Read latency of LocationService::getLatestFix (seqlock snapshot) alone
+// and while a writer publishes, torn read detection with fixes whose
+// fields depend on each other, a check that no reader sees utcUs go
+// backwards, and a second process reading the position from the POSIX
+// shared memory segment.
+
+#include "bench_common.h"
+#include "LocationService.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Every field follows from the index, a torn read mixes two indices
+static LocationFix makeFix(long index)
+{
+    LocationFix fix = {};
+    fix.utcUs = 1704067200000000LL + index * 100000LL;
+    fix.lat = index * 1e-6;
+    fix.lon = -index * 1e-6;
+    fix.elv = index * 2.0;
+    fix.speed = index * 0.5;
+    fix.satinuse = static_cast<int>(index % 64);
+    fix.satinview = static_cast<int>(index % 64) + 1;
+    fix.ingestNs = index;
+    return fix;
+}
+
+static bool consistent(const LocationFix &fix)
+{
+    const long index = static_cast<long>(fix.ingestNs);
+    const LocationFix expected = makeFix(index);
+    return fix.utcUs == expected.utcUs && fix.lat == expected.lat && fix.lon == expected.lon && fix.elv == expected.elv &&
+           fix.speed == expected.speed && fix.satinuse == expected.satinuse && fix.satinview == expected.satinview;
+}
+
+// Reads until the snapshot reaches count, returns torn reads and counts reads older than the one before
+static long readAll(const FixSnapshot &snapshot, uint64_t count, unsigned long long &reads, long &backwards)
+{
+    long bad = 0;
+    long long last = -1;
+    LocationFix fix;
+    while (snapshot.sequence() < count)
+    {
+        if (!snapshot.read(fix))
+            continue;
+        reads++;
+        if (!consistent(fix))
+            bad++;
+        else if (fix.utcUs < last)
+        {
+            if (backwards++ < 3)
+                std::printf("utcUs %lld read after %lld\n", static_cast<long long>(fix.utcUs), last);
+        }
+        last = fix.utcUs;
+    }
+    return bad;
+}
+
+static double readLatencyNs(const FixSnapshot &snapshot, long reads)
+{
+    LocationFix fix;
+    volatile double sink = 0;
+    BenchTimer timer;
+    for (long it = 0; it < reads; ++it)
+    {
+        snapshot.read(fix);
+        sink = sink + fix.lat;
+    }
+    return timer.seconds() * 1e9 / reads;
+}
+
+int main(int argc, char *argv[])
+{
+    const long fixes = (argc > 1) ? std::atol(argv[1]) : 2000000;
+    const long reads = 20000000;
+    int errors = 0;
+
+    // Snapshot follows the parser
+    {
+        const std::string log = benchMakeStream(2000);
+        LocationFix last = {};
+        LocationService service;
+        service.setFixHandler([&](const LocationFix &fix) { last = fix; });
+
+        LocationFix fix;
+        if (service.getLatestFix(fix))
+            errors++;
+        service.parseNMEAMessage(log);
+        if (!service.getLatestFix(fix) || fix.lat != last.lat || fix.lon != last.lon || fix.elv != last.elv ||
+            fix.utcUs != last.utcUs)
+        {
+            std::printf("latest fix differs from the last reported one\n");
+            errors++;
+        }
+        LocationFix sink;
+        volatile double acc = 0;
+        BenchTimer timer;
+        for (long it = 0; it < reads; ++it)
+        {
+            service.getLatestFix(sink);
+            acc = acc + sink.lat;
+        }
+        std::printf("getLatestFix, idle writer        %8.1f ns/read\n", timer.seconds() * 1e9 / reads);
+    }
+
+    // Readers racing one writer in the same process
+    {
+        FixSnapshot snapshot;
+        std::atomic<long> bad(0), reordered(0);
+        std::atomic<unsigned long long> total(0);
+        std::vector<std::thread> readers;
+        for (int it = 0; it < 2; ++it)
+            readers.emplace_back([&]() {
+                unsigned long long count = 0;
+                long backwards = 0;
+                bad += readAll(snapshot, static_cast<uint64_t>(fixes), count, backwards);
+                reordered += backwards;
+                total += count;
+            });
+
+        BenchTimer timer;
+        for (long it = 1; it <= fixes; ++it)
+            snapshot.publish(makeFix(it));
+        const double seconds = timer.seconds();
+        for (std::thread &reader : readers)
+            reader.join();
+
+        std::printf("publish with 2 readers           %8.1f ns/fix, %llu reads, %ld torn, %ld backwards\n",
+                    seconds * 1e9 / fixes, total.load(), bad.load(), reordered.load());
+        if (bad != 0 || reordered != 0 || snapshot.sequence() != static_cast<uint64_t>(fixes))
+            errors++;
+    }
+
+    // Another process maps the segment read only
+    {
+        const std::string name = "/bench_snapshot." + std::to_string(getpid());
+        FixSnapshot writer;
+        if (!writer.createShared(name))
+            return 1;
+        writer.publish(makeFix(0));
+
+        std::fflush(stdout);
+        pid_t child = fork();
+        if (child == 0)
+        {
+            FixSnapshot reader;
+            if (!reader.openShared(name))
+                _exit(2);
+            unsigned long long count = 0;
+            long backwards = 0;
+            const long bad = readAll(reader, static_cast<uint64_t>(fixes) + 1, count, backwards);
+            LocationFix fix;
+            if (!reader.read(fix) || fix.ingestNs != fixes)
+                _exit(3);
+            std::printf("shared memory reader             %8.1f ns/read, %llu reads while publishing, %ld torn, %ld backwards\n",
+                        readLatencyNs(reader, reads), count, bad, backwards);
+            std::fflush(stdout);
+            _exit(bad == 0 && backwards == 0 ? 0 : 4);
+        }
+
+        for (long it = 1; it <= fixes; ++it)
+            writer.publish(makeFix(it));
+
+        int status = 0;
+        waitpid(child, &status, 0);
+        FixSnapshot::removeShared(name);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            std::printf("shared memory reader failed (status %d)\n", status);
+            errors++;
+        }
+    }
+
+    std::printf("snapshot: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+// bench_stats.cpp
+//
+// Stage timers and counters of the parser (stats.h). A stream with known
+// numbers of good sentences, control sum failures and unknown types must
+// give exactly those counters and, timing every event, those histogram
+// counts; buffer and queue overflows must be counted. The cost of the timers
+// at the default sampling is measured by parsing the same stream with stats
+// switched on and off at run time.
+// Built without NMEA_STATS everything must read zero.
+
+#include "bench_common.h"
+#include "nmea.h"
+#include "tok.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Sentence of body with correct control sum, or a wrong one
+static std::string makeSentence(const char *body, bool goodCrc)
+{
+    char buff[256];
+    const int crc = nmea_calc_crc(body, static_cast<int>(strlen(body)));
+    std::snprintf(buff, sizeof(buff), "$%s*%02X\r\n", body, goodCrc ? crc : (crc ^ 0x55));
+    return buff;
+}
+
+static double parseSeconds(const std::string &stream, int repeat)
+{
+    nmeaINFO info;
+    nmeaPARSER parser;
+    nmea_zero_INFO(&info);
+    nmea_parser_init(&parser);
+    BenchTimer timer;
+    for (int it = 0; it < repeat; ++it)
+        nmea_parse(&parser, stream.data(), static_cast<int>(stream.size()), &info);
+    const double seconds = timer.seconds();
+    nmea_parser_destroy(&parser);
+    return seconds;
+}
+
+int main(int argc, char *argv[])
+{
+    const long bursts = (argc > 1) ? std::atol(argv[1]) : 1000;
+    const long good = bursts * benchSentenceCount;
+    const long badCrc = bursts / 10;
+    const long unknown = bursts / 5;
+    int errors = 0;
+
+    std::string stream;
+    for (long it = 0; it < bursts; ++it)
+    {
+        for (int sen = 0; sen < benchSentenceCount; ++sen)
+            stream += benchSentences[sen];
+        if (it % 10 == 0)
+            stream += makeSentence("GPGGA,111609.14,5001.27,N,3613.06,E,3,08,0.0,10.2,M,0.0,M,0.0,0000", false);
+        if (it % 5 == 0)
+            stream += makeSentence("GPGLL,4916.45,N,12311.12,W,225444,A", true);
+    }
+
+    nmea_stats_reset();
+    nmea_stats_enable(1);
+    nmea_stats_sample(1);
+    parseSeconds(stream, 1);
+
+    // Incomplete sentence longer than the parser buffer, queue filled without popping
+    {
+        nmeaPARSER parser;
+        nmea_parser_init(&parser);
+        std::string longSentence = "$GPGGA," + std::string(4 * NMEA_DEF_PARSEBUFF, '1');
+        nmea_parser_real_push(&parser, longSentence.data(), static_cast<int>(longSentence.size()));
+        const std::string burst = benchMakeStream(NMEA_DEF_PARSEQUEUE + 10);
+        nmea_parser_push(&parser, burst.data(), static_cast<int>(burst.size()));
+        nmea_parser_destroy(&parser);
+    }
+
+    nmeaSTATS stats;
+    nmea_stats_snapshot(&stats);
+
+    char table[2048];
+    nmea_stats_dump(table, sizeof(table));
+    std::fputs(table, stdout);
+
+    if (nmea_stats_compiled())
+    {
+        const unsigned long long sentences = good + NMEA_DEF_PARSEQUEUE + 10;
+        if (stats.counter[NMEA_COUNT_SENTENCE] != sentences ||
+            stats.counter[NMEA_COUNT_CRC_FAIL] != static_cast<unsigned long long>(badCrc) ||
+            stats.counter[NMEA_COUNT_UNKNOWN_TYPE] != static_cast<unsigned long long>(unknown) ||
+            stats.counter[NMEA_COUNT_DECODE_FAIL] != 0 ||
+            stats.counter[NMEA_COUNT_BUFF_OVERFLOW] != 1 ||
+            stats.counter[NMEA_COUNT_QUEUE_OVERFLOW] != 10)
+        {
+            std::printf("unexpected counters\n");
+            errors++;
+        }
+        // A sentence left in the buffer by a full queue is framed again on the next push
+        if (stats.stage[NMEA_STAGE_FRAME].count < sentences + badCrc + unknown ||
+            stats.stage[NMEA_STAGE_DECODE].count != sentences ||
+            stats.stage[NMEA_STAGE_MERGE].count != static_cast<unsigned long long>(good))
+        {
+            std::printf("unexpected stage counts\n");
+            errors++;
+        }
+        const double p50 = nmea_stats_percentile(&stats, NMEA_STAGE_DECODE, 50);
+        const double p99 = nmea_stats_percentile(&stats, NMEA_STAGE_DECODE, 99);
+        if (!(p50 > 0 && p50 <= p99 && p99 <= stats.stage[NMEA_STAGE_DECODE].max * stats.ns_per_tick + 1))
+        {
+            std::printf("decode percentiles out of order\n");
+            errors++;
+        }
+    }
+    else
+    {
+        for (int it = 0; it < NMEA_COUNT_LAST; ++it)
+            if (stats.counter[it] != 0)
+                errors++;
+    }
+
+    // Cost of timers: the same stream with stats on and off at run time
+    nmea_stats_sample(NMEA_DEF_SAMPLE);
+    const std::string load = benchMakeStream(1000000);
+    const int rounds = 5;
+    double onSeconds = 0, offSeconds = 0;
+    for (int round = 0; round < rounds; ++round)
+    {
+        nmea_stats_enable(0);
+        offSeconds += parseSeconds(load, 1);
+        nmea_stats_enable(1);
+        onSeconds += parseSeconds(load, 1);
+    }
+    benchReport("nmea_parse, stats off", 1000000L * rounds, static_cast<long>(load.size()) * rounds, offSeconds);
+    benchReport("nmea_parse, stats on", 1000000L * rounds, static_cast<long>(load.size()) * rounds, onSeconds);
+    std::printf("stats overhead %.1f ns/sentence (%s)\n", (onSeconds - offSeconds) * 1e9 / (1000000.0 * rounds),
+                nmea_stats_compiled() ? "compiled in" : "compiled out");
+
+    std::printf("stats: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
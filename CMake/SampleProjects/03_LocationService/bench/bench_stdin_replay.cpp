@@ -0,0 +1,129 @@
+// bench_stdin_replay.cpp
+//
+// Recorded multi-sentence log replayed through the stdin of the quiet
+// LocationService daemon, and fed in-process to LocationService in 4 KB
+// pieces that split sentences. Both must report one fix per epoch with the
+// same text.
+
+#include "bench_common.h"
+#include "LocationService.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+static std::string makeLog(long epochs)
+{
+    nmeaINFO info;
+    nmea_zero_INFO(&info);
+    nmeaGENERATOR *gen = nmea_create_generator(NMEA_GEN_ROTATE, &info);
+    std::string log;
+    char buff[2048];
+    for (long it = 0; it < epochs; ++it)
+    {
+        const int size = nmea_generate_from(buff, sizeof(buff), &info, gen, GPGGA | GPGSA | GPGSV | GPRMC | GPVTG);
+        log.append(buff, size);
+    }
+    nmea_destroy_generator(gen);
+    return log;
+}
+
+// Runs the daemon with log on stdin, returns its stdout
+static std::string replayThroughStdin(const std::string &log, double &seconds)
+{
+    int input[2], output[2];
+    if (pipe(input) != 0 || pipe(output) != 0)
+        return std::string();
+
+    BenchTimer timer;
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        close(input[0]);
+        close(input[1]);
+        close(output[0]);
+        close(output[1]);
+        execl(LOCATIONSERVICE_BINARY, LOCATIONSERVICE_BINARY, "-q", static_cast<char *>(NULL));
+        _exit(127);
+    }
+    close(input[0]);
+    close(output[1]);
+
+    std::thread writer([&log, fd = input[1]]() {
+        size_t done = 0;
+        while (done < log.size())
+        {
+            ssize_t nwritten = write(fd, log.data() + done, log.size() - done);
+            if (nwritten <= 0)
+                break;
+            done += nwritten;
+        }
+        close(fd);
+    });
+
+    std::string result;
+    char buff[65536];
+    ssize_t nread;
+    while ((nread = read(output[0], buff, sizeof(buff))) > 0)
+        result.append(buff, nread);
+    close(output[0]);
+    writer.join();
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    seconds = timer.seconds();
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? result : std::string();
+}
+
+int main(int argc, char *argv[])
+{
+    const long epochs = (argc > 1) ? std::atol(argv[1]) : 100000;
+    const std::string log = makeLog(epochs);
+    const long sentences = static_cast<long>(std::count(log.begin(), log.end(), '\n'));
+    int errors = 0;
+
+    // In-process, sentences split between calls
+    char path[] = "/tmp/bench_stdin_replayXXXXXX";
+    const int fd = mkstemp(path);
+    unsigned long long fixes = 0;
+    double seconds = 0;
+    {
+        OutputBuffer output(fd);
+        LocationService service;
+        service.setOutput(&output);
+        BenchTimer timer;
+        for (size_t done = 0; done < log.size(); done += 4096)
+            service.parseNMEAMessage(std::string_view(log).substr(done, 4096));
+        service.finishEpoch();
+        output.flush();
+        seconds = timer.seconds();
+        fixes = service.fixCount();
+    }
+    benchReport("LocationService (4 KB pieces)", sentences, static_cast<long>(log.size()), seconds);
+
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream expected;
+    expected << in.rdbuf();
+    unlink(path);
+
+    const std::string replayed = replayThroughStdin(log, seconds);
+    benchReport("LocationService -q < log", sentences, static_cast<long>(log.size()), seconds);
+
+    const long reported = static_cast<long>(std::count(replayed.begin(), replayed.end(), '\n'));
+    std::printf("%ld epochs, %llu fixes in-process, %ld fixes through stdin\n", epochs, fixes, reported);
+
+    if (fixes != static_cast<unsigned long long>(epochs) || reported != epochs || replayed != expected.str())
+    {
+        std::printf("fixes do not match epochs of the log\n");
+        errors++;
+    }
+
+    return errors == 0 ? 0 : 1;
+}
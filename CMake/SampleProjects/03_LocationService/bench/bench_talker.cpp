@@ -0,0 +1,248 @@
+// bench_talker.cpp
+//
+// Multi-constellation stream (GN/GP/GL/GA/BD talkers): packet type dispatch
+// of every talker and sentence, merge of GSV cycles of several talkers into
+// one satinfo, and cost of header dispatch against a linear memcmp chain
+// over the same talker x sentence heads.
+
+#include "bench_common.h"
+#include "nmea.h"
+#include "tok.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const char *talkers[] = { "GP", "GN", "GL", "GA", "BD", "GB", "GQ" };
+static const char *sentences[] = { "GGA", "GSA", "GSV", "RMC", "VTG" };
+static const int sentenceTypes[] = { GPGGA, GPGSA, GPGSV, GPRMC, GPVTG };
+
+static const int talkerCount = sizeof(talkers) / sizeof(talkers[0]);
+static const int sentenceCount = sizeof(sentences) / sizeof(sentences[0]);
+
+// Complete body ("GPGGA,...") with '$', control sum and line end
+static std::string makeSentence(const std::string &body)
+{
+    char tail[8];
+    std::snprintf(tail, sizeof(tail), "*%02X\r\n", nmea_calc_crc(body.data(), static_cast<int>(body.size())) & 0xFF);
+    return "$" + body + tail;
+}
+
+// GSV cycle of talker, satellite ids start from firstId
+static std::string makeGSV(const char *talker, int satCount, int firstId)
+{
+    std::string res;
+    // constellation out of view still reports an empty cycle
+    const int packCount = satCount ? (satCount + NMEA_SATINPACK - 1) / NMEA_SATINPACK : 1;
+    for (int pack = 1; pack <= packCount; ++pack)
+    {
+        char body[128];
+        int size = std::snprintf(body, sizeof(body), "%sGSV,%d,%d,%02d", talker, packCount, pack, satCount);
+        for (int it = (pack - 1) * NMEA_SATINPACK; it < pack * NMEA_SATINPACK && it < satCount; ++it)
+            size += std::snprintf(body + size, sizeof(body) - size, ",%02d,%02d,%03d,%02d",
+                                  firstId + it, 10 + it, (it * 30) % 360, 30 + it);
+        res += makeSentence(std::string(body, size));
+    }
+    return res;
+}
+
+// GSA of talker listing satellites [firstId, firstId + useCount)
+static std::string makeGSA(const char *talker, int useCount, int firstId)
+{
+    char body[128];
+    int size = std::snprintf(body, sizeof(body), "%sGSA,A,3", talker);
+    for (int it = 0; it < NMEA_PRNINPACK; ++it)
+        size += (it < useCount) ? std::snprintf(body + size, sizeof(body) - size, ",%02d", firstId + it)
+                                : std::snprintf(body + size, sizeof(body) - size, ",");
+    size += std::snprintf(body + size, sizeof(body) - size, ",1.2,0.8,0.9");
+    return makeSentence(std::string(body, size));
+}
+
+struct Constellation
+{
+    const char *talker;
+    int satCount;
+    int useCount;
+    int firstId;
+};
+
+static std::string makeEpoch(const Constellation *constellations, int count)
+{
+    std::string res;
+    res += makeSentence("GNRMC,111609.14,A,5001.27,N,3613.06,E,11.2,0.0,261206,0.0,E,A");
+    res += makeSentence("GNGGA,111609.14,5001.27,N,3613.06,E,1,28,0.8,10.2,M,0.0,M,0.0,0000");
+    res += makeSentence("PUBX,00,111609.14,5001.27,N");
+    res += makeSentence("GPZDA,111609.14,26,12,2006,00,00");
+    res += makeSentence("XXGGA,111609.14,5001.27,N,3613.06,E,1,28,0.8,10.2,M,0.0,M,0.0,0000");
+    for (int it = 0; it < count; ++it)
+        res += makeGSV(constellations[it].talker, constellations[it].satCount, constellations[it].firstId);
+    for (int it = 0; it < count; ++it)
+        res += makeGSA(constellations[it].talker, constellations[it].useCount, constellations[it].firstId);
+    return res;
+}
+
+// Satellites of every constellation form one run with expected ids and use flags
+static int checkSatinfo(const nmeaINFO &info, const Constellation *constellations, int count)
+{
+    int errors = 0, inview = 0, inuse = 0;
+
+    for (int it = 0; it < count; ++it)
+    {
+        const Constellation &con = constellations[it];
+        const int talker = nmea_talker_type(con.talker, 2);
+        int first = -1, found = 0;
+
+        for (int isat = 0; isat < info.satinfo.inview; ++isat)
+        {
+            const nmeaSATELLITE &sat = info.satinfo.sat[isat];
+            if (sat.talker != talker)
+                continue;
+            if (first < 0)
+                first = isat;
+            if (isat != first + found || sat.id != con.firstId + found ||
+                sat.in_use != (found < con.useCount ? 1 : 0))
+                errors++;
+            found++;
+        }
+
+        if (found != con.satCount)
+        {
+            std::printf("talker %s: %d satellites, expected %d\n", con.talker, found, con.satCount);
+            errors++;
+        }
+
+        inview += con.satCount;
+        inuse += con.useCount;
+    }
+
+    if (info.satinfo.inview != inview || info.satinfo.inuse != inuse)
+    {
+        std::printf("satinfo: %d in view, %d in use, expected %d, %d\n",
+                    info.satinfo.inview, info.satinfo.inuse, inview, inuse);
+        errors++;
+    }
+
+    return errors;
+}
+
+static int checkDispatch()
+{
+    static const char *unknown[] = { "PUBX,", "GPZDA", "XXGGA", "GPGG", "gpgga", "GP$GA", "G" };
+    int errors = 0;
+
+    for (int it = 0; it < talkerCount; ++it)
+    {
+        for (int is = 0; is < sentenceCount; ++is)
+        {
+            const std::string head = std::string(talkers[it]) + sentences[is];
+            if (nmea_pack_type(head.data(), static_cast<int>(head.size())) != sentenceTypes[is])
+            {
+                std::printf("dispatch of %s failed\n", head.c_str());
+                errors++;
+            }
+        }
+        if (nmea_talker_type(talkers[it], 2) < 0)
+            errors++;
+    }
+
+    for (const char *head : unknown)
+    {
+        if (GPNON != nmea_pack_type(head, static_cast<int>(std::strlen(head))))
+        {
+            std::printf("dispatch of %s is not rejected\n", head);
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+// Linear chain over the same heads, the way dispatch grows without a table
+static int linearPackType(const char *buff, int size)
+{
+    static std::vector<std::string> heads;
+    if (heads.empty())
+    {
+        for (int it = 0; it < talkerCount; ++it)
+            for (int is = 0; is < sentenceCount; ++is)
+                heads.push_back(std::string(talkers[it]) + sentences[is]);
+    }
+
+    if (size < 5)
+        return GPNON;
+    for (size_t it = 0; it < heads.size(); ++it)
+    {
+        if (0 == std::memcmp(buff, heads[it].data(), 5))
+            return sentenceTypes[it % sentenceCount];
+    }
+    return GPNON;
+}
+
+int main(int argc, char *argv[])
+{
+    const long iterations = (argc > 1) ? std::atol(argv[1]) : 5000000;
+    int errors = checkDispatch();
+
+    // Two epochs, GLONASS loses satellites and Galileo drops out of view in the second one
+    const Constellation first[] = {
+        { "GP", 12, 9, 1 }, { "GL", 8, 6, 65 }, { "GA", 10, 7, 1 }, { "BD", 6, 4, 1 }
+    };
+    const Constellation second[] = {
+        { "GP", 12, 10, 1 }, { "GL", 5, 5, 66 }, { "GA", 0, 0, 1 }, { "BD", 6, 3, 1 }
+    };
+
+    nmeaINFO info;
+    nmeaPARSER parser;
+    nmea_zero_INFO(&info);
+    nmea_parser_init(&parser);
+
+    std::string stream = makeEpoch(first, 4);
+    nmea_parse(&parser, stream.data(), static_cast<int>(stream.size()), &info);
+    errors += checkSatinfo(info, first, 4);
+
+    stream = makeEpoch(second, 4);
+    nmea_parse(&parser, stream.data(), static_cast<int>(stream.size()), &info);
+    errors += checkSatinfo(info, second, 4);
+
+    if ((info.smask & (GPGGA | GPGSA | GPGSV | GPRMC)) != (GPGGA | GPGSA | GPGSV | GPRMC))
+    {
+        std::printf("smask %#x misses multi-talker packets\n", info.smask);
+        errors++;
+    }
+
+    nmea_parser_destroy(&parser);
+
+    std::printf("multi-talker merge: %d errors, %d satellites in view\n", errors, info.satinfo.inview);
+
+    // Dispatch throughput over all registered heads
+    std::vector<std::string> heads;
+    for (int it = 0; it < talkerCount; ++it)
+        for (int is = 0; is < sentenceCount; ++is)
+            heads.push_back(std::string(talkers[it]) + sentences[is] + ",");
+
+    long sum = 0;
+    BenchTimer timer;
+    for (long it = 0; it < iterations; ++it)
+    {
+        const std::string &head = heads[it % heads.size()];
+        sum += linearPackType(head.data(), static_cast<int>(head.size()));
+    }
+    benchReport("linear memcmp dispatch", iterations, 0, timer.seconds());
+
+    BenchTimer tableTimer;
+    for (long it = 0; it < iterations; ++it)
+    {
+        const std::string &head = heads[it % heads.size()];
+        sum -= nmea_pack_type(head.data(), static_cast<int>(head.size()));
+    }
+    benchReport("nmea_pack_type", iterations, 0, tableTimer.seconds());
+
+    if (sum != 0)
+    {
+        std::printf("dispatch results differ\n");
+        errors++;
+    }
+
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+// bench_time.cpp
+//
+// Integer UTC timestamps (microseconds since 1970-01-01). Checks utc_us of
+// decoded GGA/RMC against timegm for random times with zero to three
+// decimals, nmea_time_to_us/nmea_time_from_us against gmtime_r, and
+// nmea_time_now against time(). Reports the cost of nmea_time_now versus
+// time() + gmtime_r and of sorting fixes by utc_us versus by nmeaTIME.
+
+#include "bench_common.h"
+#include "nmea.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+static unsigned long long rngState = 88172645463325252ULL;
+
+static unsigned long long nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+static std::string withCrc(const char *body)
+{
+    unsigned char crc = 0;
+    for (const char *ch = body + 1; *ch; ++ch)
+        crc ^= static_cast<unsigned char>(*ch);
+    char tail[8];
+    std::snprintf(tail, sizeof(tail), "*%02X\r\n", crc);
+    return std::string(body) + tail;
+}
+
+struct TimedSentence
+{
+    std::string sentence;
+    long long utcUs;
+    int ptype;
+};
+
+// GGA or RMC of a random time 1990..2089 with 0..3 decimals of second
+static TimedSentence makeSentence()
+{
+    static const int fracScale[] = { 0, 100000, 10000, 1000 };
+    TimedSentence timed;
+    struct tm utc = {};
+    utc.tm_year = 90 + static_cast<int>(nextRandom() % 100);
+    utc.tm_mon = static_cast<int>(nextRandom() % 12);
+    utc.tm_mday = 1 + static_cast<int>(nextRandom() % 28);
+    utc.tm_hour = static_cast<int>(nextRandom() % 24);
+    utc.tm_min = static_cast<int>(nextRandom() % 60);
+    utc.tm_sec = static_cast<int>(nextRandom() % 60);
+    const int decimals = static_cast<int>(nextRandom() % 4);
+    const int frac = decimals ? static_cast<int>(nextRandom() % (decimals == 1 ? 10 : decimals == 2 ? 100 : 1000)) : 0;
+
+    char time[16];
+    int len = std::snprintf(time, sizeof(time), "%02d%02d%02d", utc.tm_hour, utc.tm_min, utc.tm_sec);
+    if (decimals)
+        std::snprintf(time + len, sizeof(time) - len, ".%0*d", decimals, frac);
+    const long long fracUs = static_cast<long long>(frac) * fracScale[decimals];
+
+    char body[160];
+    if (nextRandom() & 1)
+    {
+        std::snprintf(body, sizeof(body), "$GPRMC,%s,A,5001.27,N,3613.06,E,11.2,0.0,%02d%02d%02d,0.0,E",
+                      time, utc.tm_mday, utc.tm_mon + 1, utc.tm_year % 100);
+        timed.utcUs = static_cast<long long>(timegm(&utc)) * 1000000 + fracUs;
+        timed.ptype = GPRMC;
+    }
+    else
+    {
+        std::snprintf(body, sizeof(body), "$GPGGA,%s,5001.27,N,3613.06,E,3,08,0.0,10.2,M,0.0,M,0.0,0000", time);
+        timed.utcUs = ((utc.tm_hour * 60 + utc.tm_min) * 60 + utc.tm_sec) * 1000000LL + fracUs;
+        timed.ptype = GPGGA;
+    }
+    timed.sentence = withCrc(body);
+    return timed;
+}
+
+static bool sameTime(const nmeaTIME &a, const struct tm &b)
+{
+    return a.year == b.tm_year && a.mon == b.tm_mon && a.day == b.tm_mday &&
+           a.hour == b.tm_hour && a.min == b.tm_min && a.sec == b.tm_sec;
+}
+
+static bool earlier(const nmeaTIME &a, const nmeaTIME &b)
+{
+    if (a.year != b.year)
+        return a.year < b.year;
+    if (a.mon != b.mon)
+        return a.mon < b.mon;
+    if (a.day != b.day)
+        return a.day < b.day;
+    if (a.hour != b.hour)
+        return a.hour < b.hour;
+    if (a.min != b.min)
+        return a.min < b.min;
+    if (a.sec != b.sec)
+        return a.sec < b.sec;
+    return a.hsec < b.hsec;
+}
+
+int main(int argc, char *argv[])
+{
+    const long count = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    int errors = 0;
+
+    {
+        long mismatches = 0;
+        for (long it = 0; it < 100000; ++it)
+        {
+            const TimedSentence timed = makeSentence();
+            const char *buff = timed.sentence.data();
+            const int size = static_cast<int>(timed.sentence.size());
+            nmeaGPGGA gga;
+            nmeaGPRMC rmc;
+            long long utcUs = -1;
+            if (timed.ptype == GPGGA && nmea_parse_GPGGA(buff, size, &gga))
+                utcUs = gga.utc_us;
+            else if (timed.ptype == GPRMC && nmea_parse_GPRMC(buff, size, &rmc) &&
+                     nmea_time_to_us(&rmc.utc) == rmc.utc_us - rmc.utc_us % 10000)
+                utcUs = rmc.utc_us;
+            if (utcUs != timed.utcUs)
+            {
+                if (mismatches++ < 5)
+                    std::printf("%.*s: utc_us %lld, expected %lld\n", size - 2, buff, utcUs, timed.utcUs);
+            }
+        }
+        std::printf("decoded utc_us: %ld mismatches\n", mismatches);
+        errors += mismatches != 0;
+    }
+
+    {
+        // Every day of 1900..2100 and random moments, both directions
+        long mismatches = 0;
+        const long long first = -2208988800LL, last = 4102444800LL;
+        for (long it = 0; it < 400000; ++it)
+        {
+            const long long sec = (it < 73415) ? first + it * 86400LL + 86399 * (it & 1)
+                                               : first + static_cast<long long>(nextRandom() % (last - first));
+            const long long frac = static_cast<long long>(nextRandom() % 1000000);
+            const long long us = sec * 1000000 + frac;
+            const time_t lt = static_cast<time_t>(sec);
+            struct tm expected;
+            gmtime_r(&lt, &expected);
+            nmeaTIME utc;
+            nmea_time_from_us(us, &utc);
+            if (!sameTime(utc, expected) || utc.hsec != static_cast<int>(frac / 10000) ||
+                nmea_time_to_us(&utc) != sec * 1000000 + frac / 10000 * 10000)
+                mismatches++;
+        }
+        std::printf("nmea_time_from_us/nmea_time_to_us: %ld mismatches\n", mismatches);
+        errors += mismatches != 0;
+    }
+
+    {
+        nmeaTIME now;
+        nmea_time_now(&now);
+        const long long nowUs = nmea_time_now_us();
+        const long long seconds = static_cast<long long>(time(NULL));
+        if (std::llabs(nmea_time_to_us(&now) / 1000000 - seconds) > 1 || std::llabs(nowUs / 1000000 - seconds) > 1)
+        {
+            std::printf("nmea_time_now: %04d-%02d-%02d %02d:%02d:%02d, time() %lld\n", now.year + 1900, now.mon + 1,
+                        now.day, now.hour, now.min, now.sec, seconds);
+            errors++;
+        }
+
+        volatile int sink = 0;
+        BenchTimer libcTimer;
+        for (long it = 0; it < count; ++it)
+        {
+            time_t lt = time(NULL);
+            struct tm tt;
+            gmtime_r(&lt, &tt);
+            sink = sink + tt.tm_sec;
+        }
+        benchReport("time() + gmtime_r", count, 0, libcTimer.seconds());
+
+        BenchTimer nowTimer;
+        for (long it = 0; it < count; ++it)
+        {
+            nmea_time_now(&now);
+            sink = sink + now.sec;
+        }
+        benchReport("nmea_time_now", count, 0, nowTimer.seconds());
+    }
+
+    {
+        // Fixes out of order by a few epochs, sorted by time
+        std::vector<nmeaTIME> times(static_cast<size_t>(count));
+        std::vector<long long> stamps(static_cast<size_t>(count));
+        for (long it = 0; it < count; ++it)
+        {
+            stamps[it] = 1704067200000000LL + (it + static_cast<long>(nextRandom() % 8)) * 100000LL;
+            nmea_time_from_us(stamps[it], &times[it]);
+        }
+
+        BenchTimer structTimer;
+        std::sort(times.begin(), times.end(), earlier);
+        benchReport("sort by nmeaTIME", count, 0, structTimer.seconds());
+
+        BenchTimer intTimer;
+        std::sort(stamps.begin(), stamps.end());
+        benchReport("sort by utc_us", count, 0, intTimer.seconds());
+
+        for (long it = 0; it < count; ++it)
+        {
+            if (nmea_time_to_us(&times[it]) != stamps[it])
+            {
+                std::printf("sort: orders differ at %ld\n", it);
+                errors++;
+                break;
+            }
+        }
+        std::printf("%-32s %zu bytes nmeaTIME, %zu bytes utc_us\n", "", sizeof(nmeaTIME), sizeof(long long));
+    }
+
+    std::printf("time: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+// bench_uring.cpp
+//
+// Input cost of 1M sentences through local pipes and socketpairs: the
+// std::getline(std::cin) loop LocationService started from, EventLoop with
+// read() per ready source and EventLoop with io_uring multishot reads, the
+// latter two also over 64 sources at once. Every consumer runs in a child
+// process, once for its CPU time and once under ptrace to count its system
+// calls, and must hand over every line.
+
+#include "bench_common.h"
+#include "EventLoop.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <signal.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+enum Consumer
+{
+    kStdin,
+    kEventLoopRead,
+    kEventLoopUring
+};
+
+static const char *const consumerNames[] = { "std::getline(std::cin)", "EventLoop read()", "EventLoop io_uring" };
+
+struct Result
+{
+    bool ok;
+    double cpuSeconds;
+    double seconds;
+    unsigned long long syscalls;
+    unsigned long long reads;
+    unsigned long long waits;
+    unsigned long long enters;
+};
+
+static bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t nwritten = write(fd, data, size);
+        if (nwritten <= 0)
+            return false;
+        data += nwritten;
+        size -= nwritten;
+    }
+    return true;
+}
+
+// Child side: reads every source to its end, exit code 0 when all lines arrived
+static int consume(Consumer consumer, const std::vector<int> &fds, unsigned long long expectedLines)
+{
+    OutputBuffer sink(open("/dev/null", O_WRONLY));
+
+    if (consumer == kStdin)
+    {
+        // Line loop of the original daemon, without the echo
+        dup2(fds[0], STDIN_FILENO);
+        close(fds[0]);
+        LocationService service;
+        service.setOutput(&sink);
+        std::string input;
+        unsigned long long lines = 0;
+        while (std::getline(std::cin, input))
+        {
+            input += '\n';
+            service.parseNMEAMessage(input);
+            lines++;
+        }
+        return lines == expectedLines ? 0 : 1;
+    }
+
+    EventLoop loop(sink);
+    loop.setQuiet(true);
+    if (consumer == kEventLoopUring && !loop.enableUring())
+        return 2;
+    for (int fd : fds)
+        loop.addSource(fd, "bench");
+    loop.run();
+    return loop.lineCount() == expectedLines ? 0 : 1;
+}
+
+// Counts system calls of a stopped PTRACE_TRACEME child until it exits, returns its wait status
+static int traceSyscalls(pid_t child, Result &result)
+{
+    int status = 0;
+    waitpid(child, &status, 0);
+    ptrace(PTRACE_SETOPTIONS, child, 0, PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL);
+
+    int signal = 0;
+    while (ptrace(PTRACE_SYSCALL, child, 0, signal) == 0 && waitpid(child, &status, 0) == child && WIFSTOPPED(status))
+    {
+        signal = 0;
+        if (WSTOPSIG(status) != (SIGTRAP | 0x80))
+        {
+            signal = WSTOPSIG(status) == SIGSTOP ? 0 : WSTOPSIG(status);
+            continue;
+        }
+        struct __ptrace_syscall_info info;
+        if (ptrace(PTRACE_GET_SYSCALL_INFO, child, sizeof(info), &info) <= 0 || info.op != PTRACE_SYSCALL_INFO_ENTRY)
+            continue;
+        result.syscalls++;
+        if (info.entry.nr == SYS_read || info.entry.nr == SYS_recvfrom)
+            result.reads++;
+        else if (info.entry.nr == SYS_epoll_wait || info.entry.nr == SYS_epoll_pwait)
+            result.waits++;
+        else if (info.entry.nr == SYS_io_uring_enter)
+            result.enters++;
+    }
+    return status;
+}
+
+// Producer process writes stream to every source in turns, consumer process reads them
+static Result run(Consumer consumer, bool socket, int sourceCount, const std::string &stream, long lines, bool trace)
+{
+    Result result = {};
+    std::vector<int> readFds, writeFds;
+    for (int it = 0; it < sourceCount; ++it)
+    {
+        int fds[2];
+        if ((socket ? socketpair(AF_UNIX, SOCK_STREAM, 0, fds) : pipe(fds)) != 0)
+            return result;
+        readFds.push_back(fds[0]);
+        writeFds.push_back(fds[1]);
+    }
+
+    std::fflush(stdout);
+    BenchTimer timer;
+    const pid_t child = fork();
+    if (child == 0)
+    {
+        for (int fd : writeFds)
+            close(fd);
+        if (trace)
+        {
+            ptrace(PTRACE_TRACEME, 0, 0, 0);
+            raise(SIGSTOP);
+        }
+        _exit(consume(consumer, readFds, static_cast<unsigned long long>(lines) * sourceCount));
+    }
+    for (int fd : readFds)
+        close(fd);
+
+    const pid_t producer = fork();
+    if (producer == 0)
+    {
+        const size_t chunk = 16 * 1024;
+        bool ok = true;
+        for (size_t done = 0; ok && done < stream.size(); done += chunk)
+            for (int fd : writeFds)
+                ok = ok && writeAll(fd, stream.data() + done, std::min(chunk, stream.size() - done));
+        _exit(ok ? 0 : 1);
+    }
+    for (int fd : writeFds)
+        close(fd);
+
+    int status = 0, producerStatus = 0;
+    struct rusage usage = {};
+    if (child > 0 && trace)
+        status = traceSyscalls(child, result);
+    else if (child < 0 || wait4(child, &status, 0, &usage) != child)
+        return result;
+    if (producer < 0 || waitpid(producer, &producerStatus, 0) != producer)
+        return result;
+    result.seconds = timer.seconds();
+    result.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+                        usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+    result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                WIFEXITED(producerStatus) && WEXITSTATUS(producerStatus) == 0;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    const long sentences = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    const bool uringAvailable = UringReader().valid();
+    int errors = 0;
+
+    struct Case
+    {
+        Consumer consumer;
+        bool socket;
+        int sources;
+    };
+    const Case cases[] = {
+        { kStdin, false, 1 }, { kEventLoopRead, false, 1 }, { kEventLoopUring, false, 1 },
+        { kStdin, true, 1 }, { kEventLoopRead, true, 1 }, { kEventLoopUring, true, 1 },
+        { kEventLoopRead, true, 64 }, { kEventLoopUring, true, 64 },
+    };
+
+    std::printf("%-28s %-24s %10s %9s %9s %9s %9s %10s\n", "per 1M sentences", "consumer",
+                "syscalls", "read", "epoll", "uring", "cpu ms", "wall ms");
+    for (const Case &c : cases)
+    {
+        if (c.consumer == kEventLoopUring && !uringAvailable)
+        {
+            std::printf("io_uring not available, skipped\n");
+            continue;
+        }
+        const long lines = sentences / c.sources;
+        const std::string stream = benchMakeStream(lines);
+        const Result timed = run(c.consumer, c.socket, c.sources, stream, lines, false);
+        const Result traced = run(c.consumer, c.socket, c.sources, stream, lines, true);
+        if (!timed.ok || !traced.ok)
+        {
+            std::printf("%s over %s lost lines\n", consumerNames[c.consumer], c.socket ? "socketpair" : "pipe");
+            errors++;
+            continue;
+        }
+
+        const double scale = 1e6 / (static_cast<double>(lines) * c.sources);
+        char transport[64];
+        std::snprintf(transport, sizeof(transport), "%d %s", c.sources, c.socket ? "socketpair(s)" : "pipe");
+        std::printf("%-28s %-24s %10.0f %9.0f %9.0f %9.0f %9.1f %10.1f\n", transport, consumerNames[c.consumer],
+                    traced.syscalls * scale, traced.reads * scale, traced.waits * scale, traced.enters * scale,
+                    timed.cpuSeconds * 1e3 * scale, timed.seconds * 1e3 * scale);
+    }
+
+    std::printf("uring: %d errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
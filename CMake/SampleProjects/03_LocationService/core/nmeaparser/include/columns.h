@@ -0,0 +1,64 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file */
+
+#ifndef __NMEA_COLUMNS_H__
+#define __NMEA_COLUMNS_H__
+
+#include "parser.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define NMEA_DEF_COLUMNS    (1024)      /**< Default initial capacity of fix columns */
+
+/**
+ * Decoded fixes stored column by column (struct of arrays)
+ * One row is kept per epoch: GGA and RMC of the same UTC time update the
+ * same row. Values which are not reported by packets of the epoch are
+ * carried from previous row, the same way as by nmeaINFO.
+ */
+typedef struct _nmeaFIXCOLUMNS
+{
+    int     size;       /**< Capacity of every column (rows) */
+    int     use;        /**< Number of filled rows */
+
+    long long *utc_us;  /**< Microseconds since 1970-01-01 00:00:00 UTC */
+    double  *lat;       /**< Latitude in NDEG - +/-[degree][min].[sec/60] */
+    double  *lon;       /**< Longitude in NDEG - +/-[degree][min].[sec/60] */
+    double  *elv;       /**< Antenna altitude above/below mean sea level (geoid) in meters */
+    double  *speed;     /**< Speed over the ground in kilometers/hour */
+    double  *direction; /**< Track angle in degrees True */
+    int     *sig;       /**< GPS quality indicator (0 = Invalid; 1 = Fix; 2 = Differential, 3 = Sensitive) */
+
+    long long utc_day;  /**< Midnight of last reported date in microseconds since 1970-01-01 */
+    long long utc_tod;  /**< Time of day of last row in microseconds */
+
+} nmeaFIXCOLUMNS;
+
+int     nmea_columns_init(nmeaFIXCOLUMNS *cols, int size);
+void    nmea_columns_destroy(nmeaFIXCOLUMNS *cols);
+int     nmea_columns_reserve(nmeaFIXCOLUMNS *cols, int size);
+void    nmea_columns_clear(nmeaFIXCOLUMNS *cols);
+
+int     nmea_columns_append(nmeaFIXCOLUMNS *cols, int ptype, const void *pack);
+void    nmea_columns_degrees(nmeaFIXCOLUMNS *cols, double *lat_deg, double *lon_deg);
+
+int     nmea_parse_columns(
+        nmeaPARSER *parser,
+        const char *buff, int buff_sz,
+        nmeaFIXCOLUMNS *cols
+        );
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __NMEA_COLUMNS_H__ */
@@ -41,6 +41,16 @@
 # define NMEA_INLINE    inline
 #endif
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   define NMEA_SIMD_X86
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#   define NMEA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#   define NMEA_UNLIKELY(x) (x)
+#endif
+
 #if !defined(NDEBUG) && !defined(NMEA_CE)
 #   include <assert.h>
 #   define NMEA_ASSERT(x)   assert(x)
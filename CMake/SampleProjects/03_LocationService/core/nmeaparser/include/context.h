@@ -15,6 +15,8 @@
 
 #define NMEA_DEF_PARSEBUFF  (1024)
 #define NMEA_MIN_PARSEBUFF  (256)
+#define NMEA_DEF_PARSEQUEUE (64)
+#define NMEA_MIN_PARSEQUEUE (8)
 
 #ifdef  __cplusplus
 extern "C" {
@@ -28,10 +30,64 @@ typedef struct _nmeaPROPERTY
     nmeaTraceFunc   trace_func;
     nmeaErrorFunc   error_func;
     int             parse_buff_size;
+    int             parse_queue_size;
 
 } nmeaPROPERTY;
 
+/**
+ * Codes of parser errors, the text is made only by nmea_error_format
+ */
+enum nmeaERRCODE
+{
+    NMEA_ERR_NONE = 0,
+    NMEA_ERR_CRC,           /**< Control sum does not match, sentence skipped */
+    NMEA_ERR_TYPE,          /**< Talker or sentence type not registered, sentence skipped */
+    NMEA_ERR_FIELDS,        /**< Field can not be decoded or is missing */
+    NMEA_ERR_TIME,          /**< Time field is not hhmmss[.s[s[s]]] */
+    NMEA_ERR_FORMAT,        /**< Fields decoded, but a fixed field (e.g. unit) is wrong */
+    NMEA_ERR_BUFF_OVERFLOW, /**< Incomplete sentence longer than parser buffer dropped */
+    NMEA_ERR_QUEUE_OVERFLOW,/**< Packets queue full, oldest packet dropped */
+
+    NMEA_ERR_LAST
+};
+
+/**
+ * Error reported by parser to its sink
+ */
+typedef struct _nmeaERROR
+{
+    int     code;           /**< Error code (nmeaERRCODE) */
+    int     ptype;          /**< Packet type (nmeaPACKTYPE), GPNON when unknown */
+    int     field;          /**< Index of first field not decoded, -1 - error is not about a field */
+    long long offset;       /**< Offset of sentence in the stream pushed into parser, -1 - unknown */
+    const char *sentence;   /**< Sentence bytes, valid during sink call only, 0 - none */
+    int     sentence_sz;    /**< Number of sentence bytes */
+    unsigned long dropped;  /**< Errors dropped by the rate limit since previous report */
+
+} nmeaERROR;
+
+typedef void (*nmeaErrorSink)(void *user, const nmeaERROR *error);
+
+/**
+ * Configuration of one parser, defaults come from nmea_property()
+ * @see nmea_parser_init_config
+ */
+typedef struct _nmeaPARSERCONFIG
+{
+    int     parse_buff_size;
+    int     parse_queue_size;
+    nmeaTraceFunc trace_func;   /**< Every sentence of registered type, 0 - none */
+    nmeaErrorSink error_sink;   /**< Parser errors, 0 - none */
+    void    *error_user;        /**< First argument of error_sink */
+    int     error_rate;         /**< Errors reported per second, the rest only counted, 0 - no limit */
+
+} nmeaPARSERCONFIG;
+
 nmeaPROPERTY * nmea_property();
+void nmea_parser_config(nmeaPARSERCONFIG *config);
+
+const char * nmea_error_str(int code);
+int  nmea_error_format(const nmeaERROR *error, char *buff, int buff_sz);
 
 void nmea_trace(const char *str, ...);
 void nmea_trace_buff(const char *buff, int buff_size);
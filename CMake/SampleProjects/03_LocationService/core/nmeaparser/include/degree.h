@@ -0,0 +1,93 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file */
+
+#ifndef __NMEA_DEGREE_H__
+#define __NMEA_DEGREE_H__
+
+#include "config.h"
+#include "gmath.h"
+
+/*
+ * Inline degree conversions for per fix hot paths. They have no branches
+ * and no library calls, so loops over them are vectorized by compiler.
+ * Division by 60 is replaced by multiplication, results may differ from
+ * nmea_ndeg2degree and friends in the last bit.
+ */
+
+#define NMEA_UDEG_SCALE     (1000000)   /**< Micro-degrees in one degree */
+#define NMEA_UDEG_MAX       (2147483647.0)  /**< Micro-degrees are saturated to int range */
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Convert NDEG (NMEA degree) to fractional degree
+ */
+static NMEA_INLINE double nmea_fast_ndeg2degree(double val)
+{
+    double deg = (double)(int)(val / 100);
+    return deg + (val - deg * 100) * (1.0 / 60);
+}
+
+/**
+ * \brief Convert fractional degree to NDEG (NMEA degree)
+ */
+static NMEA_INLINE double nmea_fast_degree2ndeg(double val)
+{
+    double deg = (double)(int)val;
+    return deg * 100 + (val - deg) * 60;
+}
+
+/**
+ * \brief Convert NDEG (NMEA degree) to radian
+ */
+static NMEA_INLINE double nmea_fast_ndeg2radian(double val)
+{ return nmea_fast_ndeg2degree(val) * NMEA_PI180; }
+
+/**
+ * \brief Convert radian to NDEG (NMEA degree)
+ */
+static NMEA_INLINE double nmea_fast_radian2ndeg(double val)
+{ return nmea_fast_degree2ndeg(val * (1 / NMEA_PI180)); }
+
+/**
+ * \brief Convert fractional degree to micro-degrees, rounded to nearest
+ */
+static NMEA_INLINE int nmea_fast_degree2udeg(double val)
+{
+    val = val * NMEA_UDEG_SCALE + ((val < 0)?-0.5:0.5);
+    val = (val > NMEA_UDEG_MAX)?NMEA_UDEG_MAX:val;
+    return (int)((val < -NMEA_UDEG_MAX)?-NMEA_UDEG_MAX:val);
+}
+
+/**
+ * \brief Convert NDEG (NMEA degree) to micro-degrees, rounded to nearest
+ */
+static NMEA_INLINE int nmea_fast_ndeg2udeg(double val)
+{ return nmea_fast_degree2udeg(nmea_fast_ndeg2degree(val)); }
+
+/**
+ * \brief Convert micro-degrees to fractional degree
+ */
+static NMEA_INLINE double nmea_fast_udeg2degree(int val)
+{ return val * (1.0 / NMEA_UDEG_SCALE); }
+
+/**
+ * \brief Convert micro-degrees to radian
+ */
+static NMEA_INLINE double nmea_fast_udeg2radian(int val)
+{ return val * (NMEA_PI180 / NMEA_UDEG_SCALE); }
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __NMEA_DEGREE_H__ */
@@ -0,0 +1,77 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file */
+
+#ifndef __NMEA_EPOCH_H__
+#define __NMEA_EPOCH_H__
+
+#include "info.h"
+#include "sentence.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define NMEA_DEF_EPOCH_MASK     (0)             /**< Default packets completing an epoch early, none */
+#define NMEA_DEF_EPOCH_TIMEOUT  (1500)          /**< Default milliseconds an epoch waits for the next one */
+
+/**
+ * Assembler of the sentences of one receiver epoch into one fix
+ * Packets of an epoch share UTC time of GGA/RMC, GSV sequences are buffered
+ * until their last packet arrived and merged at once. The epoch is handed
+ * over once, when the next epoch starts, the timeout expires or the stream
+ * ends. Next epoch starts with:
+ * - GGA/RMC of other time of day,
+ * - second GGA, RMC or VTG, or first GSV packet of a talker already completed.
+ * With a mask of required packets the epoch is handed over as soon as it
+ * holds all of them (and no GSV sequence is in progress), a fix earlier by
+ * the epoch period. The mask has to list every packet the receiver sends
+ * in an epoch: packets arriving after the epoch was handed over (late) are
+ * counted and dropped, they reach neither that fix nor the next one.
+ * Values not reported in an epoch are carried from previous ones, the same
+ * way as by nmeaINFO.
+ */
+typedef struct _nmeaEPOCH
+{
+    int     require;    /**< Packets (mask) completing an epoch early, 0 - closed by next epoch, timeout or flush */
+    int     timeout;    /**< Milliseconds an epoch waits for the next one after its first GGA/RMC, 0 - forever */
+
+    nmeaINFO info;      /**< Current epoch, smask has packets received in it */
+    long long tod;      /**< Time of day of current epoch in microseconds, -1 unknown */
+    int     packets;    /**< Packets received in current epoch (buffered GSV included) */
+    int     emitted;    /**< Current epoch was handed over */
+    long long start_ms; /**< Time of first GGA/RMC of current epoch (timeout start), by clock of caller */
+
+    nmeaINFO fix;       /**< Closed epoch waiting for nmea_epoch_pop */
+    int     ready;      /**< fix holds closed epoch */
+
+    nmeaGPGSV gsv[NMEA_NSATPACKS]; /**< Packets of GSV sequence in progress */
+    int     gsv_use;    /**< Number of buffered GSV packets, 0 - no sequence in progress */
+    int     gsv_done;   /**< Talkers (bits of nmeaTALKER) with complete GSV sequence in current epoch */
+
+    unsigned long epochs;   /**< Handed over epochs */
+    unsigned long partial;  /**< Epochs handed over without GGA or without RMC */
+    unsigned long timeouts; /**< Epochs handed over by timeout */
+    unsigned long late;     /**< Packets arrived after their epoch was handed over, dropped */
+    unsigned long broken;   /**< GSV packets dropped from incomplete or out of order sequences */
+
+} nmeaEPOCH;
+
+void    nmea_epoch_init(nmeaEPOCH *epoch, int require, int timeout_ms);
+int     nmea_epoch_push(nmeaEPOCH *epoch, int ptype, const void *pack, long long now_ms);
+int     nmea_epoch_poll(nmeaEPOCH *epoch, long long now_ms);
+int     nmea_epoch_flush(nmeaEPOCH *epoch);
+const nmeaINFO *nmea_epoch_pop(nmeaEPOCH *epoch);
+int     nmea_epoch_pending(const nmeaEPOCH *epoch);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __NMEA_EPOCH_H__ */
@@ -17,6 +17,27 @@
 extern "C" {
 #endif
 
+/*
+ * random
+ */
+
+/**
+ * State of xoshiro256** pseudo random sequence
+ * nmea_random draws from a state of the calling thread, so generators of
+ * different threads neither share nor lock one sequence.
+ */
+typedef struct _nmeaRANDOM
+{
+    unsigned long long s[4];
+
+} nmeaRANDOM;
+
+void    nmea_random_seed(nmeaRANDOM *rnd, unsigned long long seed);
+unsigned long long nmea_random_next(nmeaRANDOM *rnd);
+double  nmea_random_from(nmeaRANDOM *rnd, double min, double max);
+nmeaRANDOM * nmea_random_thread(void);
+double  nmea_random(double min, double max);
+
 /*
  * high level
  */
@@ -46,6 +67,40 @@ int     nmea_generate_from(
         int generate_mask           /* mask of sentence`s (e.g. GPGGA | GPGSA) */
         );
 
+/*
+ * seeded context
+ */
+
+/**
+ * Reproducible generation of one device: own random sequence and virtual clock
+ * Epoch k is stamped start_ms + k * interval, so a (seed, device, epoch)
+ * triple gets the same bytes on every run, thread and machine.
+ * @see nmea_generate_ctx
+ */
+typedef struct _nmeaGENCONTEXT
+{
+    nmeaRANDOM rnd;         /**< Random sequence of the device */
+    long long start_ms;     /**< Virtual time of epoch 0 in milliseconds since 1970-01-01 UTC */
+    int     interval;       /**< Milliseconds between epochs */
+    unsigned long epoch;    /**< Next epoch */
+
+} nmeaGENCONTEXT;
+
+void    nmea_gen_context_init(
+        nmeaGENCONTEXT *ctx,
+        unsigned long long seed, unsigned long long device,
+        long long start_ms, int interval_ms
+        );
+long long nmea_gen_context_time(const nmeaGENCONTEXT *ctx, nmeaTIME *utc);
+
+int     nmea_generate_ctx(
+        char *buff, int buff_sz,    /* buffer */
+        nmeaINFO *info,             /* source info */
+        struct _nmeaGENERATOR *gen, /* generator */
+        nmeaGENCONTEXT *ctx,        /* random sequence and clock of the device */
+        int generate_mask           /* mask of sentence`s (e.g. GPGGA | GPGSA) */
+        );
+
 /*
  * low level
  */
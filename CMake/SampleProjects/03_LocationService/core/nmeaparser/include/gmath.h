@@ -13,6 +13,8 @@
 
 #include "info.h"
 
+#include <stddef.h>
+
 #define NMEA_PI                     (3.141592653589793)             /**< PI value */
 #define NMEA_PI180                  (NMEA_PI / 180)                 /**< PI division by 180 */
 #define NMEA_EARTHRADIUS_KM         (6378)                          /**< Earth's mean radius in km */
@@ -43,6 +45,15 @@ double nmea_degree2ndeg(double val);
 double nmea_ndeg2radian(double val);
 double nmea_radian2ndeg(double val);
 
+void nmea_ndeg2degree_batch(const double *ndeg, double *deg, int count);
+void nmea_degree2ndeg_batch(const double *deg, double *ndeg, int count);
+void nmea_degree2radian_batch(const double *deg, double *rad, int count);
+void nmea_ndeg2radian_batch(const double *ndeg, double *rad, int count);
+void nmea_radian2ndeg_batch(const double *rad, double *ndeg, int count);
+
+void nmea_ndeg2udeg_batch(const double *ndeg, int *udeg, int count);
+void nmea_udeg2degree_batch(const int *udeg, double *deg, int count);
+
 /*
  * DOP
  */
@@ -70,6 +81,22 @@ double  nmea_distance_ellipsoid(
         double *to_azimuth
         );
 
+void    nmea_distance_batch(
+        const nmeaPOS *from_pos,
+        const nmeaPOS *to_pos,
+        double *dist,
+        size_t count
+        );
+
+void    nmea_distance_ellipsoid_batch(
+        const nmeaPOS *from_pos,
+        const nmeaPOS *to_pos,
+        double *dist,
+        double *from_azimuth,
+        double *to_azimuth,
+        size_t count
+        );
+
 int     nmea_move_horz(
         const nmeaPOS *start_pos,
         nmeaPOS *end_pos,
@@ -24,8 +24,9 @@
 #define NMEA_FIX_2D         (2)
 #define NMEA_FIX_3D         (3)
 
-#define NMEA_MAXSAT         (12)
+#define NMEA_MAXSAT         (64)
 #define NMEA_SATINPACK      (4)
+#define NMEA_PRNINPACK      (12)
 #define NMEA_NSATPACKS      (NMEA_MAXSAT / NMEA_SATINPACK)
 
 #define NMEA_DEF_LAT        (5001.2621)
@@ -57,6 +58,7 @@ typedef struct _nmeaSATELLITE
     int     elv;        /**< Elevation in degrees, 90 maximum */
     int     azimuth;    /**< Azimuth, degrees from true north, 000 to 359 */
     int     sig;        /**< Signal, 00-99 dB */
+    int     talker;     /**< Constellation which reported satellite (nmeaTALKER) */
 
 } nmeaSATELLITE;
 
@@ -68,7 +70,7 @@ typedef struct _nmeaSATELLITE
 typedef struct _nmeaSATINFO
 {
     int     inuse;      /**< Number of satellites in use (not those in view) */
-    int     inview;     /**< Total number of satellites in view */
+    int     inview;     /**< Total number of satellites in view (of all constellations) */
     nmeaSATELLITE sat[NMEA_MAXSAT]; /**< Satellites information */
 
 } nmeaSATINFO;
@@ -84,6 +86,7 @@ typedef struct _nmeaINFO
     int     smask;      /**< Mask specifying types of packages from which data have been obtained */
 
     nmeaTIME utc;       /**< UTC of position */
+    long long utc_us;   /**< UTC of position in microseconds since 1970-01-01, GGA updates time of day only */
 
     int     sig;        /**< GPS quality indicator (0 = Invalid; 1 = Fix; 2 = Differential, 3 = Sensitive) */
     int     fix;        /**< Operating mode, used for navigation (1 = Fix not available; 2 = 2D; 3 = 3D) */
@@ -14,6 +14,7 @@
 #include "./config.h"
 #include "./units.h"
 #include "./gmath.h"
+#include "./degree.h"
 #include "./info.h"
 #include "./sentence.h"
 #include "./generate.h"
@@ -21,5 +22,9 @@
 #include "./parse.h"
 #include "./parser.h"
 #include "./context.h"
+#include "./replay.h"
+#include "./columns.h"
+#include "./epoch.h"
+#include "./stats.h"
 
 #endif /* __NMEA_H__ */
@@ -19,8 +19,13 @@
 extern "C" {
 #endif
 
+#define NMEA_TIME_SEC_US    (1000000LL)                     /**< Microseconds in a second */
+#define NMEA_TIME_DAY_US    (86400LL * NMEA_TIME_SEC_US)    /**< Microseconds in a day */
+
 /**
  * Date and time data
+ * Compact form of the same time is a long long of microseconds since
+ * 1970-01-01 00:00:00 UTC (nmea_time_to_us), compared and sorted as integer.
  * @see nmea_time_now
  */
 typedef struct _nmeaTIME
@@ -39,6 +44,11 @@ typedef struct _nmeaTIME
  * \brief Get time now to nmeaTIME structure
  */
 void nmea_time_now(nmeaTIME *t);
+long long nmea_time_now_us(void);
+
+long long nmea_time_days(int year, int mon, int day);
+long long nmea_time_to_us(const nmeaTIME *t);
+void nmea_time_from_us(long long us, nmeaTIME *t);
 
 #ifdef  __cplusplus
 }
@@ -18,19 +18,29 @@ extern "C" {
 #endif
 
 int nmea_pack_type(const char *buff, int buff_sz);
+int nmea_talker_type(const char *buff, int buff_sz);
 int nmea_find_tail(const char *buff, int buff_sz, int *res_crc);
 
+int nmea_parse_pack(int ptype, const char *buff, int buff_sz, void *pack, int *field);
+
 int nmea_parse_GPGGA(const char *buff, int buff_sz, nmeaGPGGA *pack);
 int nmea_parse_GPGSA(const char *buff, int buff_sz, nmeaGPGSA *pack);
 int nmea_parse_GPGSV(const char *buff, int buff_sz, nmeaGPGSV *pack);
 int nmea_parse_GPRMC(const char *buff, int buff_sz, nmeaGPRMC *pack);
 int nmea_parse_GPVTG(const char *buff, int buff_sz, nmeaGPVTG *pack);
 
+int nmea_scanf_GPGGA(const char *buff, int buff_sz, nmeaGPGGA *pack);
+int nmea_scanf_GPGSA(const char *buff, int buff_sz, nmeaGPGSA *pack);
+int nmea_scanf_GPGSV(const char *buff, int buff_sz, nmeaGPGSV *pack);
+int nmea_scanf_GPRMC(const char *buff, int buff_sz, nmeaGPRMC *pack);
+int nmea_scanf_GPVTG(const char *buff, int buff_sz, nmeaGPVTG *pack);
+
 void nmea_GPGGA2info(nmeaGPGGA *pack, nmeaINFO *info);
 void nmea_GPGSA2info(nmeaGPGSA *pack, nmeaINFO *info);
 void nmea_GPGSV2info(nmeaGPGSV *pack, nmeaINFO *info);
 void nmea_GPRMC2info(nmeaGPRMC *pack, nmeaINFO *info);
 void nmea_GPVTG2info(nmeaGPVTG *pack, nmeaINFO *info);
+void nmea_pack2info(int ptype, void *pack, nmeaINFO *info);
 
 #ifdef  __cplusplus
 }
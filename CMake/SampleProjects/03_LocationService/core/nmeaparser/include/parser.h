@@ -12,6 +12,8 @@
 #define __NMEA_PARSER_H__
 
 #include "info.h"
+#include "sentence.h"
+#include "context.h"
 
 #ifdef  __cplusplus
 extern "C" {
@@ -21,17 +23,54 @@ extern "C" {
  * high level
  */
 
+/**
+ * Storage of any packet type which parser can keep into queue
+ */
+typedef union _nmeaParserPACK
+{
+    nmeaGPGGA gga;
+    nmeaGPGSA gsa;
+    nmeaGPGSV gsv;
+    nmeaGPRMC rmc;
+    nmeaGPVTG vtg;
+
+} nmeaParserPACK;
+
+/**
+ * Slot of the preallocated packets queue (ring buffer)
+ */
+typedef struct _nmeaParserNODE
+{
+    int packType;
+    nmeaParserPACK pack;
+
+} nmeaParserNODE;
+
 typedef struct _nmeaPARSER
 {
-    void *top_node;
-    void *end_node;
+    void *queue;
+    int queue_size;
+    int queue_top;
+    int queue_use;
     unsigned char *buffer;
     int buff_size;
     int buff_use;
 
+    long long stream_pos;       /**< Bytes taken from the stream by previous pushes */
+    long long buff_pos;         /**< Stream offset of the sentence kept in buffer */
+
+    nmeaTraceFunc trace_func;   /**< Per parser trace and error sink (nmeaPARSERCONFIG) */
+    nmeaErrorSink error_sink;
+    void *error_user;
+    int error_rate;
+    long long error_second;     /**< Second of the rate limit window */
+    int error_count;            /**< Errors reported in the window */
+    unsigned long error_dropped;/**< Errors dropped since previous report */
+
 } nmeaPARSER;
 
 int     nmea_parser_init(nmeaPARSER *parser);
+int     nmea_parser_init_config(nmeaPARSER *parser, const nmeaPARSERCONFIG *config);
 void    nmea_parser_destroy(nmeaPARSER *parser);
 
 int     nmea_parse(
@@ -45,6 +84,7 @@ int     nmea_parse(
  */
 
 int     nmea_parser_push(nmeaPARSER *parser, const char *buff, int buff_sz);
+int     nmea_parser_real_push(nmeaPARSER *parser, const char *buff, int buff_sz);
 int     nmea_parser_top(nmeaPARSER *parser);
 int     nmea_parser_pop(nmeaPARSER *parser, void **pack_ptr);
 int     nmea_parser_peek(nmeaPARSER *parser, void **pack_ptr);
@@ -0,0 +1,80 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file */
+
+#ifndef __NMEA_REPLAY_H__
+#define __NMEA_REPLAY_H__
+
+#include "parser.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define NMEA_PARALLEL_MINCHUNK  (1 << 16)   /**< Min size of log chunk decoded by one worker */
+#define NMEA_PARALLEL_MAXCHUNK  (1 << 22)   /**< Max size of log chunk decoded by one worker */
+#define NMEA_PARALLEL_MAXTHREAD (256)
+
+/**
+ * Callback for every decoded packet of replayed log
+ * @param ptype type of packet (nmeaPACKTYPE).
+ * @param pack a pointer of packet structure (valid only during call).
+ * @param info summary information with this packet already merged.
+ * @param user_data pointer given to replay function.
+ * @return 1 (true) - continue replay or 0 (false) - stop replay.
+ */
+typedef int (*nmeaReplayFunc)(int ptype, const void *pack, const nmeaINFO *info, void *user_data);
+
+/**
+ * Statistic of log replay
+ */
+typedef struct _nmeaREPLAYSTAT
+{
+    long long   bytes;              /**< Number of bytes of log processed */
+    long long   sentences;          /**< Number of decoded packets */
+    double      seconds;            /**< Wall time spent by replay */
+    double      bytes_per_sec;      /**< Throughput in bytes */
+    double      sentences_per_sec;  /**< Throughput in decoded packets */
+
+} nmeaREPLAYSTAT;
+
+int     nmea_parse_mapped(
+        nmeaPARSER *parser,
+        const char *buff, long long buff_sz,
+        nmeaINFO *info,
+        nmeaReplayFunc func, void *user_data,
+        nmeaREPLAYSTAT *stat
+        );
+
+int     nmea_parse_file(
+        const char *path,
+        nmeaINFO *info,
+        nmeaReplayFunc func, void *user_data,
+        nmeaREPLAYSTAT *stat
+        );
+
+int     nmea_parse_file_fixes(
+        const char *path,
+        nmeaINFO *fixes, int fixes_sz,
+        nmeaREPLAYSTAT *stat
+        );
+
+int     nmea_parse_parallel(
+        const char *buff, long long buff_sz,
+        nmeaINFO *info,
+        int nthreads,
+        nmeaReplayFunc func, void *user_data,
+        nmeaREPLAYSTAT *stat
+        );
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __NMEA_REPLAY_H__ */
@@ -32,16 +32,34 @@ enum nmeaPACKTYPE
     GPVTG   = 0x0010    /**< VTG - Actual track made good and speed over ground. */
 };
 
+/**
+ * Talkers (constellations) of NMEA sentences, packets of any of them are
+ * parsed into the same nmeaPACKTYPE
+ */
+enum nmeaTALKER
+{
+    NMEA_TALKER_GP  = 0,    /**< GP - GPS */
+    NMEA_TALKER_GN  = 1,    /**< GN - Combined GNSS solution */
+    NMEA_TALKER_GL  = 2,    /**< GL - GLONASS */
+    NMEA_TALKER_GA  = 3,    /**< GA - Galileo */
+    NMEA_TALKER_BD  = 4,    /**< BD - BeiDou */
+    NMEA_TALKER_GB  = 5,    /**< GB - BeiDou (NMEA 4.11) */
+    NMEA_TALKER_GQ  = 6     /**< GQ - QZSS */
+};
+
 /**
  * GGA packet information structure (Global Positioning System Fix Data)
  */
 typedef struct _nmeaGPGGA
 {
     nmeaTIME utc;       /**< UTC of position (just time) */
+    long long utc_us;   /**< Time of day in microseconds (date of GGA is 1970-01-01), as decoded with milliseconds */
 	double  lat;        /**< Latitude in NDEG - [degree][min].[sec/60] */
     char    ns;         /**< [N]orth or [S]outh */
 	double  lon;        /**< Longitude in NDEG - [degree][min].[sec/60] */
     char    ew;         /**< [E]ast or [W]est */
+    int     lat_udeg;   /**< Latitude in micro-degrees (decoded from text without floating point) */
+    int     lon_udeg;   /**< Longitude in micro-degrees (decoded from text without floating point) */
     int     sig;        /**< GPS quality indicator (0 = Invalid; 1 = Fix; 2 = Differential, 3 = Sensitive) */
 	int     satinuse;   /**< Number of satellites in use (not those in view) */
     double  HDOP;       /**< Horizontal dilution of precision */
@@ -61,10 +79,11 @@ typedef struct _nmeaGPGSA
 {
     char    fix_mode;   /**< Mode (M = Manual, forced to operate in 2D or 3D; A = Automatic, 3D/2D) */
     int     fix_type;   /**< Type, used for navigation (1 = Fix not available; 2 = 2D; 3 = 3D) */
-    int     sat_prn[NMEA_MAXSAT]; /**< PRNs of satellites used in position fix (null for unused fields) */
+    int     sat_prn[NMEA_PRNINPACK]; /**< PRNs of satellites used in position fix (null for unused fields) */
     double  PDOP;       /**< Dilution of precision */
     double  HDOP;       /**< Horizontal dilution of precision */
     double  VDOP;       /**< Vertical dilution of precision */
+    int     talker;     /**< Talker of sentence (nmeaTALKER) */
 
 } nmeaGPGSA;
 
@@ -77,6 +96,7 @@ typedef struct _nmeaGPGSV
     int     pack_index; /**< Message number */
     int     sat_count;  /**< Total number of satellites in view */
     nmeaSATELLITE sat_data[NMEA_SATINPACK];
+    int     talker;     /**< Talker of sentence (nmeaTALKER) */
 
 } nmeaGPGSV;
 
@@ -86,11 +106,14 @@ typedef struct _nmeaGPGSV
 typedef struct _nmeaGPRMC
 {
     nmeaTIME utc;       /**< UTC of position */
+    long long utc_us;   /**< UTC of position in microseconds since 1970-01-01, as decoded with milliseconds */
     char    status;     /**< Status (A = active or V = void) */
 	double  lat;        /**< Latitude in NDEG - [degree][min].[sec/60] */
     char    ns;         /**< [N]orth or [S]outh */
 	double  lon;        /**< Longitude in NDEG - [degree][min].[sec/60] */
     char    ew;         /**< [E]ast or [W]est */
+    int     lat_udeg;   /**< Latitude in micro-degrees (decoded from text without floating point) */
+    int     lon_udeg;   /**< Longitude in micro-degrees (decoded from text without floating point) */
     double  speed;      /**< Speed over the ground in knots */
     double  direction;  /**< Track angle in degrees True */
     double  declination; /**< Magnetic variation degrees (Easterly var. subtracts from true course) */
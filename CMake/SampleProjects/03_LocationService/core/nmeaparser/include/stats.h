@@ -0,0 +1,148 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file */
+
+#ifndef __NMEA_STATS_H__
+#define __NMEA_STATS_H__
+
+#include "config.h"
+
+#if defined(NMEA_STATS) && defined(NMEA_SIMD_X86)
+#   include <x86intrin.h>
+#elif defined(NMEA_STATS)
+#   include <time.h>
+#endif
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Stages of the way from receiver bytes to a published fix
+ */
+enum nmeaSTAGE
+{
+    NMEA_STAGE_READ     = 0,    /**< read() of receiver bytes (service) */
+    NMEA_STAGE_FRAME    = 1,    /**< nmea_find_tail, one sentence */
+    NMEA_STAGE_DECODE   = 2,    /**< type lookup and nmea_parse_GPxxx */
+    NMEA_STAGE_MERGE    = 3,    /**< nmea_GPxxx2info */
+    NMEA_STAGE_OUTPUT   = 4,    /**< report of a fix (service) */
+    NMEA_STAGE_LAST     = 5
+};
+
+/**
+ * Event counters
+ */
+enum nmeaCOUNTER
+{
+    NMEA_COUNT_SENTENCE         = 0,    /**< sentences decoded into packets */
+    NMEA_COUNT_CRC_FAIL         = 1,    /**< complete sentences with wrong control sum */
+    NMEA_COUNT_UNKNOWN_TYPE     = 2,    /**< sentences of unregistered talker or type */
+    NMEA_COUNT_DECODE_FAIL      = 3,    /**< sentences the decoder rejected */
+    NMEA_COUNT_BUFF_OVERFLOW    = 4,    /**< incomplete sentences dropped by full parser buffer */
+    NMEA_COUNT_QUEUE_OVERFLOW   = 5,    /**< packets dropped by full parser queue */
+    NMEA_COUNT_LAST             = 6
+};
+
+#define NMEA_HIST_SUBBITS   (4)     /**< Linear sub-buckets per power of two: 2^4, ~6% precision */
+#define NMEA_HIST_BUCKETS   ((64 - NMEA_HIST_SUBBITS + 1) << NMEA_HIST_SUBBITS)
+#define NMEA_DEF_SAMPLE     (16)    /**< Default stage timer sampling, one of every 16 events */
+
+/**
+ * Log-linear (HDR style) histogram of sampled durations in ticks
+ */
+typedef struct _nmeaHIST
+{
+    unsigned long long  count;
+    unsigned long long  sum;
+    unsigned long long  max;
+    unsigned long long  bucket[NMEA_HIST_BUCKETS];
+
+} nmeaHIST;
+
+/**
+ * Copy of all stage histograms and counters
+ */
+typedef struct _nmeaSTATS
+{
+    double              ns_per_tick;    /**< Tick duration, TSC or nanoseconds of CLOCK_MONOTONIC */
+    nmeaHIST            stage[NMEA_STAGE_LAST];
+    unsigned long long  counter[NMEA_COUNT_LAST];
+
+} nmeaSTATS;
+
+extern int nmea_stats_on;
+
+int     nmea_stats_compiled(void);
+void    nmea_stats_enable(int enable);
+void    nmea_stats_sample(int interval);
+unsigned long long nmea_stats_begin(int stage);
+void    nmea_stats_record(int stage, unsigned long long ticks);
+void    nmea_stats_count(int counter);
+void    nmea_stats_snapshot(nmeaSTATS *stats);
+void    nmea_stats_reset(void);
+double  nmea_stats_percentile(const nmeaSTATS *stats, int stage, double percent);
+double  nmea_stats_mean(const nmeaSTATS *stats, int stage);
+int     nmea_stats_dump(char *buff, int buff_sz);
+
+const char *nmea_stats_stage_name(int stage);
+const char *nmea_stats_counter_name(int counter);
+
+#ifdef NMEA_STATS
+
+/**
+ * \brief Timestamp for stage timers (TSC on x86, nanoseconds elsewhere)
+ */
+static NMEA_INLINE unsigned long long nmea_stats_ticks(void)
+{
+#ifdef NMEA_SIMD_X86
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+/**
+ * Events of every stage left until the next sampled one, per thread
+ */
+extern __thread int nmea_stats_countdown[NMEA_STAGE_LAST] __attribute__((tls_model("initial-exec")));
+
+/**
+ * \brief Start of a stage event, the library is only called for sampled events
+ * @return Ticks when the event is sampled, 0 otherwise.
+ */
+static NMEA_INLINE unsigned long long nmea_stats_start(int stage)
+{
+    if(!__atomic_load_n(&nmea_stats_on, __ATOMIC_RELAXED) || --nmea_stats_countdown[stage] > 0)
+        return 0;
+    return nmea_stats_begin(stage);
+}
+
+#   define NMEA_STATS_START(var, stage) \
+        unsigned long long var = nmea_stats_start(stage)
+#   define NMEA_STATS_STOP(stage, var) \
+        do { if(var) nmea_stats_record((stage), nmea_stats_ticks() - (var)); } while(0)
+#   define NMEA_STATS_COUNT(counter) \
+        do { if(__atomic_load_n(&nmea_stats_on, __ATOMIC_RELAXED)) nmea_stats_count(counter); } while(0)
+
+#else /* NMEA_STATS */
+
+#   define NMEA_STATS_START(var, stage) do { } while(0)
+#   define NMEA_STATS_STOP(stage, var)  do { } while(0)
+#   define NMEA_STATS_COUNT(counter)    do { } while(0)
+
+#endif /* NMEA_STATS */
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __NMEA_STATS_H__ */
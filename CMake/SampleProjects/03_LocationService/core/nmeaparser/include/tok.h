@@ -17,11 +17,60 @@
 extern "C" {
 #endif
 
+/**
+ * Type of sentence field for nmea_scan_fields
+ */
+enum nmeaFIELDTYPE
+{
+    NMEA_FIELD_CHAR = 0,    /**< Single character (like %C) */
+    NMEA_FIELD_INT,         /**< Decimal integer (like %d) */
+    NMEA_FIELD_INT2,        /**< Decimal integer of two digits (like %2d) */
+    NMEA_FIELD_DOUBLE,      /**< Fraction number (like %f) */
+    NMEA_FIELD_STR,         /**< Raw token returned by pointer and size (like %s) */
+    NMEA_FIELD_NDEG         /**< NDEG fraction number (like %f), also stored as micro-degrees at offset_udeg */
+};
+
+/**
+ * Description of one sentence field: where to store it and which
+ * character follows it (0 if next field follows immediately)
+ */
+typedef struct _nmeaFIELD
+{
+    int     type;
+    char    delim;
+    int     offset;
+    int     offset_udeg;
+
+} nmeaFIELD;
+
+/**
+ * Instruction set used by framing and checksum kernels
+ * @see nmea_simd_select
+ */
+enum nmeaSIMDLEVEL
+{
+    NMEA_SIMD_NONE = 0, /**< Portable byte by byte code */
+    NMEA_SIMD_SSE2,     /**< 16 bytes at a time */
+    NMEA_SIMD_AVX2      /**< 32 bytes at a time */
+};
+
+int     nmea_simd_level(void);
+int     nmea_simd_select(int level);
+int     nmea_scan_delim(const char *buff, int buff_sz, int *res_crc);
+
 int     nmea_calc_crc(const char *buff, int buff_sz);
 int     nmea_atoi(const char *str, int str_sz, int radix);
 double  nmea_atof(const char *str, int str_sz);
 int     nmea_printf(char *buff, int buff_sz, const char *format, ...);
 int     nmea_scanf(const char *buff, int buff_sz, const char *format, ...);
+int     nmea_atoudeg(const char *str, int str_sz);
+int     nmea_scan_fields(
+        const char *buff, int buff_sz,
+        const char *head,
+        const nmeaFIELD *fields, int nfields,
+        void *pack,
+        const char **str, int *str_sz
+        );
 
 #ifdef  __cplusplus
 }
@@ -0,0 +1,250 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file columns.h */
+
+#include "columns.h"
+#include "context.h"
+#include "gmath.h"
+#include "units.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * \brief Initialization of fix columns
+ * @param cols a pointer of columns structure.
+ * @param size initial capacity (rows), NMEA_DEF_COLUMNS if not positive.
+ * @return true (1) - success or false (0) - fail
+ */
+int nmea_columns_init(nmeaFIXCOLUMNS *cols, int size)
+{
+    NMEA_ASSERT(cols);
+
+    memset(cols, 0, sizeof(nmeaFIXCOLUMNS));
+
+    return nmea_columns_reserve(cols, (size > 0)?size:NMEA_DEF_COLUMNS);
+}
+
+/**
+ * \brief Free memory of fix columns
+ */
+void nmea_columns_destroy(nmeaFIXCOLUMNS *cols)
+{
+    NMEA_ASSERT(cols);
+
+    free(cols->utc_us);
+    free(cols->lat);
+    free(cols->lon);
+    free(cols->elv);
+    free(cols->speed);
+    free(cols->direction);
+    free(cols->sig);
+
+    memset(cols, 0, sizeof(nmeaFIXCOLUMNS));
+}
+
+/**
+ * \brief Grow capacity of every column
+ * Filled rows are kept.
+ * @return true (1) - success or false (0) - fail
+ */
+int nmea_columns_reserve(nmeaFIXCOLUMNS *cols, int size)
+{
+    long long *utc_us;
+    double *lat, *lon, *elv, *speed, *direction;
+    int *sig;
+
+    NMEA_ASSERT(cols);
+
+    if(size <= cols->size)
+        return 1;
+
+    utc_us = (long long *)realloc(cols->utc_us, size * sizeof(long long));
+    if(utc_us) cols->utc_us = utc_us;
+    lat = (double *)realloc(cols->lat, size * sizeof(double));
+    if(lat) cols->lat = lat;
+    lon = (double *)realloc(cols->lon, size * sizeof(double));
+    if(lon) cols->lon = lon;
+    elv = (double *)realloc(cols->elv, size * sizeof(double));
+    if(elv) cols->elv = elv;
+    speed = (double *)realloc(cols->speed, size * sizeof(double));
+    if(speed) cols->speed = speed;
+    direction = (double *)realloc(cols->direction, size * sizeof(double));
+    if(direction) cols->direction = direction;
+    sig = (int *)realloc(cols->sig, size * sizeof(int));
+    if(sig) cols->sig = sig;
+
+    if(!utc_us || !lat || !lon || !elv || !speed || !direction || !sig)
+    {
+        nmea_error("Insufficient memory!");
+        return 0;
+    }
+
+    cols->size = size;
+
+    return 1;
+}
+
+/**
+ * \brief Remove all rows, capacity is kept
+ */
+void nmea_columns_clear(nmeaFIXCOLUMNS *cols)
+{
+    NMEA_ASSERT(cols);
+    cols->use = 0;
+    cols->utc_day = 0;
+    cols->utc_tod = 0;
+}
+
+/**
+ * \brief Get row of epoch with given time of day
+ * New row is started with values of previous row.
+ * @return Index of row or -1 if columns can not grow.
+ */
+static int nmea_columns_row(nmeaFIXCOLUMNS *cols, long long utc_us)
+{
+    long long tod = utc_us % NMEA_TIME_DAY_US;
+    int row = cols->use;
+
+    if(row > 0 && tod == cols->utc_tod)
+        return row - 1;
+
+    if(row == cols->size && !nmea_columns_reserve(cols, cols->size * 2))
+        return -1;
+
+    if(row > 0)
+    {
+        cols->lat[row] = cols->lat[row - 1];
+        cols->lon[row] = cols->lon[row - 1];
+        cols->elv[row] = cols->elv[row - 1];
+        cols->speed[row] = cols->speed[row - 1];
+        cols->direction[row] = cols->direction[row - 1];
+        cols->sig[row] = cols->sig[row - 1];
+    }
+    else
+    {
+        cols->lat[row] = NMEA_DEF_LAT;
+        cols->lon[row] = NMEA_DEF_LON;
+        cols->elv[row] = 0;
+        cols->speed[row] = 0;
+        cols->direction[row] = 0;
+        cols->sig[row] = NMEA_SIG_BAD;
+    }
+
+    cols->utc_tod = tod;
+    cols->use++;
+
+    return row;
+}
+
+/**
+ * \brief Append data of packet to fix columns
+ * GGA and RMC start new row (or update row of the same epoch), VTG updates
+ * last row, other packets are ignored.
+ * @param cols a pointer of columns structure.
+ * @param ptype type of packet (nmeaPACKTYPE).
+ * @param pack a pointer of packet structure.
+ * @return true (1) - columns was updated or false (0) - packet was ignored
+ */
+int nmea_columns_append(nmeaFIXCOLUMNS *cols, int ptype, const void *pack)
+{
+    const nmeaGPGGA *gga;
+    const nmeaGPRMC *rmc;
+    const nmeaGPVTG *vtg;
+    int row;
+
+    NMEA_ASSERT(cols && pack);
+
+    switch(ptype)
+    {
+    case GPGGA:
+        gga = (const nmeaGPGGA *)pack;
+        if(0 > (row = nmea_columns_row(cols, gga->utc_us)))
+            return 0;
+        cols->lat[row] = ((gga->ns == 'N')?gga->lat:-(gga->lat));
+        cols->lon[row] = ((gga->ew == 'E')?gga->lon:-(gga->lon));
+        cols->elv[row] = gga->elv;
+        cols->sig[row] = gga->sig;
+        break;
+    case GPRMC:
+        rmc = (const nmeaGPRMC *)pack;
+        if(0 > (row = nmea_columns_row(cols, rmc->utc_us)))
+            return 0;
+        cols->utc_day = rmc->utc_us - rmc->utc_us % NMEA_TIME_DAY_US;
+        if('A' == rmc->status && NMEA_SIG_BAD == cols->sig[row])
+            cols->sig[row] = NMEA_SIG_MID;
+        else if('V' == rmc->status)
+            cols->sig[row] = NMEA_SIG_BAD;
+        cols->lat[row] = ((rmc->ns == 'N')?rmc->lat:-(rmc->lat));
+        cols->lon[row] = ((rmc->ew == 'E')?rmc->lon:-(rmc->lon));
+        cols->speed[row] = rmc->speed * NMEA_TUD_KNOTS;
+        cols->direction[row] = rmc->direction;
+        break;
+    case GPVTG:
+        vtg = (const nmeaGPVTG *)pack;
+        if(0 == (row = cols->use))
+            return 0;
+        cols->speed[row - 1] = vtg->spk;
+        cols->direction[row - 1] = vtg->dir;
+        return 1;
+    default:
+        return 0;
+    };
+
+    cols->utc_us[row] = cols->utc_day + cols->utc_tod;
+
+    return 1;
+}
+
+/**
+ * \brief Convert position columns from NDEG to fractional degrees
+ * @param cols a pointer of columns structure.
+ * @param lat_deg (O) array of cols->use latitudes (may be cols->lat).
+ * @param lon_deg (O) array of cols->use longitudes (may be cols->lon).
+ */
+void nmea_columns_degrees(nmeaFIXCOLUMNS *cols, double *lat_deg, double *lon_deg)
+{
+    NMEA_ASSERT(cols && lat_deg && lon_deg);
+    nmea_ndeg2degree_batch(cols->lat, lat_deg, cols->use);
+    nmea_ndeg2degree_batch(cols->lon, lon_deg, cols->use);
+}
+
+/**
+ * \brief Analysis of buffer and append fixes to columns
+ * Packets go straight from parser slots to columns, nmeaINFO is not built.
+ * @return Number of packets wos parsed
+ */
+int nmea_parse_columns(
+    nmeaPARSER *parser,
+    const char *buff, int buff_sz,
+    nmeaFIXCOLUMNS *cols
+    )
+{
+    int ptype, nparse, nread = 0;
+    void *pack = 0;
+
+    NMEA_ASSERT(parser && parser->buffer && cols);
+
+    do
+    {
+        nparse = nmea_parser_real_push(parser, buff, buff_sz);
+
+        buff += nparse;
+        buff_sz -= nparse;
+
+        while(GPNON != (ptype = nmea_parser_pop(parser, &pack)))
+        {
+            nread++;
+            nmea_columns_append(cols, ptype, pack);
+        }
+
+    } while(buff_sz > 0);
+
+    return nread;
+}
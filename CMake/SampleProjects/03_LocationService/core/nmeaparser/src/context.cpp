@@ -9,6 +9,7 @@
  */
 
 #include "context.h"
+#include "sentence.h"
 
 #include <string.h>
 #include <stdarg.h>
@@ -17,12 +18,104 @@
 nmeaPROPERTY * nmea_property()
 {
     static nmeaPROPERTY prop = {
-        0, 0, NMEA_DEF_PARSEBUFF
+        0, 0, NMEA_DEF_PARSEBUFF, NMEA_DEF_PARSEQUEUE
         };
 
     return &prop;
 }
 
+/**
+ * \brief Sink of parsers created with error_func of nmea_property(), text made on report
+ */
+static void nmea_error_property(void *user, const nmeaERROR *error)
+{
+    char buff[NMEA_DEF_PARSEBUFF];
+    nmeaErrorFunc func = nmea_property()->error_func;
+    int size;
+
+    (void)user;
+
+    if(func && (size = nmea_error_format(error, &buff[0], NMEA_DEF_PARSEBUFF)) > 0)
+        (*func)(&buff[0], size);
+}
+
+/**
+ * \brief Default parser configuration, taken from nmea_property()
+ * Trace and error functions set there reach parsers created afterwards.
+ */
+void nmea_parser_config(nmeaPARSERCONFIG *config)
+{
+    nmeaPROPERTY *prop = nmea_property();
+
+    NMEA_ASSERT(config);
+
+    memset(config, 0, sizeof(nmeaPARSERCONFIG));
+    config->parse_buff_size = prop->parse_buff_size;
+    config->parse_queue_size = prop->parse_queue_size;
+    config->trace_func = prop->trace_func;
+    if(prop->error_func)
+        config->error_sink = &nmea_error_property;
+}
+
+/**
+ * \brief Description of error code
+ */
+const char * nmea_error_str(int code)
+{
+    static const char *const str[NMEA_ERR_LAST] = {
+        "No error",
+        "Control sum error",
+        "Unknown sentence type",
+        "parse error",
+        "time parse error",
+        "parse error (format error)",
+        "Parser buffer overflow, incomplete sentence dropped",
+        "Parser queue overflow, oldest packet dropped"
+        };
+
+    return (code >= 0 && code < NMEA_ERR_LAST)?str[code]:"Unknown error";
+}
+
+/**
+ * \brief Text of error, e.g. "GPGGA parse error! (offset 1234, field 5)"
+ * @return number of characters written (without terminating zero)
+ */
+int nmea_error_format(const nmeaERROR *error, char *buff, int buff_sz)
+{
+    const char *type = 0;
+    int size;
+
+    NMEA_ASSERT(error && buff);
+
+    if(buff_sz <= 0)
+        return 0;
+
+    switch(error->ptype)
+    {
+    case GPGGA: type = "GPGGA"; break;
+    case GPGSA: type = "GPGSA"; break;
+    case GPGSV: type = "GPGSV"; break;
+    case GPRMC: type = "GPRMC"; break;
+    case GPVTG: type = "GPVTG"; break;
+    };
+
+    size = NMEA_POSIX(snprintf)(buff, buff_sz, "%s%s%s!",
+        type?type:"", type?" ":"", nmea_error_str(error->code));
+
+    if(size >= 0 && size < buff_sz && error->offset >= 0)
+        size += NMEA_POSIX(snprintf)(buff + size, buff_sz - size, " (offset %lld%s", error->offset,
+            (error->field >= 0)?"":")");
+    if(size >= 0 && size < buff_sz && error->offset >= 0 && error->field >= 0)
+        size += NMEA_POSIX(snprintf)(buff + size, buff_sz - size, ", field %d)", error->field);
+    if(size >= 0 && size < buff_sz && error->dropped)
+        size += NMEA_POSIX(snprintf)(buff + size, buff_sz - size, " %lu more dropped", error->dropped);
+
+    if(size < 0)
+        return 0;
+
+    return (size < buff_sz)?size:buff_sz - 1;
+}
+
 void nmea_trace(const char *str, ...)
 {
     int size;
@@ -0,0 +1,279 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file epoch.h */
+
+#include "epoch.h"
+#include "parse.h"
+
+#include <string.h>
+
+/**
+ * \brief Time of day of GGA/RMC packet in microseconds
+ * @return time of day or -1 for packets without time
+ */
+static long long nmea_epoch_tod(int ptype, const void *pack)
+{
+    switch(ptype)
+    {
+    case GPGGA:
+        return ((const nmeaGPGGA *)pack)->utc_us % NMEA_TIME_DAY_US;
+    case GPRMC:
+        return ((const nmeaGPRMC *)pack)->utc_us % NMEA_TIME_DAY_US;
+    default:
+        return -1;
+    };
+}
+
+/**
+ * \brief Current epoch is not handed over, holds every packet of a required mask and no GSV sequence in progress
+ */
+static int nmea_epoch_complete(const nmeaEPOCH *epoch)
+{
+    return epoch->require && !epoch->emitted && 0 == epoch->gsv_use &&
+        (epoch->info.smask & epoch->require) == epoch->require;
+}
+
+/**
+ * \brief Mark current epoch handed over
+ */
+static void nmea_epoch_emit(nmeaEPOCH *epoch)
+{
+    epoch->emitted = 1;
+    epoch->epochs++;
+}
+
+/**
+ * \brief Close current epoch, it waits in fix unless it was handed over already
+ */
+static void nmea_epoch_close(nmeaEPOCH *epoch)
+{
+    if(epoch->emitted || 0 == epoch->info.smask)
+        return;
+
+    if((epoch->info.smask & (GPGGA | GPRMC)) != (GPGGA | GPRMC))
+        epoch->partial++;
+
+    nmea_epoch_emit(epoch);
+    memcpy(&epoch->fix, &epoch->info, sizeof(nmeaINFO));
+    epoch->ready = 1;
+}
+
+/**
+ * \brief Close current epoch and start the next one
+ */
+static void nmea_epoch_next(nmeaEPOCH *epoch)
+{
+    nmea_epoch_close(epoch);
+
+    epoch->broken += epoch->gsv_use;
+    epoch->info.smask = 0;
+    epoch->tod = -1;
+    epoch->packets = 0;
+    epoch->emitted = 0;
+    epoch->gsv_use = 0;
+    epoch->gsv_done = 0;
+}
+
+/**
+ * \brief Packet starts next epoch
+ */
+static int nmea_epoch_starts(const nmeaEPOCH *epoch, int ptype, const void *pack, long long tod)
+{
+    const nmeaGPGSV *gsv;
+
+    if(0 == epoch->packets)
+        return 0;
+    if(tod >= 0 && epoch->tod >= 0 && tod != epoch->tod)
+        return 1;
+    if(ptype & (GPGGA | GPRMC | GPVTG) & epoch->info.smask)
+        return 1;
+
+    if(GPGSV == ptype)
+    {
+        gsv = (const nmeaGPGSV *)pack;
+        return gsv->pack_index <= 1 && (epoch->gsv_done & (1 << (gsv->talker & 31)));
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Add GSV packet to the sequence in progress, merge the sequence once complete
+ */
+static void nmea_epoch_gsv(nmeaEPOCH *epoch, const nmeaGPGSV *pack)
+{
+    const nmeaGPGSV *first = epoch->gsv;
+    int count = (pack->pack_count < 1)?1:pack->pack_count;
+    int it;
+
+    if(count > NMEA_NSATPACKS)
+    {
+        epoch->broken++;
+        return;
+    }
+
+    if(pack->pack_index <= 1)
+    {
+        epoch->broken += epoch->gsv_use;
+        epoch->gsv_use = 0;
+    }
+    else if(0 == epoch->gsv_use ||
+        pack->talker != first->talker ||
+        pack->pack_count != first->pack_count ||
+        pack->pack_index != epoch->gsv_use + 1)
+    {
+        /* packet lost or reordered, the sequence is never complete */
+        epoch->broken += epoch->gsv_use + 1;
+        epoch->gsv_use = 0;
+        return;
+    }
+
+    memcpy(&epoch->gsv[epoch->gsv_use++], pack, sizeof(nmeaGPGSV));
+
+    if(epoch->gsv_use < count)
+        return;
+
+    for(it = 0; it < epoch->gsv_use; ++it)
+        nmea_pack2info(GPGSV, &epoch->gsv[it], &epoch->info);
+
+    epoch->gsv_done |= 1 << (first->talker & 31);
+    epoch->gsv_use = 0;
+}
+
+/**
+ * \brief Initialization of epoch assembler
+ * @param epoch a pointer of assembler structure.
+ * @param require packets (mask) completing an epoch early, NMEA_DEF_EPOCH_MASK (none) if not positive.
+ * @param timeout_ms milliseconds an epoch waits for the next one, 0 - forever, NMEA_DEF_EPOCH_TIMEOUT if negative.
+ */
+void nmea_epoch_init(nmeaEPOCH *epoch, int require, int timeout_ms)
+{
+    NMEA_ASSERT(epoch);
+
+    memset(epoch, 0, sizeof(nmeaEPOCH));
+    nmea_zero_INFO(&epoch->info);
+    nmea_zero_INFO(&epoch->fix);
+
+    epoch->require = (require > 0)?require:NMEA_DEF_EPOCH_MASK;
+    epoch->timeout = (timeout_ms < 0)?NMEA_DEF_EPOCH_TIMEOUT:timeout_ms;
+    epoch->tod = -1;
+}
+
+/**
+ * \brief Add decoded packet to its epoch
+ * Call nmea_epoch_pop until it returns NULL after every push.
+ * @param epoch a pointer of assembler structure.
+ * @param ptype packet type (GPGGA, GPRMC, ...).
+ * @param pack a pointer of packet structure.
+ * @param now_ms current time in milliseconds, any monotonic clock of the caller.
+ * @return true (1) - an epoch can be popped or false (0)
+ */
+int nmea_epoch_push(nmeaEPOCH *epoch, int ptype, const void *pack, long long now_ms)
+{
+    long long tod;
+
+    NMEA_ASSERT(epoch && pack);
+
+    tod = nmea_epoch_tod(ptype, pack);
+
+    /* the next epoch closes the current one even when its timeout was not polled */
+    if(nmea_epoch_starts(epoch, ptype, pack, tod))
+        nmea_epoch_next(epoch);
+    else
+        nmea_epoch_poll(epoch, now_ms);
+
+    if(epoch->emitted)
+    {
+        epoch->late++;
+        return epoch->ready;
+    }
+
+    /* timeout runs from the first packet with time, epoch has no time before */
+    if(tod >= 0 && epoch->tod < 0)
+        epoch->start_ms = now_ms;
+    if(tod >= 0)
+        epoch->tod = tod;
+    epoch->packets++;
+
+    if(GPGSV == ptype)
+        nmea_epoch_gsv(epoch, (const nmeaGPGSV *)pack);
+    else
+        nmea_pack2info(ptype, (void *)pack, &epoch->info);
+
+    return epoch->ready || nmea_epoch_complete(epoch);
+}
+
+/**
+ * \brief Close epoch whose timeout expired before the next one started
+ * @param epoch a pointer of assembler structure.
+ * @param now_ms current time in milliseconds, clock of nmea_epoch_push.
+ * @return true (1) - an epoch can be popped or false (0)
+ */
+int nmea_epoch_poll(nmeaEPOCH *epoch, long long now_ms)
+{
+    NMEA_ASSERT(epoch);
+
+    if(epoch->timeout > 0 && !epoch->emitted && epoch->tod >= 0 &&
+        now_ms - epoch->start_ms >= epoch->timeout)
+    {
+        epoch->timeouts++;
+        nmea_epoch_close(epoch);
+    }
+
+    return epoch->ready;
+}
+
+/**
+ * \brief Close current epoch at the end of stream
+ * @return true (1) - an epoch can be popped or false (0)
+ */
+int nmea_epoch_flush(nmeaEPOCH *epoch)
+{
+    NMEA_ASSERT(epoch);
+
+    nmea_epoch_close(epoch);
+
+    return epoch->ready;
+}
+
+/**
+ * \brief Take next assembled epoch
+ * Every epoch is returned once: a closed one first, then the current one
+ * when it holds every packet of the required mask.
+ * @param epoch a pointer of assembler structure.
+ * @return summary of the epoch, valid until next push, or NULL
+ */
+const nmeaINFO *nmea_epoch_pop(nmeaEPOCH *epoch)
+{
+    NMEA_ASSERT(epoch);
+
+    if(epoch->ready)
+    {
+        epoch->ready = 0;
+        return &epoch->fix;
+    }
+
+    if(nmea_epoch_complete(epoch))
+    {
+        nmea_epoch_emit(epoch);
+        return &epoch->info;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Current epoch has packets and was not handed over yet, nmea_epoch_poll closes it on timeout
+ */
+int nmea_epoch_pending(const nmeaEPOCH *epoch)
+{
+    NMEA_ASSERT(epoch);
+
+    return !epoch->emitted && epoch->packets > 0;
+}
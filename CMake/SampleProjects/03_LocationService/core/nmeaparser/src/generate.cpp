@@ -12,65 +12,322 @@
 #include "sentence.h"
 #include "generate.h"
 #include "units.h"
+#include "degree.h"
 
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stdio.h>
+
+/**
+ * Sentence being written by nmea_enc_... functions: the same bytes
+ * nmea_printf writes for the format of the sentence, without vsnprintf.
+ * Numbers are written by digit pairs, the control sum is accumulated on the
+ * way. Length keeps counting past the end of buffer.
+ */
+typedef struct _nmeaENCODER
+{
+    char    *buff;
+    int     buff_sz;
+    int     len;
+    unsigned char crc;
+    int     error;      /**< vsnprintf would fail (%C of non-ASCII character) */
+
+} nmeaENCODER;
+
+static const char nmea_enc_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static NMEA_INLINE void nmea_enc_put(nmeaENCODER *enc, char ch)
+{
+    if(enc->len < enc->buff_sz)
+        enc->buff[enc->len] = ch;
+    enc->len++;
+    enc->crc ^= (unsigned char)ch;
+}
+
+static NMEA_INLINE void nmea_enc_delim(nmeaENCODER *enc, char delim)
+{
+    if(delim)
+        nmea_enc_put(enc, delim);
+}
+
+/**
+ * \brief Start sentence with its head ("$GPGGA,"), '$' is not in the control sum
+ */
+static void nmea_enc_begin(nmeaENCODER *enc, char *buff, int buff_sz, const char *head)
+{
+    enc->buff = buff;
+    enc->buff_sz = buff_sz;
+    enc->len = 0;
+    enc->crc = 0;
+    enc->error = 0;
+
+    for(; *head; ++head)
+        nmea_enc_put(enc, *head);
+
+    enc->crc ^= '$';
+}
+
+/**
+ * \brief Unsigned decimal zero padded to width (like %0*llu)
+ */
+static void nmea_enc_uint(nmeaENCODER *enc, unsigned long long value, int width)
+{
+    char tmp[24];
+    int count = 0, pair;
+
+    while(value >= 100)
+    {
+        pair = (int)(value % 100) * 2;
+        value /= 100;
+        tmp[count++] = nmea_enc_pairs[pair + 1];
+        tmp[count++] = nmea_enc_pairs[pair];
+    }
+
+    if(value >= 10)
+    {
+        tmp[count++] = nmea_enc_pairs[value * 2 + 1];
+        tmp[count++] = nmea_enc_pairs[value * 2];
+    }
+    else
+        tmp[count++] = (char)('0' + value);
+
+    for(; count < width; --width)
+        nmea_enc_put(enc, '0');
+    while(count > 0)
+        nmea_enc_put(enc, tmp[--count]);
+}
+
+/**
+ * \brief Field like %0*d followed by delim (0 - none)
+ */
+static void nmea_enc_int(nmeaENCODER *enc, int value, int width, char delim)
+{
+    if(value < 0)
+    {
+        nmea_enc_put(enc, '-');
+        nmea_enc_uint(enc, 0ULL - (unsigned long long)value, width - 1);
+    }
+    else
+        nmea_enc_uint(enc, (unsigned long long)value, width);
+
+    nmea_enc_delim(enc, delim);
+}
+
+/**
+ * \brief Field like %C followed by delim (0 - none)
+ */
+static void nmea_enc_char(nmeaENCODER *enc, int ch, char delim)
+{
+    /* %C is %lc, vsnprintf fails on characters out of the C locale */
+    if(ch < 0 || ch > 127)
+        enc->error = 1;
+
+    nmea_enc_put(enc, (char)ch);
+    nmea_enc_delim(enc, delim);
+}
+
+/**
+ * \brief Field like %0*.*f (prec of 1 to 4) followed by delim (0 - none)
+ * Digits are rounded the way printf does: to nearest of the exact binary
+ * value, ties to even. Values out of fixed point range, infinity and NaN
+ * are left to snprintf.
+ */
+static void nmea_enc_fixed(nmeaENCODER *enc, double value, int width, int prec, char delim)
+{
+    static const double scales[] = { 1.0, 10.0, 100.0, 1000.0, 10000.0 };
+    const double scale = scales[prec];
+    double mag = fabs(value), prod, err, frac;
+    unsigned long long fixed;
+    char tmp[512];
+    int it, count, neg;
+
+    if(!(mag < 1e15 / scale))
+    {
+        count = NMEA_POSIX(snprintf)(tmp, sizeof(tmp), "%0*.*f", width, prec, value);
+        for(it = 0; it < count && it < (int)sizeof(tmp) - 1; ++it)
+            nmea_enc_put(enc, tmp[it]);
+        nmea_enc_delim(enc, delim);
+        return;
+    }
+
+    /* prod + err is the exact product, scale has no more than 14 bits */
+    prod = mag * scale;
+#ifdef FP_FAST_FMA
+    err = fma(mag, scale, -prod);
+#else
+    {
+        double split = 134217729.0 * mag;
+        double hi = split - (split - mag);
+        err = (hi * scale - prod) + (mag - hi) * scale;
+    }
+#endif
+
+    fixed = (unsigned long long)prod;
+    frac = (prod - (double)fixed) - 0.5;
+    if(frac > 0 || (frac == 0 && (err > 0 || (err == 0 && (fixed & 1)))))
+        fixed++;
+
+    neg = signbit(value) ? 1 : 0;
+    if(neg)
+        nmea_enc_put(enc, '-');
+
+    nmea_enc_uint(enc, fixed / (unsigned long long)scale, width - neg - 1 - prec);
+    nmea_enc_put(enc, '.');
+    nmea_enc_uint(enc, fixed % (unsigned long long)scale, prec);
+    nmea_enc_delim(enc, delim);
+}
+
+/**
+ * \brief Time of day as hhmmss.ss followed by delim
+ */
+static void nmea_enc_time(nmeaENCODER *enc, const nmeaTIME *utc, char delim)
+{
+    nmea_enc_int(enc, utc->hour, 2, 0);
+    nmea_enc_int(enc, utc->min, 2, 0);
+    nmea_enc_int(enc, utc->sec, 2, '.');
+    nmea_enc_int(enc, utc->hsec, 2, delim);
+}
+
+/**
+ * \brief Finish sentence with "*hh\r\n"
+ * @return the same size and bytes as nmea_printf, spaces if the sentence does not fit
+ */
+static int nmea_enc_end(nmeaENCODER *enc)
+{
+    static const char hex[] = "0123456789abcdef";
+    char tail[6];
+    int it, size;
+
+    if(enc->buff_sz <= 0)
+        return 0;
+
+    size = enc->len + 5;
+    if(enc->error || size > enc->buff_sz)
+    {
+        memset(enc->buff, ' ', enc->buff_sz);
+        return enc->buff_sz;
+    }
+
+    tail[0] = '*';
+    tail[1] = hex[enc->crc >> 4];
+    tail[2] = hex[enc->crc & 0xf];
+    tail[3] = '\r';
+    tail[4] = '\n';
+    tail[5] = 0;
+
+    /* terminated like by snprintf, in a buffer of exact size the line end gives way */
+    for(it = 0; it < 6 && enc->len + it < enc->buff_sz; ++it)
+        enc->buff[enc->len + it] = tail[it];
+    if(size == enc->buff_sz)
+        enc->buff[size - 1] = 0;
+
+    return size;
+}
 
 int nmea_gen_GPGGA(char *buff, int buff_sz, nmeaGPGGA *pack)
 {
-    return nmea_printf(buff, buff_sz,
-        "$GPGGA,%02d%02d%02d.%02d,%07.4f,%C,%07.4f,%C,%1d,%02d,%03.1f,%03.1f,%C,%03.1f,%C,%03.1f,%04d",
-        pack->utc.hour, pack->utc.min, pack->utc.sec, pack->utc.hsec,
-        pack->lat, pack->ns, pack->lon, pack->ew,
-        pack->sig, pack->satinuse, pack->HDOP, pack->elv, pack->elv_units,
-        pack->diff, pack->diff_units, pack->dgps_age, pack->dgps_sid);
+    nmeaENCODER enc;
+
+    nmea_enc_begin(&enc, buff, buff_sz, "$GPGGA,");
+    nmea_enc_time(&enc, &pack->utc, ',');
+    nmea_enc_fixed(&enc, pack->lat, 7, 4, ',');
+    nmea_enc_char(&enc, pack->ns, ',');
+    nmea_enc_fixed(&enc, pack->lon, 7, 4, ',');
+    nmea_enc_char(&enc, pack->ew, ',');
+    nmea_enc_int(&enc, pack->sig, 1, ',');
+    nmea_enc_int(&enc, pack->satinuse, 2, ',');
+    nmea_enc_fixed(&enc, pack->HDOP, 3, 1, ',');
+    nmea_enc_fixed(&enc, pack->elv, 3, 1, ',');
+    nmea_enc_char(&enc, pack->elv_units, ',');
+    nmea_enc_fixed(&enc, pack->diff, 3, 1, ',');
+    nmea_enc_char(&enc, pack->diff_units, ',');
+    nmea_enc_fixed(&enc, pack->dgps_age, 3, 1, ',');
+    nmea_enc_int(&enc, pack->dgps_sid, 4, 0);
+
+    return nmea_enc_end(&enc);
 }
 
 int nmea_gen_GPGSA(char *buff, int buff_sz, nmeaGPGSA *pack)
 {
-    return nmea_printf(buff, buff_sz,
-        "$GPGSA,%C,%1d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%02d,%03.1f,%03.1f,%03.1f",
-        pack->fix_mode, pack->fix_type,
-        pack->sat_prn[0], pack->sat_prn[1], pack->sat_prn[2], pack->sat_prn[3], pack->sat_prn[4], pack->sat_prn[5],
-        pack->sat_prn[6], pack->sat_prn[7], pack->sat_prn[8], pack->sat_prn[9], pack->sat_prn[10], pack->sat_prn[11],
-        pack->PDOP, pack->HDOP, pack->VDOP);
+    nmeaENCODER enc;
+    int it;
+
+    nmea_enc_begin(&enc, buff, buff_sz, "$GPGSA,");
+    nmea_enc_char(&enc, pack->fix_mode, ',');
+    nmea_enc_int(&enc, pack->fix_type, 1, ',');
+    for(it = 0; it < NMEA_PRNINPACK; ++it)
+        nmea_enc_int(&enc, pack->sat_prn[it], 2, ',');
+    nmea_enc_fixed(&enc, pack->PDOP, 3, 1, ',');
+    nmea_enc_fixed(&enc, pack->HDOP, 3, 1, ',');
+    nmea_enc_fixed(&enc, pack->VDOP, 3, 1, 0);
+
+    return nmea_enc_end(&enc);
 }
 
 int nmea_gen_GPGSV(char *buff, int buff_sz, nmeaGPGSV *pack)
 {
-    return nmea_printf(buff, buff_sz,
-        "$GPGSV,%1d,%1d,%02d,"
-        "%02d,%02d,%03d,%02d,"
-        "%02d,%02d,%03d,%02d,"
-        "%02d,%02d,%03d,%02d,"
-        "%02d,%02d,%03d,%02d",
-        pack->pack_count, pack->pack_index + 1, pack->sat_count,
-        pack->sat_data[0].id, pack->sat_data[0].elv, pack->sat_data[0].azimuth, pack->sat_data[0].sig,
-        pack->sat_data[1].id, pack->sat_data[1].elv, pack->sat_data[1].azimuth, pack->sat_data[1].sig,
-        pack->sat_data[2].id, pack->sat_data[2].elv, pack->sat_data[2].azimuth, pack->sat_data[2].sig,
-        pack->sat_data[3].id, pack->sat_data[3].elv, pack->sat_data[3].azimuth, pack->sat_data[3].sig);
+    nmeaENCODER enc;
+    int it;
+
+    nmea_enc_begin(&enc, buff, buff_sz, "$GPGSV,");
+    nmea_enc_int(&enc, pack->pack_count, 1, ',');
+    nmea_enc_int(&enc, pack->pack_index + 1, 1, ',');
+    nmea_enc_int(&enc, pack->sat_count, 2, ',');
+    for(it = 0; it < NMEA_SATINPACK; ++it)
+    {
+        nmea_enc_int(&enc, pack->sat_data[it].id, 2, ',');
+        nmea_enc_int(&enc, pack->sat_data[it].elv, 2, ',');
+        nmea_enc_int(&enc, pack->sat_data[it].azimuth, 3, ',');
+        nmea_enc_int(&enc, pack->sat_data[it].sig, 2, (it + 1 < NMEA_SATINPACK)?',':0);
+    }
+
+    return nmea_enc_end(&enc);
 }
 
 int nmea_gen_GPRMC(char *buff, int buff_sz, nmeaGPRMC *pack)
 {
-    return nmea_printf(buff, buff_sz,
-        "$GPRMC,%02d%02d%02d.%02d,%C,%07.4f,%C,%07.4f,%C,%03.1f,%03.1f,%02d%02d%02d,%03.1f,%C,%C",
-        pack->utc.hour, pack->utc.min, pack->utc.sec, pack->utc.hsec,
-        pack->status, pack->lat, pack->ns, pack->lon, pack->ew,
-        pack->speed, pack->direction,
-        pack->utc.day, pack->utc.mon + 1, pack->utc.year - 100,
-        pack->declination, pack->declin_ew, pack->mode);
+    nmeaENCODER enc;
+
+    nmea_enc_begin(&enc, buff, buff_sz, "$GPRMC,");
+    nmea_enc_time(&enc, &pack->utc, ',');
+    nmea_enc_char(&enc, pack->status, ',');
+    nmea_enc_fixed(&enc, pack->lat, 7, 4, ',');
+    nmea_enc_char(&enc, pack->ns, ',');
+    nmea_enc_fixed(&enc, pack->lon, 7, 4, ',');
+    nmea_enc_char(&enc, pack->ew, ',');
+    nmea_enc_fixed(&enc, pack->speed, 3, 1, ',');
+    nmea_enc_fixed(&enc, pack->direction, 3, 1, ',');
+    nmea_enc_int(&enc, pack->utc.day, 2, 0);
+    nmea_enc_int(&enc, pack->utc.mon + 1, 2, 0);
+    nmea_enc_int(&enc, pack->utc.year - 100, 2, ',');
+    nmea_enc_fixed(&enc, pack->declination, 3, 1, ',');
+    nmea_enc_char(&enc, pack->declin_ew, ',');
+    nmea_enc_char(&enc, pack->mode, 0);
+
+    return nmea_enc_end(&enc);
 }
 
 int nmea_gen_GPVTG(char *buff, int buff_sz, nmeaGPVTG *pack)
 {
-    return nmea_printf(buff, buff_sz,
-        "$GPVTG,%.1f,%C,%.1f,%C,%.1f,%C,%.1f,%C",
-        pack->dir, pack->dir_t,
-        pack->dec, pack->dec_m,
-        pack->spn, pack->spn_n,
-        pack->spk, pack->spk_k);
+    nmeaENCODER enc;
+
+    nmea_enc_begin(&enc, buff, buff_sz, "$GPVTG,");
+    nmea_enc_fixed(&enc, pack->dir, 0, 1, ',');
+    nmea_enc_char(&enc, pack->dir_t, ',');
+    nmea_enc_fixed(&enc, pack->dec, 0, 1, ',');
+    nmea_enc_char(&enc, pack->dec_m, ',');
+    nmea_enc_fixed(&enc, pack->spn, 0, 1, ',');
+    nmea_enc_char(&enc, pack->spn_n, ',');
+    nmea_enc_fixed(&enc, pack->spk, 0, 1, ',');
+    nmea_enc_char(&enc, pack->spk_k, 0);
+
+    return nmea_enc_end(&enc);
 }
 
 void nmea_info2GPGGA(const nmeaINFO *info, nmeaGPGGA *pack)
@@ -78,10 +335,13 @@ void nmea_info2GPGGA(const nmeaINFO *info, nmeaGPGGA *pack)
     nmea_zero_GPGGA(pack);
 
     pack->utc = info->utc;
+    pack->utc_us = nmea_time_to_us(&info->utc) % NMEA_TIME_DAY_US;
     pack->lat = fabs(info->lat);
     pack->ns = ((info->lat > 0)?'N':'S');
     pack->lon = fabs(info->lon);
     pack->ew = ((info->lon > 0)?'E':'W');
+    pack->lat_udeg = nmea_fast_ndeg2udeg(pack->lat);
+    pack->lon_udeg = nmea_fast_ndeg2udeg(pack->lon);
     pack->sig = info->sig;
     pack->satinuse = info->satinfo.inuse;
     pack->HDOP = info->HDOP;
@@ -99,7 +359,7 @@ void nmea_info2GPGSA(const nmeaINFO *info, nmeaGPGSA *pack)
     pack->HDOP = info->HDOP;
     pack->VDOP = info->VDOP;
 
-    for(it = 0; it < NMEA_MAXSAT; ++it)
+    for(it = 0; it < NMEA_PRNINPACK; ++it)
     {
         pack->sat_prn[it] =
             ((info->satinfo.sat[it].in_use)?info->satinfo.sat[it].id:0);
@@ -142,11 +402,14 @@ void nmea_info2GPRMC(const nmeaINFO *info, nmeaGPRMC *pack)
     nmea_zero_GPRMC(pack);
 
     pack->utc = info->utc;
+    pack->utc_us = nmea_time_to_us(&info->utc);
     pack->status = ((info->sig > 0)?'A':'V');
     pack->lat = fabs(info->lat);
     pack->ns = ((info->lat > 0)?'N':'S');
     pack->lon = fabs(info->lon);
     pack->ew = ((info->lon > 0)?'E':'W');
+    pack->lat_udeg = nmea_fast_ndeg2udeg(pack->lat);
+    pack->lon_udeg = nmea_fast_ndeg2udeg(pack->lon);
     pack->speed = info->speed / NMEA_TUD_KNOTS;
     pack->direction = info->direction;
     pack->declination = info->declination;
@@ -20,12 +20,89 @@
 # pragma warning(disable: 4100) /* unreferenced formal parameter */
 #endif
 
+/*
+ * random
+ */
+
+static __thread nmeaRANDOM nmea_random_local;
+static __thread int nmea_random_ready = 0;
+static __thread nmeaRANDOM *nmea_random_bound = 0; /* sequence of nmea_generate_ctx in progress */
+static unsigned long long nmea_random_threads = 0;
+
+static NMEA_INLINE unsigned long long nmea_random_rotl(unsigned long long value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/**
+ * \brief splitmix64 step, a different well mixed value for every value
+ */
+static NMEA_INLINE unsigned long long nmea_random_mix(unsigned long long z)
+{
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * \brief Start sequence from seed (state filled by splitmix64)
+ */
+void nmea_random_seed(nmeaRANDOM *rnd, unsigned long long seed)
+{
+    int it;
+
+    NMEA_ASSERT(rnd);
+
+    for(it = 0; it < 4; ++it, seed += 0x9e3779b97f4a7c15ULL)
+        rnd->s[it] = nmea_random_mix(seed);
+}
+
+/**
+ * \brief Next 64 random bits of sequence
+ */
+unsigned long long nmea_random_next(nmeaRANDOM *rnd)
+{
+    unsigned long long *s = rnd->s;
+    unsigned long long result = nmea_random_rotl(s[1] * 5, 7) * 9;
+    unsigned long long t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = nmea_random_rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * \brief Uniform value of [min, max], both ends included like by rand() / RAND_MAX
+ */
+double nmea_random_from(nmeaRANDOM *rnd, double min, double max)
+{
+    double unit = (double)(nmea_random_next(rnd) >> 11) / 9007199254740991.0;
+    return min + unit * (max - min);
+}
+
+/**
+ * \brief Sequence of the calling thread, threads are seeded 1, 2, ... in order of first use
+ */
+nmeaRANDOM * nmea_random_thread(void)
+{
+    if(!nmea_random_ready)
+    {
+        nmea_random_seed(&nmea_random_local, __atomic_add_fetch(&nmea_random_threads, 1, __ATOMIC_RELAXED));
+        nmea_random_ready = 1;
+    }
+
+    return &nmea_random_local;
+}
+
 double nmea_random(double min, double max)
 {
-    static double rand_max = RAND_MAX;
-    double rand_val = rand();
-    double bounds = max - min;
-    return min + (rand_val * bounds) / rand_max;
+    return nmea_random_from(nmea_random_bound?nmea_random_bound:nmea_random_thread(), min, max);
 }
 
 /*
@@ -113,6 +190,79 @@ int nmea_generate_from(
     return retval;
 }
 
+/*
+ * seeded context
+ */
+
+/**
+ * \brief Initialization of device context
+ * @param ctx a pointer of context structure.
+ * @param seed seed of the data set, devices of one seed have unrelated sequences.
+ * @param device number of the device.
+ * @param start_ms virtual time of epoch 0 in milliseconds since 1970-01-01 UTC.
+ * @param interval_ms milliseconds between epochs, 1000 if not positive.
+ */
+void nmea_gen_context_init(
+    nmeaGENCONTEXT *ctx,
+    unsigned long long seed, unsigned long long device,
+    long long start_ms, int interval_ms
+    )
+{
+    NMEA_ASSERT(ctx);
+
+    nmea_random_seed(&ctx->rnd, seed ^ nmea_random_mix(device));
+    ctx->start_ms = start_ms;
+    ctx->interval = (interval_ms > 0)?interval_ms:1000;
+    ctx->epoch = 0;
+}
+
+/**
+ * \brief Virtual time of next epoch of device
+ * @return the same time in microseconds since 1970-01-01 UTC
+ */
+long long nmea_gen_context_time(const nmeaGENCONTEXT *ctx, nmeaTIME *utc)
+{
+    long long us = (ctx->start_ms + (long long)ctx->epoch * ctx->interval) * 1000;
+
+    nmea_time_from_us(us, utc);
+
+    return us;
+}
+
+/**
+ * \brief Next epoch of device, reproducible version of nmea_generate_from
+ * Generators draw from the sequence of ctx and the epoch is stamped by its
+ * virtual clock instead of nmea_time_now.
+ * @return the same as nmea_generate_from
+ */
+int nmea_generate_ctx(
+    char *buff, int buff_sz,
+    nmeaINFO *info,
+    nmeaGENERATOR *gen,
+    nmeaGENCONTEXT *ctx,
+    int generate_mask
+    )
+{
+    nmeaRANDOM *bound = nmea_random_bound;
+    int retval;
+
+    NMEA_ASSERT(ctx);
+
+    nmea_random_bound = &ctx->rnd;
+    retval = nmea_gen_loop(gen, info);
+    nmea_random_bound = bound;
+
+    if(0 != retval)
+    {
+        info->utc_us = nmea_gen_context_time(ctx, &info->utc);
+        retval = nmea_generate(buff, buff_sz, info, generate_mask);
+    }
+
+    ctx->epoch++;
+
+    return retval;
+}
+
 /*
  * NOISE generator
  */
@@ -171,6 +321,7 @@ int nmea_igen_noise_reset(nmeaGENERATOR *gen, nmeaINFO *info)
 int nmea_igen_static_loop(nmeaGENERATOR *gen, nmeaINFO *info)
 {
     nmea_time_now(&info->utc);
+    info->utc_us = nmea_time_to_us(&info->utc);
     return 1;
 };
 
@@ -228,6 +379,7 @@ int nmea_igen_rotate_loop(nmeaGENERATOR *gen, nmeaINFO *info)
     double srt = (count?(info->satinfo.sat[0].azimuth):0) + 5;
 
     nmea_time_now(&info->utc);
+    info->utc_us = nmea_time_to_us(&info->utc);
 
     for(it = 0; it < count; ++it)
     {
@@ -0,0 +1,358 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file gmath.h */
+
+#include "gmath.h"
+#include "tok.h"
+
+#include <math.h>
+
+/*
+ * Batch versions of nmea_distance and nmea_distance_ellipsoid.
+ *
+ * Positions are processed by blocks of NMEA_GEO_LANES pairs. Every step of
+ * the algorithm is a loop over lanes without branches, so the compiler may
+ * turn it into vector instructions of the baseline instruction set. A build
+ * of the kernels for AVX2/FMA was measured no faster (the polynomials are
+ * bound by divisions and sqrt) and is not provided.
+ *
+ * sin/cos/atan are replaced by polynomial approximations (fdlibm and Cephes
+ * coefficients) with error within a few ulp, distances differ from the
+ * scalar functions by less than a micrometer.
+ */
+
+#define NMEA_GEO_LANES      (4)
+#define NMEA_GEO_STEPS      (20)
+
+#if defined(__GNUC__) || defined(__clang__)
+#   define NMEA_GEO_INLINE  inline __attribute__((always_inline))
+#else
+#   define NMEA_GEO_INLINE  NMEA_INLINE
+#endif
+
+/* pi/2 split for Cody-Waite reduction (fdlibm) */
+#define NMEA_GEO_PIO2_1     (1.57079632673412561417e+00)
+#define NMEA_GEO_PIO2_2     (6.07710050630396597660e-11)
+#define NMEA_GEO_PIO2_2T    (2.02226624879595063154e-21)
+#define NMEA_GEO_ROUND      (6755399441055744.0)    /**< 1.5 * 2^52, adding it rounds to integer */
+
+/**
+ * \brief sin and cos of argument (|x| < 2^20)
+ */
+static NMEA_GEO_INLINE void nmea_geo_sincos(double x, double *res_sin, double *res_cos)
+{
+    double k = (x * (2 / NMEA_PI) + NMEA_GEO_ROUND) - NMEA_GEO_ROUND;
+    int q = (int)k;
+    double r = ((x - k * NMEA_GEO_PIO2_1) - k * NMEA_GEO_PIO2_2) - k * NMEA_GEO_PIO2_2T;
+    double z = r * r;
+    double hz = 0.5 * z;
+    double w = 1.0 - hz;
+    double s, c;
+
+    s = r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03 +
+        z * (-1.98412698298579493134e-04 + z * (2.75573137070700676789e-06 +
+        z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+    c = w + (((1.0 - w) - hz) + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 +
+        z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07 +
+        z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11))))));
+
+    *res_sin = ((q & 1)?c:s) * ((q & 2)?-1.0:1.0);
+    *res_cos = ((q & 1)?s:c) * (((q + 1) & 2)?-1.0:1.0);
+}
+
+/**
+ * \brief atan of argument (Cephes)
+ */
+static NMEA_GEO_INLINE double nmea_geo_atan(double x)
+{
+    double sign = (x < 0)?-1.0:1.0;
+    double ax = x * sign;
+    int big = (ax > 2.41421356237309504880);
+    int mid = !big && (ax > 0.66);
+    double y = big?(NMEA_PI / 2):(mid?(NMEA_PI / 4):0.0);
+    double more = big?6.123233995736765886130e-17:(mid?(0.5 * 6.123233995736765886130e-17):0.0);
+    double z;
+
+    ax = big?(-1.0 / ax):(mid?((ax - 1.0) / (ax + 1.0)):ax);
+    z = ax * ax;
+    z = z * ((((-8.750608600031904122785e-01 * z - 1.615753718733365076637e+01) * z
+        - 7.500855792314704667340e+01) * z - 1.228866684490136173410e+02) * z - 6.485021904942025371773e+01)
+        / (((((z + 2.485846490142306297962e+01) * z + 1.650270098316988542046e+02) * z
+        + 4.328810604912902668951e+02) * z + 4.853903996359136964868e+02) * z + 1.945506571482613964425e+02);
+
+    return sign * (y + (ax * z + ax + more));
+}
+
+/**
+ * \brief asin of argument in [-1, 1]
+ */
+static NMEA_GEO_INLINE double nmea_geo_asin(double x)
+{
+    double t = (1.0 - x) * (1.0 + x);
+    return nmea_geo_atan(x / sqrt((t > 0)?t:0.0));
+}
+
+/**
+ * \brief acos of argument in [-1, 1]
+ */
+static NMEA_GEO_INLINE double nmea_geo_acos(double x)
+{
+    double t = (1.0 - x) * (1.0 + x);
+    double a = nmea_geo_atan(sqrt((t > 0)?t:0.0) / ((x < 0)?-x:x));
+    return (x < 0)?(NMEA_PI - a):a;
+}
+
+/*
+ * block kernels
+ */
+
+static NMEA_GEO_INLINE void nmea_geo_sphere_block(
+    const double *lat1, const double *lon1,
+    const double *lat2, const double *lon2,
+    double *dist
+    )
+{
+    double sin1[NMEA_GEO_LANES], cos1[NMEA_GEO_LANES];
+    double sin2[NMEA_GEO_LANES], cos2[NMEA_GEO_LANES];
+    double sinl[NMEA_GEO_LANES], cosl[NMEA_GEO_LANES];
+    int i;
+
+    for(i = 0; i < NMEA_GEO_LANES; ++i)
+    {
+        nmea_geo_sincos(lat1[i], &sin1[i], &cos1[i]);
+        nmea_geo_sincos(lat2[i], &sin2[i], &cos2[i]);
+        nmea_geo_sincos(lon2[i] - lon1[i], &sinl[i], &cosl[i]);
+    }
+
+    for(i = 0; i < NMEA_GEO_LANES; ++i)
+        dist[i] = ((double)NMEA_EARTHRADIUS_M) * nmea_geo_acos(sin2[i] * sin1[i] + cos2[i] * cos1[i] * cosl[i]);
+}
+
+/*
+ * The same formulas and the same order of operations as nmea_distance_ellipsoid,
+ * every lane iterates until its own convergence.
+ */
+static NMEA_GEO_INLINE void nmea_geo_ellipsoid_block(
+    const double *lat1, const double *lon1,
+    const double *lat2, const double *lon2,
+    double *dist, double *azimuth1, double *azimuth2
+    )
+{
+    const double f = NMEA_EARTH_FLATTENING;
+    const double a = NMEA_EARTH_SEMIMAJORAXIS_M;
+    const double b = (1 - f) * a;
+    const double sqr_a = a * a;
+    const double sqr_b = b * b;
+
+    double L[NMEA_GEO_LANES], sin_U1[NMEA_GEO_LANES], sin_U2[NMEA_GEO_LANES], cos_U1[NMEA_GEO_LANES], cos_U2[NMEA_GEO_LANES];
+    double sigma[NMEA_GEO_LANES], sin_sigma[NMEA_GEO_LANES], cos_sigma[NMEA_GEO_LANES];
+    double cos_2_sigmam[NMEA_GEO_LANES], sqr_cos_2_sigmam[NMEA_GEO_LANES], sqr_cos_alpha[NMEA_GEO_LANES];
+    double lambda[NMEA_GEO_LANES], sin_lambda[NMEA_GEO_LANES], cos_lambda[NMEA_GEO_LANES], delta_lambda[NMEA_GEO_LANES];
+    int same[NMEA_GEO_LANES], active[NMEA_GEO_LANES];
+    int i, nactive, remaining_steps;
+
+    for(i = 0; i < NMEA_GEO_LANES; ++i)
+    {
+        double s, c, t;
+
+        same[i] = (lat1[i] == lat2[i]) && (lon1[i] == lon2[i]);
+        L[i] = lon2[i] - lon1[i];
+
+        /* sin(atan(t)) and cos(atan(t)) of reduced latitudes */
+        nmea_geo_sincos(lat1[i], &s, &c);
+        t = (1 - f) * (s / c);
+        cos_U1[i] = 1 / sqrt(1 + t * t);
+        sin_U1[i] = t * cos_U1[i];
+        nmea_geo_sincos(lat2[i], &s, &c);
+        t = (1 - f) * (s / c);
+        cos_U2[i] = 1 / sqrt(1 + t * t);
+        sin_U2[i] = t * cos_U2[i];
+
+        sigma[i] = 0;
+        sin_sigma[i] = 0;
+        cos_sigma[i] = 1;
+        cos_2_sigmam[i] = 0;
+        sqr_cos_2_sigmam[i] = 0;
+        sqr_cos_alpha[i] = 0;
+        lambda[i] = L[i];
+        nmea_geo_sincos(lambda[i], &sin_lambda[i], &cos_lambda[i]);
+        delta_lambda[i] = lambda[i];
+    }
+
+    for(remaining_steps = NMEA_GEO_STEPS; remaining_steps > 0; --remaining_steps)
+    {
+        for(i = 0, nactive = 0; i < NMEA_GEO_LANES; ++i)
+        {
+            active[i] = (delta_lambda[i] > 1e-12);
+            nactive += active[i];
+        }
+
+        if(!nactive)
+            break;
+
+        for(i = 0; i < NMEA_GEO_LANES; ++i)
+        {
+            double tmp1, tmp2, sin_s, cos_s, sin_alpha, sqr_ca, cos_2sm, sqr_cos_2sm, C, s, new_lambda, d;
+
+            tmp1 = cos_U2[i] * sin_lambda[i];
+            tmp2 = cos_U1[i] * sin_U2[i] - sin_U1[i] * cos_U2[i] * cos_lambda[i];
+            sin_s = sqrt(tmp1 * tmp1 + tmp2 * tmp2);
+            cos_s = sin_U1[i] * sin_U2[i] + cos_U1[i] * cos_U2[i] * cos_lambda[i];
+            sin_alpha = cos_U1[i] * cos_U2[i] * sin_lambda[i] / sin_s;
+            sqr_ca = 1 - sin_alpha * sin_alpha;     /* cos(asin(sin_alpha))^2 */
+            cos_2sm = cos_s - 2 * sin_U1[i] * sin_U2[i] / sqr_ca;
+            sqr_cos_2sm = cos_2sm * cos_2sm;
+            C = f / 16 * sqr_ca * (4 + f * (4 - 3 * sqr_ca));
+            s = nmea_geo_asin(sin_s);
+            new_lambda = L[i] +
+                (1 - C) * f * sin_alpha
+                * (s + C * sin_s * (cos_2sm + C * cos_s * (-1 + 2 * sqr_cos_2sm)));
+            d = lambda[i] - new_lambda;
+
+            /* converged lanes keep their values */
+            sin_sigma[i] = active[i]?sin_s:sin_sigma[i];
+            cos_sigma[i] = active[i]?cos_s:cos_sigma[i];
+            sqr_cos_alpha[i] = active[i]?sqr_ca:sqr_cos_alpha[i];
+            cos_2_sigmam[i] = active[i]?cos_2sm:cos_2_sigmam[i];
+            sqr_cos_2_sigmam[i] = active[i]?sqr_cos_2sm:sqr_cos_2_sigmam[i];
+            sigma[i] = active[i]?s:sigma[i];
+            lambda[i] = active[i]?new_lambda:lambda[i];
+            delta_lambda[i] = active[i]?((d < 0)?-d:d):delta_lambda[i];
+        }
+
+        for(i = 0; i < NMEA_GEO_LANES; ++i)
+        {
+            double s, c;
+            nmea_geo_sincos(lambda[i], &s, &c);
+            sin_lambda[i] = active[i]?s:sin_lambda[i];
+            cos_lambda[i] = active[i]?c:cos_lambda[i];
+        }
+    }
+
+    for(i = 0; i < NMEA_GEO_LANES; ++i)
+    {
+        double sqr_u, A, B, delta_sigma;
+
+        sqr_u = sqr_cos_alpha[i] * (sqr_a - sqr_b) / sqr_b;
+        A = 1 + sqr_u / 16384 * (4096 + sqr_u * (-768 + sqr_u * (320 - 175 * sqr_u)));
+        B = sqr_u / 1024 * (256 + sqr_u * (-128 + sqr_u * (74 - 47 * sqr_u)));
+        delta_sigma = B * sin_sigma[i] * (
+            cos_2_sigmam[i] + B / 4 * (
+            cos_sigma[i] * (-1 + 2 * sqr_cos_2_sigmam[i]) -
+            B / 6 * cos_2_sigmam[i] * (-3 + 4 * sin_sigma[i] * sin_sigma[i]) * (-3 + 4 * sqr_cos_2_sigmam[i])
+            ));
+
+        dist[i] = same[i]?0:(b * A * (sigma[i] - delta_sigma));
+    }
+
+    if(azimuth1)
+    {
+        for(i = 0; i < NMEA_GEO_LANES; ++i)
+        {
+            double a1 = nmea_geo_atan(cos_U2[i] * sin_lambda[i] / (cos_U1[i] * sin_U2[i] - sin_U1[i] * cos_U2[i] * cos_lambda[i]));
+            double a2 = nmea_geo_atan(cos_U1[i] * sin_lambda[i] / (-sin_U1[i] * cos_U2[i] + cos_U1[i] * sin_U2[i] * cos_lambda[i]));
+            azimuth1[i] = same[i]?0:a1;
+            azimuth2[i] = same[i]?0:a2;
+        }
+    }
+}
+
+/**
+ * \brief Gather block of position pairs into lanes
+ * Missing pairs of the last block repeat the last pair.
+ */
+static void nmea_geo_gather(
+    const nmeaPOS *from_pos, const nmeaPOS *to_pos, size_t count,
+    double *lat1, double *lon1, double *lat2, double *lon2
+    )
+{
+    size_t i, j;
+
+    for(i = 0; i < NMEA_GEO_LANES; ++i)
+    {
+        j = (i < count)?i:(count - 1);
+        lat1[i] = from_pos[j].lat;
+        lon1[i] = from_pos[j].lon;
+        lat2[i] = to_pos[j].lat;
+        lon2[i] = to_pos[j].lon;
+    }
+}
+
+/**
+ * \brief Calculate distances between arrays of points
+ * The same as nmea_distance for every pair of points.
+ * @param from_pos array of positions in radians.
+ * @param to_pos array of positions in radians.
+ * @param dist (O) array of distances in meters.
+ * @param count number of pairs.
+ */
+void nmea_distance_batch(
+        const nmeaPOS *from_pos,
+        const nmeaPOS *to_pos,
+        double *dist,
+        size_t count
+        )
+{
+    double lat1[NMEA_GEO_LANES], lon1[NMEA_GEO_LANES], lat2[NMEA_GEO_LANES], lon2[NMEA_GEO_LANES];
+    double res[NMEA_GEO_LANES];
+    size_t it, i, n;
+
+    NMEA_ASSERT(from_pos && to_pos && dist);
+
+    for(it = 0; it < count; it += NMEA_GEO_LANES)
+    {
+        n = (count - it < NMEA_GEO_LANES)?(count - it):NMEA_GEO_LANES;
+        nmea_geo_gather(from_pos + it, to_pos + it, n, lat1, lon1, lat2, lon2);
+        nmea_geo_sphere_block(lat1, lon1, lat2, lon2, res);
+        for(i = 0; i < n; ++i)
+            dist[it + i] = res[i];
+    }
+}
+
+/**
+ * \brief Calculate distances between arrays of points on ellipsoid
+ * The same as nmea_distance_ellipsoid for every pair of points.
+ * @param from_pos array of positions in radians.
+ * @param to_pos array of positions in radians.
+ * @param dist (O) array of distances in meters.
+ * @param from_azimuth (O) array of azimuths at "from" positions in radians (may be null).
+ * @param to_azimuth (O) array of azimuths at "to" positions in radians (may be null).
+ * @param count number of pairs.
+ */
+void nmea_distance_ellipsoid_batch(
+        const nmeaPOS *from_pos,
+        const nmeaPOS *to_pos,
+        double *dist,
+        double *from_azimuth,
+        double *to_azimuth,
+        size_t count
+        )
+{
+    double lat1[NMEA_GEO_LANES], lon1[NMEA_GEO_LANES], lat2[NMEA_GEO_LANES], lon2[NMEA_GEO_LANES];
+    double res[NMEA_GEO_LANES], az1[NMEA_GEO_LANES], az2[NMEA_GEO_LANES];
+    int azimuth = (from_azimuth || to_azimuth);
+    size_t it, i, n;
+
+    NMEA_ASSERT(from_pos && to_pos && dist);
+
+    for(it = 0; it < count; it += NMEA_GEO_LANES)
+    {
+        n = (count - it < NMEA_GEO_LANES)?(count - it):NMEA_GEO_LANES;
+        nmea_geo_gather(from_pos + it, to_pos + it, n, lat1, lon1, lat2, lon2);
+        nmea_geo_ellipsoid_block(lat1, lon1, lat2, lon2, res, azimuth?az1:0, azimuth?az2:0);
+        for(i = 0; i < n; ++i)
+        {
+            dist[it + i] = res[i];
+            if(from_azimuth)
+                from_azimuth[it + i] = az1[i];
+            if(to_azimuth)
+                to_azimuth[it + i] = az2[i];
+        }
+    }
+}
@@ -11,6 +11,7 @@
 /*! \file gmath.h */
 
 #include "gmath.h"
+#include "degree.h"
 
 #include <math.h>
 #include <float.h>
@@ -51,6 +52,82 @@ double nmea_degree2ndeg(double val)
     return val;
 }
 
+/*
+ * Array conversions, loops have no dependencies between elements so they
+ * are vectorized by compiler. Conversion in place (same input and output
+ * array) is allowed.
+ */
+
+/**
+ * \brief Convert array of NDEG (NMEA degree) to fractional degrees
+ */
+void nmea_ndeg2degree_batch(const double *ndeg, double *deg, int count)
+{
+    int it;
+    for(it = 0; it < count; ++it)
+        deg[it] = nmea_fast_ndeg2degree(ndeg[it]);
+}
+
+/**
+ * \brief Convert array of fractional degrees to NDEG (NMEA degree)
+ */
+void nmea_degree2ndeg_batch(const double *deg, double *ndeg, int count)
+{
+    int it;
+    for(it = 0; it < count; ++it)
+        ndeg[it] = nmea_fast_degree2ndeg(deg[it]);
+}
+
+/**
+ * \brief Convert array of degrees to radians
+ */
+void nmea_degree2radian_batch(const double *deg, double *rad, int count)
+{
+    int it;
+    for(it = 0; it < count; ++it)
+        rad[it] = deg[it] * NMEA_PI180;
+}
+
+/**
+ * \brief Convert array of NDEG (NMEA degree) to radians
+ */
+void nmea_ndeg2radian_batch(const double *ndeg, double *rad, int count)
+{
+    int it;
+    for(it = 0; it < count; ++it)
+        rad[it] = nmea_fast_ndeg2radian(ndeg[it]);
+}
+
+/**
+ * \brief Convert array of radians to NDEG (NMEA degree)
+ */
+void nmea_radian2ndeg_batch(const double *rad, double *ndeg, int count)
+{
+    int it;
+    for(it = 0; it < count; ++it)
+        ndeg[it] = nmea_fast_radian2ndeg(rad[it]);
+}
+
+/**
+ * \brief Convert array of NDEG (NMEA degree) to micro-degrees
+ */
+void nmea_ndeg2udeg_batch(const double *ndeg, int *udeg, int count)
+{
+    int it;
+    for(it = 0; it < count; ++it)
+        udeg[it] = nmea_fast_ndeg2udeg(ndeg[it]);
+}
+
+/**
+ * \brief Convert array of micro-degrees to fractional degrees
+ */
+void nmea_udeg2degree_batch(const int *udeg, double *deg, int count)
+{
+    int it;
+    for(it = 0; it < count; ++it)
+        deg[it] = nmea_fast_udeg2degree(udeg[it]);
+}
+
 /**
  * \fn nmea_ndeg2radian
  * \brief Convert NDEG (NMEA degree) to radian
@@ -16,6 +16,7 @@ void nmea_zero_INFO(nmeaINFO *info)
 {
     memset(info, 0, sizeof(nmeaINFO));
     nmea_time_now(&info->utc);
+    info->utc_us = nmea_time_to_us(&info->utc);
     info->sig = NMEA_SIG_BAD;
     info->fix = NMEA_FIX_BAD;
 }
@@ -15,41 +15,12 @@
  *
  * \code
  * ...
- * ptype = nmea_pack_type(
- *     (const char *)parser->buffer + nparsed + 1,
- *     parser->buff_use - nparsed - 1);
- * 
- * if(0 == (node = malloc(sizeof(nmeaParserNODE))))
- *     goto mem_fail;
- * 
- * node->pack = 0;
- * 
- * switch(ptype)
- * {
- * case GPGGA:
- *     if(0 == (node->pack = malloc(sizeof(nmeaGPGGA))))
- *         goto mem_fail;
- *     node->packType = GPGGA;
- *     if(!nmea_parse_GPGGA(
- *         (const char *)parser->buffer + nparsed,
- *         sen_sz, (nmeaGPGGA *)node->pack))
- *     {
- *         free(node);
- *         node = 0;
- *     }
- *     break;
- * case GPGSA:
- *     if(0 == (node->pack = malloc(sizeof(nmeaGPGSA))))
- *         goto mem_fail;
- *     node->packType = GPGSA;
- *     if(!nmea_parse_GPGSA(
- *         (const char *)parser->buffer + nparsed,
- *         sen_sz, (nmeaGPGSA *)node->pack))
- *     {
- *         free(node);
- *         node = 0;
- *     }
- *     break;
+ * if(GPNON == (ptype = nmea_pack_type(sen + 1, sen_sz - 1)))
+ *     return;
+ *
+ * node = nmea_parser_queue_tail(parser, offset);
+ *
+ * code = nmea_parse_pack(ptype, sen, sen_sz, &node->pack, &field);
  * ...
  * \endcode
  */
@@ -58,40 +29,163 @@
 #include "parse.h"
 #include "context.h"
 #include "gmath.h"
+#include "degree.h"
 #include "units.h"
+#include "stats.h"
 
 #include <string.h>
+#include <stddef.h>
 #include <stdio.h>
 
-int _nmea_parse_time(const char *buff, int buff_sz, nmeaTIME *res)
+#define NMEA_DIGIT(c)   ((unsigned int)((unsigned char)(c) - '0'))
+
+/**
+ * \brief Time of day (hhmmss, hhmmss.s, hhmmss.ss or hhmmss.sss) by digits at fixed offsets
+ * @param buff a constant character pointer of time token.
+ * @param buff_sz token size.
+ * @param res (O) hour, min, sec and hsec of time.
+ * @return Time of day in microseconds or -1 if token is not a time
+ */
+static long long _nmea_parse_time(const char *buff, int buff_sz, nmeaTIME *res)
 {
-    int success = 0;
+    static const long long frac_us[] = { 100000, 10000, 1000 };
+    unsigned int d[6];
+    long long frac = 0;
+    int it;
 
-    switch(buff_sz)
+    if(buff_sz != 6 && (buff_sz < 8 || buff_sz > 10 || '.' != buff[6]))
+        return -1;
+
+    for(it = 0; it < 6; ++it)
     {
-    case sizeof("hhmmss") - 1:
-        success = (3 == nmea_scanf(buff, buff_sz,
-            "%2d%2d%2d", &(res->hour), &(res->min), &(res->sec)
-            ));
-        break;
-    case sizeof("hhmmss.s") - 1:
-    case sizeof("hhmmss.ss") - 1:
-    case sizeof("hhmmss.sss") - 1:
-        success = (4 == nmea_scanf(buff, buff_sz,
-            "%2d%2d%2d.%d", &(res->hour), &(res->min), &(res->sec), &(res->hsec)
-            ));
-        break;
-    default:
-        nmea_error("Parse of time error (format error)!");
-        success = 0;
-        break;
+        if((d[it] = NMEA_DIGIT(buff[it])) > 9)
+            return -1;
     }
 
-    return (success?0:-1);        
+    for(it = 7; it < buff_sz; ++it)
+    {
+        if(NMEA_DIGIT(buff[it]) > 9)
+            return -1;
+        frac = frac * 10 + NMEA_DIGIT(buff[it]);
+    }
+    if(buff_sz > 6)
+        frac *= frac_us[buff_sz - 8];
+
+    res->hour = (int)(d[0] * 10 + d[1]);
+    res->min = (int)(d[2] * 10 + d[3]);
+    res->sec = (int)(d[4] * 10 + d[5]);
+    res->hsec = (int)(frac / 10000);
+
+    return ((res->hour * 60 + res->min) * 60 + res->sec) * NMEA_TIME_SEC_US + frac;
+}
+
+/**
+ * \brief Complete date of RMC packet (ddmmyy fields as decoded) and its time in microseconds
+ */
+static void _nmea_parse_date(nmeaGPRMC *pack, long long tod_us)
+{
+    if(pack->utc.year < 90)
+        pack->utc.year += 100;
+    pack->utc.mon -= 1;
+
+    pack->utc_us = nmea_time_days(pack->utc.year, pack->utc.mon, pack->utc.day) * NMEA_TIME_DAY_US + tod_us;
+}
+
+/*
+ * Registration tables of talkers and sentences. Header is dispatched by
+ * direct lookup of talker and hashed lookup of sentence, so cost does not
+ * grow with number of registered types. New sentence is registered by
+ * row in nmea_sentence_tab and decoder case in parser.
+ */
+
+typedef struct _nmeaHEADTYPE
+{
+    const char *id;
+    int type;
+
+} nmeaHEADTYPE;
+
+static const nmeaHEADTYPE nmea_talker_tab[] = {
+    { "GP", NMEA_TALKER_GP },
+    { "GN", NMEA_TALKER_GN },
+    { "GL", NMEA_TALKER_GL },
+    { "GA", NMEA_TALKER_GA },
+    { "BD", NMEA_TALKER_BD },
+    { "GB", NMEA_TALKER_GB },
+    { "GQ", NMEA_TALKER_GQ }
+};
+
+static const nmeaHEADTYPE nmea_sentence_tab[] = {
+    { "GGA", GPGGA },
+    { "GSA", GPGSA },
+    { "GSV", GPGSV },
+    { "RMC", GPRMC },
+    { "VTG", GPVTG }
+};
+
+#define NMEA_TALKER_INDEX(c0, c1) \
+    ((unsigned int)((unsigned char)(c0) - 'A') * 26 + (unsigned int)((unsigned char)(c1) - 'A'))
+#define NMEA_SENTENCE_KEY(s) \
+    (((unsigned int)(unsigned char)(s)[0] << 16) | ((unsigned int)(unsigned char)(s)[1] << 8) | (unsigned char)(s)[2])
+#define NMEA_SENTENCE_HASHBITS  (5)
+#define NMEA_SENTENCE_HASHMASK  ((1u << NMEA_SENTENCE_HASHBITS) - 1)
+#define NMEA_SENTENCE_HASH(key) ((unsigned int)((key) * 2654435761u) >> (32 - NMEA_SENTENCE_HASHBITS))
+
+static signed char nmea_talker_map[26 * 26];
+static unsigned int nmea_sentence_keys[1 << NMEA_SENTENCE_HASHBITS];
+static int nmea_sentence_types[1 << NMEA_SENTENCE_HASHBITS];
+
+static int nmea_head_init()
+{
+    unsigned int it, key, slot;
+
+    memset(nmea_talker_map, -1, sizeof(nmea_talker_map));
+
+    for(it = 0; it < sizeof(nmea_talker_tab) / sizeof(nmea_talker_tab[0]); ++it)
+        nmea_talker_map[NMEA_TALKER_INDEX(nmea_talker_tab[it].id[0], nmea_talker_tab[it].id[1])] =
+            (signed char)nmea_talker_tab[it].type;
+
+    /* open addressing, table is kept at most half full */
+    for(it = 0; it < sizeof(nmea_sentence_tab) / sizeof(nmea_sentence_tab[0]); ++it)
+    {
+        key = NMEA_SENTENCE_KEY(nmea_sentence_tab[it].id);
+        for(slot = NMEA_SENTENCE_HASH(key); nmea_sentence_keys[slot]; slot = (slot + 1) & NMEA_SENTENCE_HASHMASK);
+        nmea_sentence_keys[slot] = key;
+        nmea_sentence_types[slot] = nmea_sentence_tab[it].type;
+    }
+
+    return 1;
+}
+
+static int nmea_head_ready = nmea_head_init();
+
+/**
+ * \brief Define talker of packet by header (nmeaTALKER).
+ * @param buff a constant character pointer of packet buffer (after '$').
+ * @param buff_sz buffer size.
+ * @return The defined talker or -1 if talker is not registered
+ * @see nmeaTALKER
+ */
+int nmea_talker_type(const char *buff, int buff_sz)
+{
+    unsigned int idx;
+
+    NMEA_ASSERT(buff && nmea_head_ready);
+
+    if(buff_sz < 2)
+        return -1;
+
+    if((unsigned char)(buff[0] - 'A') >= 26 || (unsigned char)(buff[1] - 'A') >= 26)
+        return -1;
+
+    idx = NMEA_TALKER_INDEX(buff[0], buff[1]);
+
+    return nmea_talker_map[idx];
 }
 
 /**
  * \brief Define packet type by header (nmeaPACKTYPE).
+ * Sentence of any registered talker gives the same packet type.
  * @param buff a constant character pointer of packet buffer.
  * @param buff_sz buffer size.
  * @return The defined packet type
@@ -99,28 +193,20 @@ int _nmea_parse_time(const char *buff, int buff_sz, nmeaTIME *res)
  */
 int nmea_pack_type(const char *buff, int buff_sz)
 {
-    static const char *pheads[] = {
-        "GPGGA",
-        "GPGSA",
-        "GPGSV",
-        "GPRMC",
-        "GPVTG",
-    };
+    unsigned int key, slot;
 
     NMEA_ASSERT(buff);
 
-    if(buff_sz < 5)
+    if(buff_sz < 5 || nmea_talker_type(buff, buff_sz) < 0)
         return GPNON;
-    else if(0 == memcmp(buff, pheads[0], 5))
-        return GPGGA;
-    else if(0 == memcmp(buff, pheads[1], 5))
-        return GPGSA;
-    else if(0 == memcmp(buff, pheads[2], 5))
-        return GPGSV;
-    else if(0 == memcmp(buff, pheads[3], 5))
-        return GPRMC;
-    else if(0 == memcmp(buff, pheads[4], 5))
-        return GPVTG;
+
+    key = NMEA_SENTENCE_KEY(buff + 2);
+
+    for(slot = NMEA_SENTENCE_HASH(key); nmea_sentence_keys[slot]; slot = (slot + 1) & NMEA_SENTENCE_HASHMASK)
+    {
+        if(key == nmea_sentence_keys[slot])
+            return nmea_sentence_types[slot];
+    }
 
     return GPNON;
 }
@@ -136,7 +222,6 @@ int nmea_find_tail(const char *buff, int buff_sz, int *res_crc)
 {
     static const int tail_sz = 3 /* *[CRC] */ + 2 /* \r\n */;
 
-    const char *end_buff = buff + buff_sz;
     int nread = 0;
     int crc = 0;
 
@@ -144,36 +229,305 @@ int nmea_find_tail(const char *buff, int buff_sz, int *res_crc)
 
     *res_crc = -1;
 
-    for(;buff < end_buff; ++buff, ++nread)
+    if(buff_sz <= 0)
+        return 0;
+
+    /* first byte is not a part of control sum */
+    if('*' != *buff)
+        nread = 1 + nmea_scan_delim(buff + 1, buff_sz - 1, &crc);
+
+    if(nread == buff_sz)
+        nread = 0;
+    else if('*' == buff[nread])
     {
-        if(('$' == *buff) && nread)
+        if(nread + tail_sz <= buff_sz && '\r' == buff[nread + 3] && '\n' == buff[nread + 4])
         {
-            buff = 0;
-            break;
+            *res_crc = nmea_atoi(buff + nread + 1, 2, 16);
+            if(*res_crc != crc)
+                *res_crc = -1;
+            nread += tail_sz;
         }
-        else if('*' == *buff)
-        {
-            if(buff + tail_sz <= end_buff && '\r' == buff[3] && '\n' == buff[4])
-            {
-                *res_crc = nmea_atoi(buff + 1, 2, 16);
-                nread = buff_sz - (int)(end_buff - (buff + tail_sz));
-                if(*res_crc != crc)
-                {
-                    *res_crc = -1;
-                    buff = 0;
-                }
-            }
+        else
+            nread = 0;
+    }
 
-            break;
-        }
-        else if(nread)
-            crc ^= (int)*buff;
+    return nread;
+}
+
+/*
+ * Field tables of sentences, the same layout as nmea_scanf formats
+ * of reference decoders (nmea_scanf_GPxxx)
+ */
+
+#define NMEA_FIELD(type, delim, pack, member) { type, delim, (int)offsetof(pack, member), 0 }
+#define NMEA_FIELD2(type, delim, pack, member, member2) { type, delim, (int)offsetof(pack, member), (int)offsetof(pack, member2) }
+
+static const nmeaFIELD nmea_fields_GPGGA[] = {
+    { NMEA_FIELD_STR, ',', 0, 0 },
+    NMEA_FIELD2(NMEA_FIELD_NDEG,    ',', nmeaGPGGA, lat, lat_udeg),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPGGA, ns),
+    NMEA_FIELD2(NMEA_FIELD_NDEG,    ',', nmeaGPGGA, lon, lon_udeg),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPGGA, ew),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGGA, sig),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGGA, satinuse),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPGGA, HDOP),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPGGA, elv),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPGGA, elv_units),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPGGA, diff),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPGGA, diff_units),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPGGA, dgps_age),
+    NMEA_FIELD(NMEA_FIELD_INT,      '*', nmeaGPGGA, dgps_sid)
+};
+
+static const nmeaFIELD nmea_fields_GPGSA[] = {
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPGSA, fix_mode),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, fix_type),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[0]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[1]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[2]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[3]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[4]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[5]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[6]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[7]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[8]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[9]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[10]),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSA, sat_prn[11]),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPGSA, PDOP),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPGSA, HDOP),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   '*', nmeaGPGSA, VDOP)
+};
+
+#define NMEA_FIELDS_GSV_SAT(idx, last_delim) \
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSV, sat_data[idx].id), \
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSV, sat_data[idx].elv), \
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSV, sat_data[idx].azimuth), \
+    NMEA_FIELD(NMEA_FIELD_INT,      last_delim, nmeaGPGSV, sat_data[idx].sig)
+
+static const nmeaFIELD nmea_fields_GPGSV[] = {
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSV, pack_count),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSV, pack_index),
+    NMEA_FIELD(NMEA_FIELD_INT,      ',', nmeaGPGSV, sat_count),
+    NMEA_FIELDS_GSV_SAT(0, ','),
+    NMEA_FIELDS_GSV_SAT(1, ','),
+    NMEA_FIELDS_GSV_SAT(2, ','),
+    NMEA_FIELDS_GSV_SAT(3, '*')
+};
+
+static const nmeaFIELD nmea_fields_GPRMC[] = {
+    { NMEA_FIELD_STR, ',', 0, 0 },
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPRMC, status),
+    NMEA_FIELD2(NMEA_FIELD_NDEG,    ',', nmeaGPRMC, lat, lat_udeg),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPRMC, ns),
+    NMEA_FIELD2(NMEA_FIELD_NDEG,    ',', nmeaGPRMC, lon, lon_udeg),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPRMC, ew),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPRMC, speed),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPRMC, direction),
+    NMEA_FIELD(NMEA_FIELD_INT2,       0, nmeaGPRMC, utc.day),
+    NMEA_FIELD(NMEA_FIELD_INT2,       0, nmeaGPRMC, utc.mon),
+    NMEA_FIELD(NMEA_FIELD_INT2,     ',', nmeaGPRMC, utc.year),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPRMC, declination),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPRMC, declin_ew),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     '*', nmeaGPRMC, mode)
+};
+
+static const nmeaFIELD nmea_fields_GPVTG[] = {
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPVTG, dir),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPVTG, dir_t),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPVTG, dec),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPVTG, dec_m),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPVTG, spn),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     ',', nmeaGPVTG, spn_n),
+    NMEA_FIELD(NMEA_FIELD_DOUBLE,   ',', nmeaGPVTG, spk),
+    NMEA_FIELD(NMEA_FIELD_CHAR,     '*', nmeaGPVTG, spk_k)
+};
+
+#define NMEA_NFIELDS(fields) ((int)(sizeof(fields) / sizeof(fields[0])))
+
+/**
+ * \brief Decode GGA packet, error code and index of first bad field instead of messages
+ */
+static int nmea_decode_GPGGA(const char *buff, int buff_sz, nmeaGPGGA *pack, int *field)
+{
+    const char *time_str = 0;
+    int time_sz = 0, nsen;
+
+    memset(pack, 0, sizeof(nmeaGPGGA));
+
+    nsen = (nmea_talker_type(buff + 1, buff_sz - 1) < 0)?0:nmea_scan_fields(buff, buff_sz, "$??GGA,",
+        nmea_fields_GPGGA, NMEA_NFIELDS(nmea_fields_GPGGA), pack, &time_str, &time_sz);
+
+    if(14 != nsen)
+    {
+        *field = nsen;
+        return NMEA_ERR_FIELDS;
     }
 
-    if(*res_crc < 0 && buff)
-        nread = 0;
+    if(0 > (pack->utc_us = _nmea_parse_time(time_str, time_sz, &(pack->utc))))
+    {
+        *field = 0;
+        return NMEA_ERR_TIME;
+    }
 
-    return nread;
+    return NMEA_ERR_NONE;
+}
+
+static int nmea_decode_GPGSA(const char *buff, int buff_sz, nmeaGPGSA *pack, int *field)
+{
+    int nsen;
+
+    memset(pack, 0, sizeof(nmeaGPGSA));
+
+    nsen = (nmea_talker_type(buff + 1, buff_sz - 1) < 0)?0:nmea_scan_fields(buff, buff_sz, "$??GSA,",
+        nmea_fields_GPGSA, NMEA_NFIELDS(nmea_fields_GPGSA), pack, 0, 0);
+
+    if(17 != nsen)
+    {
+        *field = nsen;
+        return NMEA_ERR_FIELDS;
+    }
+
+    pack->talker = nmea_talker_type(buff + 1, buff_sz - 1);
+
+    return NMEA_ERR_NONE;
+}
+
+static int nmea_decode_GPGSV(const char *buff, int buff_sz, nmeaGPGSV *pack, int *field)
+{
+    int nsen, nsat;
+
+    memset(pack, 0, sizeof(nmeaGPGSV));
+
+    nsen = (nmea_talker_type(buff + 1, buff_sz - 1) < 0)?0:nmea_scan_fields(buff, buff_sz, "$??GSV,",
+        nmea_fields_GPGSV, NMEA_NFIELDS(nmea_fields_GPGSV), pack, 0, 0);
+
+    nsat = (pack->pack_index - 1) * NMEA_SATINPACK;
+    nsat = (nsat + NMEA_SATINPACK > pack->sat_count)?pack->sat_count - nsat:NMEA_SATINPACK;
+    nsat = nsat * 4 + 3 /* first three sentence`s */;
+
+    if(nsen < nsat || nsen > (NMEA_SATINPACK * 4 + 3))
+    {
+        *field = nsen;
+        return NMEA_ERR_FIELDS;
+    }
+
+    pack->talker = nmea_talker_type(buff + 1, buff_sz - 1);
+
+    return NMEA_ERR_NONE;
+}
+
+static int nmea_decode_GPRMC(const char *buff, int buff_sz, nmeaGPRMC *pack, int *field)
+{
+    int nsen;
+    const char *time_str = 0;
+    int time_sz = 0;
+    long long tod_us;
+
+    memset(pack, 0, sizeof(nmeaGPRMC));
+
+    nsen = (nmea_talker_type(buff + 1, buff_sz - 1) < 0)?0:nmea_scan_fields(buff, buff_sz, "$??RMC,",
+        nmea_fields_GPRMC, NMEA_NFIELDS(nmea_fields_GPRMC), pack, &time_str, &time_sz);
+
+    if(nsen != 13 && nsen != 14)
+    {
+        *field = nsen;
+        return NMEA_ERR_FIELDS;
+    }
+
+    if(0 > (tod_us = _nmea_parse_time(time_str, time_sz, &(pack->utc))))
+    {
+        *field = 0;
+        return NMEA_ERR_TIME;
+    }
+
+    _nmea_parse_date(pack, tod_us);
+
+    return NMEA_ERR_NONE;
+}
+
+static int nmea_decode_GPVTG(const char *buff, int buff_sz, nmeaGPVTG *pack, int *field)
+{
+    int nsen;
+
+    memset(pack, 0, sizeof(nmeaGPVTG));
+
+    nsen = (nmea_talker_type(buff + 1, buff_sz - 1) < 0)?0:nmea_scan_fields(buff, buff_sz, "$??VTG,",
+        nmea_fields_GPVTG, NMEA_NFIELDS(nmea_fields_GPVTG), pack, 0, 0);
+
+    if(8 != nsen)
+    {
+        *field = nsen;
+        return NMEA_ERR_FIELDS;
+    }
+
+    if(pack->dir_t != 'T')
+        *field = 1;
+    else if(pack->dec_m != 'M')
+        *field = 3;
+    else if(pack->spn_n != 'N')
+        *field = 5;
+    else if(pack->spk_k != 'K')
+        *field = 7;
+    else
+        return NMEA_ERR_NONE;
+
+    return NMEA_ERR_FORMAT;
+}
+
+/**
+ * \brief Decode packet of known type from buffer, nothing is traced or reported
+ * Decoder of nmeaPARSER, it reports the code to the sink of the parser.
+ * @param ptype packet type (nmea_pack_type of the sentence).
+ * @param buff a constant character pointer of packet buffer.
+ * @param buff_sz buffer size.
+ * @param pack a pointer of packet structure of ptype which will filled by function.
+ * @param field set to index of first field not decoded when it is about a field.
+ * @return NMEA_ERR_NONE or error code (nmeaERRCODE)
+ */
+int nmea_parse_pack(int ptype, const char *buff, int buff_sz, void *pack, int *field)
+{
+    NMEA_ASSERT(buff && pack && field);
+
+    switch(ptype)
+    {
+    case GPGGA:
+        return nmea_decode_GPGGA(buff, buff_sz, (nmeaGPGGA *)pack, field);
+    case GPGSA:
+        return nmea_decode_GPGSA(buff, buff_sz, (nmeaGPGSA *)pack, field);
+    case GPGSV:
+        return nmea_decode_GPGSV(buff, buff_sz, (nmeaGPGSV *)pack, field);
+    case GPRMC:
+        return nmea_decode_GPRMC(buff, buff_sz, (nmeaGPRMC *)pack, field);
+    case GPVTG:
+        return nmea_decode_GPVTG(buff, buff_sz, (nmeaGPVTG *)pack, field);
+    };
+
+    return NMEA_ERR_TYPE;
+}
+
+/**
+ * \brief Result of nmea_parse_GPxxx, error is formatted for nmea_error only when there is a function to take it
+ */
+static int nmea_parse_result(int ptype, int code, int field)
+{
+    nmeaERROR error;
+    char buff[NMEA_CONVSTR_BUF];
+
+    if(NMEA_ERR_NONE == code)
+        return 1;
+
+    if(nmea_property()->error_func)
+    {
+        memset(&error, 0, sizeof(nmeaERROR));
+        error.code = code;
+        error.ptype = ptype;
+        error.field = field;
+        error.offset = -1;
+        nmea_error("%.*s", nmea_error_format(&error, &buff[0], NMEA_CONVSTR_BUF), &buff[0]);
+    }
+
+    return 0;
 }
 
 /**
@@ -184,8 +538,105 @@ int nmea_find_tail(const char *buff, int buff_sz, int *res_crc)
  * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
  */
 int nmea_parse_GPGGA(const char *buff, int buff_sz, nmeaGPGGA *pack)
+{
+    int field = -1;
+
+    NMEA_ASSERT(buff && pack);
+
+    nmea_trace_buff(buff, buff_sz);
+
+    return nmea_parse_result(GPGGA, nmea_decode_GPGGA(buff, buff_sz, pack, &field), field);
+}
+
+/**
+ * \brief Parse GSA packet from buffer.
+ * @param buff a constant character pointer of packet buffer.
+ * @param buff_sz buffer size.
+ * @param pack a pointer of packet which will filled by function.
+ * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
+ */
+int nmea_parse_GPGSA(const char *buff, int buff_sz, nmeaGPGSA *pack)
+{
+    int field = -1;
+
+    NMEA_ASSERT(buff && pack);
+
+    nmea_trace_buff(buff, buff_sz);
+
+    return nmea_parse_result(GPGSA, nmea_decode_GPGSA(buff, buff_sz, pack, &field), field);
+}
+
+/**
+ * \brief Parse GSV packet from buffer.
+ * @param buff a constant character pointer of packet buffer.
+ * @param buff_sz buffer size.
+ * @param pack a pointer of packet which will filled by function.
+ * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
+ */
+int nmea_parse_GPGSV(const char *buff, int buff_sz, nmeaGPGSV *pack)
+{
+    int field = -1;
+
+    NMEA_ASSERT(buff && pack);
+
+    nmea_trace_buff(buff, buff_sz);
+
+    return nmea_parse_result(GPGSV, nmea_decode_GPGSV(buff, buff_sz, pack, &field), field);
+}
+
+/**
+ * \brief Parse RMC packet from buffer.
+ * @param buff a constant character pointer of packet buffer.
+ * @param buff_sz buffer size.
+ * @param pack a pointer of packet which will filled by function.
+ * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
+ */
+int nmea_parse_GPRMC(const char *buff, int buff_sz, nmeaGPRMC *pack)
+{
+    int field = -1;
+
+    NMEA_ASSERT(buff && pack);
+
+    nmea_trace_buff(buff, buff_sz);
+
+    return nmea_parse_result(GPRMC, nmea_decode_GPRMC(buff, buff_sz, pack, &field), field);
+}
+
+/**
+ * \brief Parse VTG packet from buffer.
+ * @param buff a constant character pointer of packet buffer.
+ * @param buff_sz buffer size.
+ * @param pack a pointer of packet which will filled by function.
+ * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
+ */
+int nmea_parse_GPVTG(const char *buff, int buff_sz, nmeaGPVTG *pack)
+{
+    int field = -1;
+
+    NMEA_ASSERT(buff && pack);
+
+    nmea_trace_buff(buff, buff_sz);
+
+    return nmea_parse_result(GPVTG, nmea_decode_GPVTG(buff, buff_sz, pack, &field), field);
+}
+
+/*
+ * reference decoders (format driven, by nmea_scanf), GP talker only
+ */
+
+/**
+ * \brief Parse GGA packet from buffer by nmea_scanf (reference decoder).
+ * @param buff a constant character pointer of packet buffer.
+ * @param buff_sz buffer size.
+ * @param pack a pointer of packet which will filled by function.
+ * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
+ */
+int nmea_scanf_GPGGA(const char *buff, int buff_sz, nmeaGPGGA *pack)
 {
     char time_buff[NMEA_TIMEPARSE_BUF];
+    int nsen;
+
+    time_buff[0] = '\0';
 
     NMEA_ASSERT(buff && pack);
 
@@ -193,18 +644,23 @@ int nmea_parse_GPGGA(const char *buff, int buff_sz, nmeaGPGGA *pack)
 
     nmea_trace_buff(buff, buff_sz);
 
-    if(14 != nmea_scanf(buff, buff_sz,
+    nsen = nmea_scanf(buff, buff_sz,
         "$GPGGA,%s,%f,%C,%f,%C,%d,%d,%f,%f,%C,%f,%C,%f,%d*",
         &(time_buff[0]),
         &(pack->lat), &(pack->ns), &(pack->lon), &(pack->ew),
         &(pack->sig), &(pack->satinuse), &(pack->HDOP), &(pack->elv), &(pack->elv_units),
-        &(pack->diff), &(pack->diff_units), &(pack->dgps_age), &(pack->dgps_sid)))
+        &(pack->diff), &(pack->diff_units), &(pack->dgps_age), &(pack->dgps_sid));
+
+    pack->lat_udeg = nmea_fast_ndeg2udeg(pack->lat);
+    pack->lon_udeg = nmea_fast_ndeg2udeg(pack->lon);
+
+    if(14 != nsen)
     {
         nmea_error("GPGGA parse error!");
         return 0;
     }
 
-    if(0 != _nmea_parse_time(&time_buff[0], (int)strlen(&time_buff[0]), &(pack->utc)))
+    if(0 > (pack->utc_us = _nmea_parse_time(&time_buff[0], (int)strlen(&time_buff[0]), &(pack->utc))))
     {
         nmea_error("GPGGA time parse error!");
         return 0;
@@ -214,13 +670,13 @@ int nmea_parse_GPGGA(const char *buff, int buff_sz, nmeaGPGGA *pack)
 }
 
 /**
- * \brief Parse GSA packet from buffer.
+ * \brief Parse GSA packet from buffer by nmea_scanf (reference decoder).
  * @param buff a constant character pointer of packet buffer.
  * @param buff_sz buffer size.
  * @param pack a pointer of packet which will filled by function.
  * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
  */
-int nmea_parse_GPGSA(const char *buff, int buff_sz, nmeaGPGSA *pack)
+int nmea_scanf_GPGSA(const char *buff, int buff_sz, nmeaGPGSA *pack)
 {
     NMEA_ASSERT(buff && pack);
 
@@ -243,13 +699,13 @@ int nmea_parse_GPGSA(const char *buff, int buff_sz, nmeaGPGSA *pack)
 }
 
 /**
- * \brief Parse GSV packet from buffer.
+ * \brief Parse GSV packet from buffer by nmea_scanf (reference decoder).
  * @param buff a constant character pointer of packet buffer.
  * @param buff_sz buffer size.
  * @param pack a pointer of packet which will filled by function.
  * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
  */
-int nmea_parse_GPGSV(const char *buff, int buff_sz, nmeaGPGSV *pack)
+int nmea_scanf_GPGSV(const char *buff, int buff_sz, nmeaGPGSV *pack)
 {
     int nsen, nsat;
 
@@ -285,16 +741,19 @@ int nmea_parse_GPGSV(const char *buff, int buff_sz, nmeaGPGSV *pack)
 }
 
 /**
- * \brief Parse RMC packet from buffer.
+ * \brief Parse RMC packet from buffer by nmea_scanf (reference decoder).
  * @param buff a constant character pointer of packet buffer.
  * @param buff_sz buffer size.
  * @param pack a pointer of packet which will filled by function.
  * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
  */
-int nmea_parse_GPRMC(const char *buff, int buff_sz, nmeaGPRMC *pack)
+int nmea_scanf_GPRMC(const char *buff, int buff_sz, nmeaGPRMC *pack)
 {
     int nsen;
     char time_buff[NMEA_TIMEPARSE_BUF];
+    long long tod_us;
+
+    time_buff[0] = '\0';
 
     NMEA_ASSERT(buff && pack);
 
@@ -310,33 +769,34 @@ int nmea_parse_GPRMC(const char *buff, int buff_sz, nmeaGPRMC *pack)
         &(pack->utc.day), &(pack->utc.mon), &(pack->utc.year),
         &(pack->declination), &(pack->declin_ew), &(pack->mode));
 
+    pack->lat_udeg = nmea_fast_ndeg2udeg(pack->lat);
+    pack->lon_udeg = nmea_fast_ndeg2udeg(pack->lon);
+
     if(nsen != 13 && nsen != 14)
     {
         nmea_error("GPRMC parse error!");
         return 0;
     }
 
-    if(0 != _nmea_parse_time(&time_buff[0], (int)strlen(&time_buff[0]), &(pack->utc)))
+    if(0 > (tod_us = _nmea_parse_time(&time_buff[0], (int)strlen(&time_buff[0]), &(pack->utc))))
     {
         nmea_error("GPRMC time parse error!");
         return 0;
     }
 
-    if(pack->utc.year < 90)
-        pack->utc.year += 100;
-    pack->utc.mon -= 1;
+    _nmea_parse_date(pack, tod_us);
 
     return 1;
 }
 
 /**
- * \brief Parse VTG packet from buffer.
+ * \brief Parse VTG packet from buffer by nmea_scanf (reference decoder).
  * @param buff a constant character pointer of packet buffer.
  * @param buff_sz buffer size.
  * @param pack a pointer of packet which will filled by function.
  * @return 1 (true) - if parsed successfully or 0 (false) - if fail.
  */
-int nmea_parse_GPVTG(const char *buff, int buff_sz, nmeaGPVTG *pack)
+int nmea_scanf_GPVTG(const char *buff, int buff_sz, nmeaGPVTG *pack)
 {
     NMEA_ASSERT(buff && pack);
 
@@ -380,6 +840,7 @@ void nmea_GPGGA2info(nmeaGPGGA *pack, nmeaINFO *info)
     info->utc.min = pack->utc.min;
     info->utc.sec = pack->utc.sec;
     info->utc.hsec = pack->utc.hsec;
+    info->utc_us += pack->utc_us - info->utc_us % NMEA_TIME_DAY_US;
     info->sig = pack->sig;
     info->HDOP = pack->HDOP;
     info->elv = pack->elv;
@@ -390,11 +851,14 @@ void nmea_GPGGA2info(nmeaGPGGA *pack, nmeaINFO *info)
 
 /**
  * \brief Fill nmeaINFO structure by GSA packet data.
+ * PRNs are matched against satellites of the same talker, GN (combined)
+ * packet matches satellites of any talker.
  * @param pack a pointer of packet structure.
  * @param info a pointer of summary information structure.
  */
 void nmea_GPGSA2info(nmeaGPGSA *pack, nmeaINFO *info)
 {
+    nmeaSATELLITE *sat = info->satinfo.sat;
     int i, j, nuse = 0;
 
     NMEA_ASSERT(pack && info);
@@ -404,41 +868,83 @@ void nmea_GPGSA2info(nmeaGPGSA *pack, nmeaINFO *info)
     info->HDOP = pack->HDOP;
     info->VDOP = pack->VDOP;
 
-    for(i = 0; i < NMEA_MAXSAT; ++i)
+    if(NMEA_TALKER_GN != pack->talker)
     {
         for(j = 0; j < info->satinfo.inview; ++j)
         {
-            if(pack->sat_prn[i] && pack->sat_prn[i] == info->satinfo.sat[j].id)
-            {
-                info->satinfo.sat[j].in_use = 1;
-                nuse++;
-            }
+            if(sat[j].talker == pack->talker)
+                sat[j].in_use = 0;
         }
     }
 
+    for(i = 0; i < NMEA_PRNINPACK; ++i)
+    {
+        for(j = 0; pack->sat_prn[i] && j < info->satinfo.inview; ++j)
+        {
+            if(pack->sat_prn[i] == sat[j].id &&
+                (NMEA_TALKER_GN == pack->talker || sat[j].talker == pack->talker))
+                sat[j].in_use = 1;
+        }
+    }
+
+    for(j = 0; j < info->satinfo.inview; ++j)
+        nuse += sat[j].in_use;
+
     info->satinfo.inuse = nuse;
     info->smask |= GPGSA;
 }
 
 /**
  * \brief Fill nmeaINFO structure by GSV packet data.
+ * Satellites of every talker are kept as one contiguous run of satinfo,
+ * the run is rebuilt when number of satellites of talker changes.
  * @param pack a pointer of packet structure.
  * @param info a pointer of summary information structure.
  */
 void nmea_GPGSV2info(nmeaGPGSV *pack, nmeaINFO *info)
 {
-    int isat, isi, nsat;
+    nmeaSATELLITE *sat = info->satinfo.sat;
+    int isat, isi, nsat, first = -1, count = 0, inview = 0;
 
     NMEA_ASSERT(pack && info);
 
     if(pack->pack_index > pack->pack_count ||
-        pack->pack_index * NMEA_SATINPACK > NMEA_MAXSAT)
+        pack->pack_index * NMEA_SATINPACK > NMEA_MAXSAT ||
+        pack->sat_count < 0)
         return;
 
     if(pack->pack_index < 1)
         pack->pack_index = 1;
 
-    info->satinfo.inview = pack->sat_count;
+    for(isi = 0; isi < info->satinfo.inview; ++isi)
+    {
+        if(sat[isi].talker != pack->talker)
+            continue;
+        if(first < 0)
+            first = isi;
+        count++;
+    }
+
+    /* run truncated by the end of satinfo is kept */
+    if(first < 0 || (count != pack->sat_count &&
+        !(count < pack->sat_count && first + count == NMEA_MAXSAT)))
+    {
+        /* drop previous run of talker and append new one */
+        for(isi = 0; isi < info->satinfo.inview; ++isi)
+        {
+            if(sat[isi].talker != pack->talker)
+                sat[inview++] = sat[isi];
+        }
+
+        first = inview;
+        count = (pack->sat_count < NMEA_MAXSAT - first)?pack->sat_count:NMEA_MAXSAT - first;
+
+        memset(sat + first, 0, count * sizeof(nmeaSATELLITE));
+        for(isi = first; isi < first + count; ++isi)
+            sat[isi].talker = pack->talker;
+
+        info->satinfo.inview = first + count;
+    }
 
     nsat = (pack->pack_index - 1) * NMEA_SATINPACK;
     nsat = (nsat + NMEA_SATINPACK > pack->sat_count)?pack->sat_count - nsat:NMEA_SATINPACK;
@@ -446,10 +952,12 @@ void nmea_GPGSV2info(nmeaGPGSV *pack, nmeaINFO *info)
     for(isat = 0; isat < nsat; ++isat)
     {
         isi = (pack->pack_index - 1) * NMEA_SATINPACK + isat;
-        info->satinfo.sat[isi].id = pack->sat_data[isat].id;
-        info->satinfo.sat[isi].elv = pack->sat_data[isat].elv;
-        info->satinfo.sat[isi].azimuth = pack->sat_data[isat].azimuth;
-        info->satinfo.sat[isi].sig = pack->sat_data[isat].sig;
+        if(isi >= count)
+            break;
+        sat[first + isi].id = pack->sat_data[isat].id;
+        sat[first + isi].elv = pack->sat_data[isat].elv;
+        sat[first + isi].azimuth = pack->sat_data[isat].azimuth;
+        sat[first + isi].sig = pack->sat_data[isat].sig;
     }
 
     info->smask |= GPGSV;
@@ -478,6 +986,7 @@ void nmea_GPRMC2info(nmeaGPRMC *pack, nmeaINFO *info)
     }
 
     info->utc = pack->utc;
+    info->utc_us = pack->utc_us;
     info->lat = ((pack->ns == 'N')?pack->lat:-(pack->lat));
     info->lon = ((pack->ew == 'E')?pack->lon:-(pack->lon));
     info->speed = pack->speed * NMEA_TUD_KNOTS;
@@ -499,3 +1008,35 @@ void nmea_GPVTG2info(nmeaGPVTG *pack, nmeaINFO *info)
     info->speed = pack->spk;
     info->smask |= GPVTG;
 }
+
+/**
+ * \brief Fill nmeaINFO structure by packet of any type.
+ * @param ptype type of packet (nmeaPACKTYPE).
+ * @param pack a pointer of packet structure.
+ * @param info a pointer of summary information structure.
+ */
+void nmea_pack2info(int ptype, void *pack, nmeaINFO *info)
+{
+    NMEA_STATS_START(start, NMEA_STAGE_MERGE);
+
+    switch(ptype)
+    {
+    case GPGGA:
+        nmea_GPGGA2info((nmeaGPGGA *)pack, info);
+        break;
+    case GPGSA:
+        nmea_GPGSA2info((nmeaGPGSA *)pack, info);
+        break;
+    case GPGSV:
+        nmea_GPGSV2info((nmeaGPGSV *)pack, info);
+        break;
+    case GPRMC:
+        nmea_GPRMC2info((nmeaGPRMC *)pack, info);
+        break;
+    case GPVTG:
+        nmea_GPVTG2info((nmeaGPVTG *)pack, info);
+        break;
+    };
+
+    NMEA_STATS_STOP(NMEA_STAGE_MERGE, start);
+}
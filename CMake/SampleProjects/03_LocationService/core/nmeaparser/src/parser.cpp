@@ -16,45 +16,120 @@
 #include "parse.h"
 #include "parser.h"
 #include "context.h"
+#include "stats.h"
 
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 
-typedef struct _nmeaParserNODE
+/**
+ * Report of parser error, the branch costs nothing more when no sink is set
+ */
+#define NMEA_PARSER_ERROR(parser, code, ptype, field, sen, sen_sz, offset) \
+    do { if(NMEA_UNLIKELY(0 != (parser)->error_sink)) \
+        nmea_parser_report((parser), (code), (ptype), (field), (sen), (sen_sz), (offset)); } while(0)
+
+/**
+ * \brief Hand error over to sink of parser, at most error_rate errors a second
+ */
+static void nmea_parser_report(
+    nmeaPARSER *parser, int code, int ptype, int field,
+    const char *sen, int sen_sz, long long offset)
 {
-    int packType;
-    void *pack;
-    struct _nmeaParserNODE *next_node;
+    nmeaERROR error;
+    struct timespec ts;
 
-} nmeaParserNODE;
+    if(parser->error_rate > 0)
+    {
+#ifdef CLOCK_MONOTONIC_COARSE
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+        if((long long)ts.tv_sec != parser->error_second)
+        {
+            parser->error_second = (long long)ts.tv_sec;
+            parser->error_count = 0;
+        }
+
+        if(parser->error_count >= parser->error_rate)
+        {
+            parser->error_dropped++;
+            return;
+        }
+
+        parser->error_count++;
+    }
+
+    error.code = code;
+    error.ptype = ptype;
+    error.field = field;
+    error.offset = offset;
+    error.sentence = sen;
+    error.sentence_sz = sen_sz;
+    error.dropped = parser->error_dropped;
+    parser->error_dropped = 0;
+
+    (*parser->error_sink)(parser->error_user, &error);
+}
 
 /*
  * high level
  */
 
 /**
- * \brief Initialization of parser object
+ * \brief Initialization of parser object with configuration of nmea_property()
  * @return true (1) - success or false (0) - fail
  */
 int nmea_parser_init(nmeaPARSER *parser)
+{
+    nmeaPARSERCONFIG config;
+
+    nmea_parser_config(&config);
+
+    return nmea_parser_init_config(parser, &config);
+}
+
+/**
+ * \brief Initialization of parser object with its own buffer sizes, trace and error sink
+ * Parsers of different threads can have different configurations, the
+ * sink is called by the thread pushing into the parser.
+ * @return true (1) - success or false (0) - fail
+ */
+int nmea_parser_init_config(nmeaPARSER *parser, const nmeaPARSERCONFIG *config)
 {
     int resv = 0;
-    int buff_size = nmea_property()->parse_buff_size;
+    int buff_size = config->parse_buff_size;
+    int queue_size = config->parse_queue_size;
 
-    NMEA_ASSERT(parser);
+    NMEA_ASSERT(parser && config);
 
     if(buff_size < NMEA_MIN_PARSEBUFF)
         buff_size = NMEA_MIN_PARSEBUFF;
+    if(queue_size < NMEA_MIN_PARSEQUEUE)
+        queue_size = NMEA_MIN_PARSEQUEUE;
 
     memset(parser, 0, sizeof(nmeaPARSER));
 
     if(0 == (parser->buffer = (unsigned char*)malloc(buff_size)))
         nmea_error("Insufficient memory!");
+    else if(0 == (parser->queue = malloc(queue_size * sizeof(nmeaParserNODE))))
+    {
+        free(parser->buffer);
+        parser->buffer = 0;
+        nmea_error("Insufficient memory!");
+    }
     else
     {
         parser->buff_size = buff_size;
+        parser->queue_size = queue_size;
+        parser->trace_func = config->trace_func;
+        parser->error_sink = config->error_sink;
+        parser->error_user = config->error_user;
+        parser->error_rate = config->error_rate;
+        parser->error_second = -1;
         resv = 1;
-    }    
+    }
 
     return resv;
 }
@@ -66,52 +141,42 @@ void nmea_parser_destroy(nmeaPARSER *parser)
 {
     NMEA_ASSERT(parser && parser->buffer);
     free(parser->buffer);
-    nmea_parser_queue_clear(parser);
+    free(parser->queue);
     memset(parser, 0, sizeof(nmeaPARSER));
 }
 
 /**
  * \brief Analysis of buffer and put results to information structure
+ * Sentences are decoded directly from the caller's buffer, the queue is
+ * drained every time it gets full, so steady state parsing neither copies
+ * the stream nor touches the heap.
  * @return Number of packets wos parsed
  */
-int nmea_parse(    
+int nmea_parse(
     nmeaPARSER *parser,
     const char *buff, int buff_sz,
     nmeaINFO *info
     )
 {
-    int ptype, nread = 0;
+    int ptype, nparse, nread = 0;
     void *pack = 0;
 
     NMEA_ASSERT(parser && parser->buffer);
 
-    nmea_parser_push(parser, buff, buff_sz);
-
-    while(GPNON != (ptype = nmea_parser_pop(parser, &pack)))
+    do
     {
-        nread++;
+        nparse = nmea_parser_real_push(parser, buff, buff_sz);
+
+        buff += nparse;
+        buff_sz -= nparse;
 
-        switch(ptype)
+        while(GPNON != (ptype = nmea_parser_pop(parser, &pack)))
         {
-        case GPGGA:
-            nmea_GPGGA2info((nmeaGPGGA *)pack, info);
-            break;
-        case GPGSA:
-            nmea_GPGSA2info((nmeaGPGSA *)pack, info);
-            break;
-        case GPGSV:
-            nmea_GPGSV2info((nmeaGPGSV *)pack, info);
-            break;
-        case GPRMC:
-            nmea_GPRMC2info((nmeaGPRMC *)pack, info);
-            break;
-        case GPVTG:
-            nmea_GPVTG2info((nmeaGPVTG *)pack, info);
-            break;
-        };
+            nread++;
+            nmea_pack2info(ptype, pack, info);
+        }
 
-        free(pack);
-    }
+    } while(buff_sz > 0);
 
     return nread;
 }
@@ -120,169 +185,214 @@ int nmea_parse(
  * low level
  */
 
-int nmea_parser_real_push(nmeaPARSER *parser, const char *buff, int buff_sz)
+/**
+ * \brief Reserve slot at the end of packets queue
+ * When queue is full the oldest packet is dropped.
+ */
+static nmeaParserNODE * nmea_parser_queue_tail(nmeaPARSER *parser, long long offset)
 {
-    int nparsed = 0, crc, sen_sz, ptype;
-    nmeaParserNODE *node = 0;
+    nmeaParserNODE *queue = (nmeaParserNODE *)parser->queue;
 
-    NMEA_ASSERT(parser && parser->buffer);
+    if(parser->queue_use == parser->queue_size)
+    {
+        NMEA_PARSER_ERROR(parser, NMEA_ERR_QUEUE_OVERFLOW, queue[parser->queue_top].packType, -1, 0, 0, offset);
+        NMEA_STATS_COUNT(NMEA_COUNT_QUEUE_OVERFLOW);
+        nmea_parser_drop(parser);
+    }
+
+    return &queue[(parser->queue_top + parser->queue_use) % parser->queue_size];
+}
+
+/**
+ * \brief Decode sentence with valid control sum and keep packet into queue
+ * @param offset stream offset of the sentence, for error reports
+ */
+static void nmea_parser_decode(nmeaPARSER *parser, const char *sen, int sen_sz, long long offset)
+{
+    int ptype, code, field = -1;
+    nmeaParserNODE *node;
+    NMEA_STATS_START(start, NMEA_STAGE_DECODE);
+
+    if(GPNON == (ptype = nmea_pack_type(sen + 1, sen_sz - 1)))
+    {
+        NMEA_STATS_COUNT(NMEA_COUNT_UNKNOWN_TYPE);
+        NMEA_PARSER_ERROR(parser, NMEA_ERR_TYPE, GPNON, -1, sen, sen_sz, offset);
+        return;
+    }
+
+    if(NMEA_UNLIKELY(0 != parser->trace_func))
+        (*parser->trace_func)(sen, sen_sz);
+
+    node = nmea_parser_queue_tail(parser, offset);
+
+    code = nmea_parse_pack(ptype, sen, sen_sz, &node->pack, &field);
 
-    /* clear unuse buffer (for debug) */
-    /*
-    memset(
-        parser->buffer + parser->buff_use, 0,
-        parser->buff_size - parser->buff_use
-        );
-        */
+    NMEA_STATS_STOP(NMEA_STAGE_DECODE, start);
 
-    /* add */
-    if(parser->buff_use + buff_sz >= parser->buff_size)
+    if(NMEA_ERR_NONE == code)
+    {
+        node->packType = ptype;
+        parser->queue_use++;
+        NMEA_STATS_COUNT(NMEA_COUNT_SENTENCE);
+    }
+    else
+    {
+        NMEA_STATS_COUNT(NMEA_COUNT_DECODE_FAIL);
+        NMEA_PARSER_ERROR(parser, code, ptype, field, sen, sen_sz, offset);
+    }
+}
+
+/**
+ * \brief Frame of the next sentence (nmea_find_tail) timed as NMEA_STAGE_FRAME
+ */
+static NMEA_INLINE int nmea_parser_frame(const char *buff, int buff_sz, int *crc)
+{
+    int sen_sz;
+    NMEA_STATS_START(start, NMEA_STAGE_FRAME);
+
+    sen_sz = nmea_find_tail(buff, buff_sz, crc);
+
+    NMEA_STATS_STOP(NMEA_STAGE_FRAME, start);
+    if(sen_sz && *crc < 0)
+        NMEA_STATS_COUNT(NMEA_COUNT_CRC_FAIL);
+
+    return sen_sz;
+}
+
+/**
+ * \brief Complete sentence kept into parser buffer by previous push
+ * Bytes are taken up to the first line end or start of next sentence.
+ * @return Number of bytes taken from buffer
+ */
+static int nmea_parser_carry(nmeaPARSER *parser, const char *buff, int buff_sz)
+{
+    int nread, crc, sen_sz, nparsed = 0;
+
+    for(nread = 0; nread < buff_sz && '\n' != buff[nread] && '$' != buff[nread]; ++nread);
+
+    if(nread < buff_sz && '\n' == buff[nread])
+        nread++;
+
+    if(parser->buff_use + nread > parser->buff_size)
+    {
+        NMEA_PARSER_ERROR(parser, NMEA_ERR_BUFF_OVERFLOW, GPNON, -1,
+            (const char *)parser->buffer, parser->buff_use, parser->buff_pos);
+        NMEA_STATS_COUNT(NMEA_COUNT_BUFF_OVERFLOW);
         nmea_parser_buff_clear(parser);
+        return nread;
+    }
+
+    memcpy(parser->buffer + parser->buff_use, buff, nread);
+    parser->buff_use += nread;
 
-    memcpy(parser->buffer + parser->buff_use, buff, buff_sz);
-    parser->buff_use += buff_sz;
+    if(nread == buff_sz && '\n' != buff[nread - 1])
+        return nread; /* sentence is still incomplete */
 
-    /* parse */
-    for(;;node = 0)
+    while(nparsed < parser->buff_use && 0 != (sen_sz = nmea_parser_frame(
+        (const char *)parser->buffer + nparsed, parser->buff_use - nparsed, &crc)))
     {
-        sen_sz = nmea_find_tail(
-            (const char *)parser->buffer + nparsed,
-            (int)parser->buff_use - nparsed, &crc);
+        if(crc >= 0)
+            nmea_parser_decode(parser, (const char *)parser->buffer + nparsed, sen_sz, parser->buff_pos + nparsed);
+        else
+            NMEA_PARSER_ERROR(parser, NMEA_ERR_CRC, GPNON, -1,
+                (const char *)parser->buffer + nparsed, sen_sz, parser->buff_pos + nparsed);
+        nparsed += sen_sz;
+    }
 
-        if(!sen_sz)
-        {
-            if(nparsed)
-                memcpy(
-                parser->buffer,
-                parser->buffer + nparsed,
-                parser->buff_use -= nparsed);
-            break;
-        }
-        else if(crc >= 0)
-        {
-            ptype = nmea_pack_type(
-                (const char *)parser->buffer + nparsed + 1,
-                parser->buff_use - nparsed - 1);
+    nmea_parser_buff_clear(parser);
 
-            if(0 == (node = (nmeaParserNODE*)malloc(sizeof(nmeaParserNODE))))
-                goto mem_fail;
+    return nread;
+}
+
+/**
+ * \brief Decode sentences directly from buffer and keep results into parser
+ * Only the trailing incomplete sentence is copied into parser buffer.
+ * Stops when the packets queue gets full.
+ * @return Number of bytes taken from buffer
+ */
+int nmea_parser_real_push(nmeaPARSER *parser, const char *buff, int buff_sz)
+{
+    int nparsed = 0, crc, sen_sz;
+    const char *sync;
+    long long base = parser->stream_pos;
 
-            node->pack = 0;
+    NMEA_ASSERT(parser && parser->buffer);
 
-            switch(ptype)
+    if(buff_sz <= 0)
+        return 0;
+
+    if(parser->buff_use)
+        nparsed = nmea_parser_carry(parser, buff, buff_sz);
+
+    while(nparsed < buff_sz)
+    {
+        sen_sz = nmea_parser_frame(buff + nparsed, buff_sz - nparsed, &crc);
+
+        if(!sen_sz)
+        {
+            /* sentence which is not completed before the next one is skipped */
+            if(0 != (sync = (const char *)memchr(buff + nparsed + 1, '$', buff_sz - nparsed - 1)))
             {
-            case GPGGA:
-                if(0 == (node->pack = malloc(sizeof(nmeaGPGGA))))
-                    goto mem_fail;
-                node->packType = GPGGA;
-                if(!nmea_parse_GPGGA(
-                    (const char *)parser->buffer + nparsed,
-                    sen_sz, (nmeaGPGGA *)node->pack))
-                {
-                    free(node);
-                    node = 0;
-                }
-                break;
-            case GPGSA:
-                if(0 == (node->pack = malloc(sizeof(nmeaGPGSA))))
-                    goto mem_fail;
-                node->packType = GPGSA;
-                if(!nmea_parse_GPGSA(
-                    (const char *)parser->buffer + nparsed,
-                    sen_sz, (nmeaGPGSA *)node->pack))
-                {
-                    free(node);
-                    node = 0;
-                }
-                break;
-            case GPGSV:
-                if(0 == (node->pack = malloc(sizeof(nmeaGPGSV))))
-                    goto mem_fail;
-                node->packType = GPGSV;
-                if(!nmea_parse_GPGSV(
-                    (const char *)parser->buffer + nparsed,
-                    sen_sz, (nmeaGPGSV *)node->pack))
-                {
-                    free(node);
-                    node = 0;
-                }
-                break;
-            case GPRMC:
-                if(0 == (node->pack = malloc(sizeof(nmeaGPRMC))))
-                    goto mem_fail;
-                node->packType = GPRMC;
-                if(!nmea_parse_GPRMC(
-                    (const char *)parser->buffer + nparsed,
-                    sen_sz, (nmeaGPRMC *)node->pack))
-                {
-                    free(node);
-                    node = 0;
-                }
-                break;
-            case GPVTG:
-                if(0 == (node->pack = malloc(sizeof(nmeaGPVTG))))
-                    goto mem_fail;
-                node->packType = GPVTG;
-                if(!nmea_parse_GPVTG(
-                    (const char *)parser->buffer + nparsed,
-                    sen_sz, (nmeaGPVTG *)node->pack))
-                {
-                    free(node);
-                    node = 0;
-                }
-                break;
-            default:
-                free(node);
-                node = 0;
-                break;
-            };
+                nparsed = (int)(sync - buff);
+                continue;
+            }
 
-            if(node)
+            if(buff_sz - nparsed > parser->buff_size)
             {
-                if(parser->end_node)
-                    ((nmeaParserNODE *)parser->end_node)->next_node = node;
-                parser->end_node = node;
-                if(!parser->top_node)
-                    parser->top_node = node;
-                node->next_node = 0;
+                NMEA_PARSER_ERROR(parser, NMEA_ERR_BUFF_OVERFLOW, GPNON, -1,
+                    buff + nparsed, buff_sz - nparsed, base + nparsed);
+                NMEA_STATS_COUNT(NMEA_COUNT_BUFF_OVERFLOW);
             }
+            else
+            {
+                memcpy(parser->buffer, buff + nparsed, buff_sz - nparsed);
+                parser->buff_use = buff_sz - nparsed;
+                parser->buff_pos = base + nparsed;
+            }
+            nparsed = buff_sz;
+            break;
         }
+        else if(crc >= 0)
+        {
+            if(parser->queue_use == parser->queue_size)
+                break;
+            nmea_parser_decode(parser, buff + nparsed, sen_sz, base + nparsed);
+        }
+        else
+            NMEA_PARSER_ERROR(parser, NMEA_ERR_CRC, GPNON, -1, buff + nparsed, sen_sz, base + nparsed);
 
         nparsed += sen_sz;
     }
 
-    return nparsed;
-
-mem_fail:
-    if(node)
-        free(node);
+    parser->stream_pos = base + nparsed;
 
-    nmea_error("Insufficient memory!");
-
-    return -1;
+    return nparsed;
 }
 
 /**
  * \brief Analysis of buffer and keep results into parser
+ * If the packets queue gets full the oldest packets are dropped.
  * @return Number of bytes wos parsed from buffer
  */
 int nmea_parser_push(nmeaPARSER *parser, const char *buff, int buff_sz)
 {
     int nparse, nparsed = 0;
 
-    do
+    while(buff_sz > 0)
     {
-        if(buff_sz > parser->buff_size)
-            nparse = parser->buff_size;
-        else
-            nparse = buff_sz;
-
-        nparsed += nmea_parser_real_push(
-            parser, buff, nparse);
+        nparse = nmea_parser_real_push(parser, buff, buff_sz);
 
+        nparsed += nparse;
+        buff += nparse;
         buff_sz -= nparse;
 
-    } while(buff_sz);
+        if(buff_sz > 0)
+        {
+            NMEA_PARSER_ERROR(parser, NMEA_ERR_QUEUE_OVERFLOW, nmea_parser_top(parser), -1, 0, 0, parser->stream_pos);
+            NMEA_STATS_COUNT(NMEA_COUNT_QUEUE_OVERFLOW);
+            nmea_parser_drop(parser);
+        }
+    }
 
     return nparsed;
 }
@@ -295,36 +405,34 @@ int nmea_parser_push(nmeaPARSER *parser, const char *buff, int buff_sz)
 int nmea_parser_top(nmeaPARSER *parser)
 {
     int retval = GPNON;
-    nmeaParserNODE *node = (nmeaParserNODE *)parser->top_node;
+    nmeaParserNODE *queue = (nmeaParserNODE *)parser->queue;
 
     NMEA_ASSERT(parser && parser->buffer);
 
-    if(node)
-        retval = node->packType;
+    if(parser->queue_use)
+        retval = queue[parser->queue_top].packType;
 
     return retval;
 }
 
 /**
  * \brief Withdraw top packet from parser
+ * The packet is owned by parser and stays valid until next push into parser.
  * @return Received packet type
  * @see nmeaPACKTYPE
  */
 int nmea_parser_pop(nmeaPARSER *parser, void **pack_ptr)
 {
     int retval = GPNON;
-    nmeaParserNODE *node = (nmeaParserNODE *)parser->top_node;
+    nmeaParserNODE *queue = (nmeaParserNODE *)parser->queue;
 
     NMEA_ASSERT(parser && parser->buffer);
 
-    if(node)
+    if(parser->queue_use)
     {
-        *pack_ptr = node->pack;
-        retval = node->packType;
-        parser->top_node = node->next_node;
-        if(!parser->top_node)
-            parser->end_node = 0;
-        free(node);
+        *pack_ptr = &queue[parser->queue_top].pack;
+        retval = queue[parser->queue_top].packType;
+        nmea_parser_drop(parser);
     }
 
     return retval;
@@ -338,14 +446,14 @@ int nmea_parser_pop(nmeaPARSER *parser, void **pack_ptr)
 int nmea_parser_peek(nmeaPARSER *parser, void **pack_ptr)
 {
     int retval = GPNON;
-    nmeaParserNODE *node = (nmeaParserNODE *)parser->top_node;
+    nmeaParserNODE *queue = (nmeaParserNODE *)parser->queue;
 
     NMEA_ASSERT(parser && parser->buffer);
 
-    if(node)
+    if(parser->queue_use)
     {
-        *pack_ptr = node->pack;
-        retval = node->packType;
+        *pack_ptr = &queue[parser->queue_top].pack;
+        retval = queue[parser->queue_top].packType;
     }
 
     return retval;
@@ -359,19 +467,15 @@ int nmea_parser_peek(nmeaPARSER *parser, void **pack_ptr)
 int nmea_parser_drop(nmeaPARSER *parser)
 {
     int retval = GPNON;
-    nmeaParserNODE *node = (nmeaParserNODE *)parser->top_node;
+    nmeaParserNODE *queue = (nmeaParserNODE *)parser->queue;
 
     NMEA_ASSERT(parser && parser->buffer);
 
-    if(node)
+    if(parser->queue_use)
     {
-        if(node->pack)
-            free(node->pack);
-        retval = node->packType;
-        parser->top_node = node->next_node;
-        if(!parser->top_node)
-            parser->end_node = 0;
-        free(node);
+        retval = queue[parser->queue_top].packType;
+        parser->queue_top = (parser->queue_top + 1) % parser->queue_size;
+        parser->queue_use--;
     }
 
     return retval;
@@ -395,7 +499,7 @@ int nmea_parser_buff_clear(nmeaPARSER *parser)
 int nmea_parser_queue_clear(nmeaPARSER *parser)
 {
     NMEA_ASSERT(parser);
-    while(parser->top_node)
-        nmea_parser_drop(parser);
+    parser->queue_top = 0;
+    parser->queue_use = 0;
     return 1;
 }
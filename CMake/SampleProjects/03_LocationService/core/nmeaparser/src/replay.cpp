@@ -0,0 +1,683 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/**
+ * \file replay.h
+ * \brief Bulk replay of recorded NMEA logs.
+ * Log file is mapped into memory and sentences are decoded in place,
+ * without splitting the log into small chunks.
+ */
+
+#include "replay.h"
+#include "parse.h"
+#include "context.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef NMEA_UNI
+#   include <errno.h>
+#   include <pthread.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#endif
+
+#define NMEA_REPLAY_CHUNK   (1 << 30)   /**< Max bytes passed to parser at once */
+#define NMEA_REPLAY_READBUF (1 << 16)   /**< Read buffer size where mapping is not available */
+#define NMEA_REPLAY_NODES   (1024)      /**< Initial number of packets kept by chunk of parallel replay */
+
+static double nmea_replay_clock()
+{
+#ifdef NMEA_UNI
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    return ((double)clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+static void nmea_replay_stat(nmeaREPLAYSTAT *stat, long long bytes, long long sentences, double start)
+{
+    if(!stat)
+        return;
+
+    memset(stat, 0, sizeof(nmeaREPLAYSTAT));
+    stat->bytes = bytes;
+    stat->sentences = sentences;
+    stat->seconds = nmea_replay_clock() - start;
+
+    if(stat->seconds > 0)
+    {
+        stat->bytes_per_sec = bytes / stat->seconds;
+        stat->sentences_per_sec = sentences / stat->seconds;
+    }
+}
+
+/**
+ * \brief Decode buffer and pass every packet to callback
+ * @param nread (IO) counter of decoded packets.
+ * @return 1 (true) - continue replay or 0 (false) - stopped by callback
+ */
+static int nmea_replay_buff(
+    nmeaPARSER *parser,
+    const char *buff, long long buff_sz,
+    nmeaINFO *info,
+    nmeaReplayFunc func, void *user_data,
+    long long *nread
+    )
+{
+    long long nparsed = 0;
+    int nparse, ptype;
+    void *pack = 0;
+
+    while(nparsed < buff_sz)
+    {
+        nparse = (buff_sz - nparsed > NMEA_REPLAY_CHUNK)?NMEA_REPLAY_CHUNK:(int)(buff_sz - nparsed);
+        nparsed += nmea_parser_real_push(parser, buff + nparsed, nparse);
+
+        while(GPNON != (ptype = nmea_parser_pop(parser, &pack)))
+        {
+            (*nread)++;
+            nmea_pack2info(ptype, pack, info);
+            if(func && !(*func)(ptype, pack, info, user_data))
+            {
+                nmea_parser_queue_clear(parser);
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * \brief Decode whole memory buffer (e.g. mapped log) in place
+ * @param parser initialized parser, keeps incomplete tail of buffer.
+ * @param buff buffer with sentences.
+ * @param buff_sz buffer size, may exceed 2 GB.
+ * @param info summary information updated by every packet.
+ * @param func callback for every packet (may be null).
+ * @param user_data pointer passed to callback.
+ * @param stat (O) statistic of replay (may be null).
+ * @return Number of decoded packets.
+ */
+int nmea_parse_mapped(
+    nmeaPARSER *parser,
+    const char *buff, long long buff_sz,
+    nmeaINFO *info,
+    nmeaReplayFunc func, void *user_data,
+    nmeaREPLAYSTAT *stat
+    )
+{
+    double start = nmea_replay_clock();
+    long long nread = 0;
+
+    NMEA_ASSERT(parser && parser->buffer && buff && info);
+
+    nmea_replay_buff(parser, buff, buff_sz, info, func, user_data, &nread);
+    nmea_replay_stat(stat, buff_sz, nread, start);
+
+    return (int)nread;
+}
+
+#ifdef NMEA_UNI
+
+/**
+ * \brief Decode descriptor read by big blocks (pipes, FIFOs, special files, files that can not be mapped)
+ * @return true (1) at end of input or when callback stopped replay, false (0) on error
+ */
+static int nmea_replay_fd(
+    int fd, const char *path,
+    nmeaPARSER *parser,
+    nmeaINFO *info,
+    nmeaReplayFunc func, void *user_data,
+    long long *nbytes, long long *nread
+    )
+{
+    char *buff;
+    ssize_t size;
+    int go = 1, res = 1;
+
+    if(0 == (buff = (char *)malloc(NMEA_REPLAY_READBUF)))
+    {
+        nmea_error("Insufficient memory!");
+        return 0;
+    }
+
+    while(go)
+    {
+        size = read(fd, buff, NMEA_REPLAY_READBUF);
+        if(size < 0 && EINTR == errno)
+            continue;
+        if(size < 0)
+        {
+            nmea_error("Can not read log file %s!", path);
+            res = 0;
+        }
+        if(size <= 0)
+            break;
+        *nbytes += size;
+        go = nmea_replay_buff(parser, buff, (long long)size, info, func, user_data, nread);
+    }
+
+    free(buff);
+
+    return res;
+}
+
+#endif /* NMEA_UNI */
+
+/**
+ * \brief Replay recorded log file
+ * On POSIX systems a regular file is mapped into memory with sequential
+ * access advice, other files (pipes, FIFOs, procfs) and files that can not
+ * be mapped are read by big blocks, as everywhere else.
+ * @param path path to log file.
+ * @param info summary information updated by every packet (may be null).
+ * @param func callback for every packet (may be null).
+ * @param user_data pointer passed to callback.
+ * @param stat (O) statistic of replay (may be null).
+ * @return Number of decoded packets or -1 if file can not be read.
+ */
+int nmea_parse_file(
+    const char *path,
+    nmeaINFO *info,
+    nmeaReplayFunc func, void *user_data,
+    nmeaREPLAYSTAT *stat
+    )
+{
+    nmeaPARSER parser;
+    nmeaINFO local_info;
+    double start = nmea_replay_clock();
+    long long nread = 0, nbytes = 0;
+
+    NMEA_ASSERT(path);
+
+    if(!info)
+    {
+        nmea_zero_INFO(&local_info);
+        info = &local_info;
+    }
+
+    if(!nmea_parser_init(&parser))
+        return -1;
+
+#ifdef NMEA_UNI
+    {
+        int fd, res = 1;
+        struct stat st;
+        void *map = MAP_FAILED;
+
+        if(0 > (fd = open(path, O_RDONLY)))
+        {
+            nmea_error("Can not open log file %s!", path);
+            nmea_parser_destroy(&parser);
+            return -1;
+        }
+
+        if(0 != fstat(fd, &st))
+        {
+            nmea_error("Can not stat log file %s!", path);
+            close(fd);
+            nmea_parser_destroy(&parser);
+            return -1;
+        }
+
+        if(S_ISREG(st.st_mode) && st.st_size > 0)
+            map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if(MAP_FAILED == map)
+            res = nmea_replay_fd(fd, path, &parser, info, func, user_data, &nbytes, &nread);
+        else
+        {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            nbytes = st.st_size;
+            nmea_replay_buff(&parser, (const char *)map, nbytes, info, func, user_data, &nread);
+            munmap(map, st.st_size);
+        }
+
+        close(fd);
+
+        if(!res)
+        {
+            nmea_parser_destroy(&parser);
+            return -1;
+        }
+    }
+#else
+    {
+        FILE *file;
+        char *buff;
+        size_t size;
+        int go = 1;
+
+        if(0 == (file = fopen(path, "rb")))
+        {
+            nmea_error("Can not open log file %s!", path);
+            nmea_parser_destroy(&parser);
+            return -1;
+        }
+
+        if(0 == (buff = (char *)malloc(NMEA_REPLAY_READBUF)))
+        {
+            nmea_error("Insufficient memory!");
+            fclose(file);
+            nmea_parser_destroy(&parser);
+            return -1;
+        }
+
+        while(go && 0 < (size = fread(buff, 1, NMEA_REPLAY_READBUF, file)))
+        {
+            nbytes += size;
+            go = nmea_replay_buff(&parser, buff, (long long)size, info, func, user_data, &nread);
+        }
+
+        free(buff);
+        fclose(file);
+    }
+#endif
+
+    nmea_replay_stat(stat, nbytes, nread, start);
+    nmea_parser_destroy(&parser);
+
+    return (int)nread;
+}
+
+typedef struct _nmeaFIXESDATA
+{
+    nmeaINFO   *fixes;
+    int         fixes_sz;
+    int         fixes_use;
+    long long   fixes_tod;  /**< Time of day of last stored fix in microseconds */
+
+} nmeaFIXESDATA;
+
+static int nmea_replay_fix(int ptype, const void *pack, const nmeaINFO *info, void *user_data)
+{
+    nmeaFIXESDATA *data = (nmeaFIXESDATA *)user_data;
+    long long tod;
+
+    if(GPGGA == ptype)
+        tod = ((const nmeaGPGGA *)pack)->utc_us % NMEA_TIME_DAY_US;
+    else if(GPRMC == ptype)
+        tod = ((const nmeaGPRMC *)pack)->utc_us % NMEA_TIME_DAY_US;
+    else
+        return 1;
+
+    /* GGA and RMC of the same epoch update one fix */
+    if(0 == data->fixes_use || tod != data->fixes_tod)
+    {
+        if(data->fixes_use == data->fixes_sz)
+            return 0;
+        data->fixes_use++;
+    }
+
+    data->fixes[data->fixes_use - 1] = *info;
+    data->fixes_tod = tod;
+
+    return 1;
+}
+
+/**
+ * \brief Replay recorded log file into array of fixes
+ * One fix is stored per epoch: summary information after the last GGA or
+ * RMC of the same UTC time of day, so packets of other types which follow
+ * them in the epoch are not included. Replay stops when the next epoch
+ * does not fit into the array.
+ * @return Number of stored fixes or -1 if file can not be read.
+ */
+int nmea_parse_file_fixes(
+    const char *path,
+    nmeaINFO *fixes, int fixes_sz,
+    nmeaREPLAYSTAT *stat
+    )
+{
+    nmeaFIXESDATA data;
+
+    NMEA_ASSERT(fixes);
+
+    if(fixes_sz <= 0)
+        return 0;
+
+    data.fixes = fixes;
+    data.fixes_sz = fixes_sz;
+    data.fixes_use = 0;
+    data.fixes_tod = -1;
+
+    if(0 > nmea_parse_file(path, 0, &nmea_replay_fix, &data, stat))
+        return -1;
+
+    return data.fixes_use;
+}
+
+/*
+ * parallel replay
+ */
+
+/**
+ * Packets decoded from one chunk of log, waiting to be merged
+ */
+typedef struct _nmeaParallelCHUNK
+{
+    nmeaParserNODE *nodes;
+    int             nodes_size;
+    int             nodes_use;
+    int             done;
+
+} nmeaParallelCHUNK;
+
+typedef struct _nmeaParallelJOB
+{
+    const char     *buff;
+    long long       buff_sz;
+    long long       chunk_sz;
+    int             nchunks;
+    int             next;       /**< Next chunk to decode */
+    int             merged;     /**< Number of merged chunks */
+    int             stop;
+    int             failed;
+
+    nmeaParallelCHUNK *slots;   /**< Ring of chunks, chunk i is kept by slot i % nslots */
+    int             nslots;
+
+#ifdef NMEA_UNI
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+#endif
+
+} nmeaParallelJOB;
+
+/**
+ * \brief Find start of chunk
+ * Chunk starts at the first sentence at or after its nominal offset,
+ * so every sentence is decoded by exactly one chunk.
+ */
+static long long nmea_parallel_sync(const nmeaParallelJOB *job, int index)
+{
+    long long offset = index * job->chunk_sz;
+    const char *sync;
+
+    if(0 == index)
+        return 0;
+    if(offset >= job->buff_sz)
+        return job->buff_sz;
+
+    sync = (const char *)memchr(job->buff + offset, '$', (size_t)(job->buff_sz - offset));
+
+    return sync?(sync - job->buff):job->buff_sz;
+}
+
+/**
+ * \brief Decode chunk of log into its slot
+ * @return true (1) - success or false (0) - fail
+ */
+static int nmea_parallel_decode(nmeaParallelJOB *job, int index, nmeaParallelCHUNK *chunk, nmeaPARSER *parser)
+{
+    long long start = nmea_parallel_sync(job, index);
+    long long buff_sz = nmea_parallel_sync(job, index + 1) - start;
+    const char *buff = job->buff + start;
+    nmeaParserNODE *nodes;
+    int nparse, ptype;
+    void *pack = 0;
+
+    chunk->nodes_use = 0;
+
+    /* sentence left incomplete by previous chunk is dropped the same way as by sequential parsing */
+    nmea_parser_buff_clear(parser);
+
+    while(buff_sz > 0)
+    {
+        nparse = nmea_parser_real_push(parser, buff, (buff_sz > NMEA_REPLAY_CHUNK)?NMEA_REPLAY_CHUNK:(int)buff_sz);
+        buff += nparse;
+        buff_sz -= nparse;
+
+        while(GPNON != (ptype = nmea_parser_pop(parser, &pack)))
+        {
+            if(chunk->nodes_use == chunk->nodes_size)
+            {
+                nparse = chunk->nodes_size?(chunk->nodes_size * 2):NMEA_REPLAY_NODES;
+                if(0 == (nodes = (nmeaParserNODE *)realloc(chunk->nodes, nparse * sizeof(nmeaParserNODE))))
+                {
+                    nmea_error("Insufficient memory!");
+                    return 0;
+                }
+                chunk->nodes = nodes;
+                chunk->nodes_size = nparse;
+            }
+
+            chunk->nodes[chunk->nodes_use].packType = ptype;
+            memcpy(&chunk->nodes[chunk->nodes_use].pack, pack, sizeof(nmeaParserPACK));
+            chunk->nodes_use++;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * \brief Merge packets of chunk into summary information in log order
+ * @return 1 (true) - continue replay or 0 (false) - stopped by callback
+ */
+static int nmea_parallel_merge(
+    nmeaParallelCHUNK *chunk,
+    nmeaINFO *info,
+    nmeaReplayFunc func, void *user_data,
+    long long *nread
+    )
+{
+    nmeaParserNODE *node = chunk->nodes;
+    nmeaParserNODE *end = chunk->nodes + chunk->nodes_use;
+
+    for(; node < end; ++node)
+    {
+        (*nread)++;
+        nmea_pack2info(node->packType, &node->pack, info);
+        if(func && !(*func)(node->packType, &node->pack, info, user_data))
+            return 0;
+    }
+
+    return 1;
+}
+
+#ifdef NMEA_UNI
+
+static void * nmea_parallel_worker(void *arg)
+{
+    nmeaParallelJOB *job = (nmeaParallelJOB *)arg;
+    nmeaParallelCHUNK *chunk;
+    nmeaPARSER parser;
+    int index, success;
+
+    success = nmea_parser_init(&parser);
+
+    pthread_mutex_lock(&job->lock);
+
+    if(!success)
+        job->failed = 1;
+
+    for(;;)
+    {
+        while(!job->stop && !job->failed && job->next < job->nchunks && job->next - job->merged >= job->nslots)
+            pthread_cond_wait(&job->cond, &job->lock);
+
+        if(job->stop || job->failed || job->next >= job->nchunks)
+            break;
+
+        index = job->next++;
+        chunk = &job->slots[index % job->nslots];
+
+        pthread_mutex_unlock(&job->lock);
+        success = nmea_parallel_decode(job, index, chunk, &parser);
+        pthread_mutex_lock(&job->lock);
+
+        if(success)
+            chunk->done = 1;
+        else
+            job->failed = 1;
+
+        pthread_cond_broadcast(&job->cond);
+    }
+
+    pthread_cond_broadcast(&job->cond);
+    pthread_mutex_unlock(&job->lock);
+
+    if(parser.buffer)
+        nmea_parser_destroy(&parser);
+
+    return 0;
+}
+
+#endif /* NMEA_UNI */
+
+/**
+ * \brief Decode whole memory buffer (e.g. mapped log) by several threads
+ * Buffer is cut into chunks at sentence starts, chunks are decoded by
+ * worker threads and packets are merged into summary information (and
+ * passed to callback) by calling thread in log order. The result is the
+ * same as by single nmea_parse of the whole buffer.
+ * @param buff buffer with sentences.
+ * @param buff_sz buffer size, may exceed 2 GB.
+ * @param info summary information updated by every packet.
+ * @param nthreads number of worker threads (0 - number of online CPUs).
+ * @param func callback for every packet (may be null).
+ * @param user_data pointer passed to callback.
+ * @param stat (O) statistic of replay (may be null).
+ * @return Number of decoded packets or -1 if workers can not be started.
+ */
+int nmea_parse_parallel(
+    const char *buff, long long buff_sz,
+    nmeaINFO *info,
+    int nthreads,
+    nmeaReplayFunc func, void *user_data,
+    nmeaREPLAYSTAT *stat
+    )
+{
+    nmeaParallelJOB job;
+    nmeaParallelCHUNK *chunk;
+    double start = nmea_replay_clock();
+    long long nread = 0;
+    int index, go = 1;
+
+    NMEA_ASSERT(buff && info);
+
+#ifdef NMEA_UNI
+    pthread_t threads[NMEA_PARALLEL_MAXTHREAD];
+    int nstarted = 0;
+
+    if(nthreads <= 0)
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    nmeaPARSER parser;
+
+    nthreads = 1;
+#endif
+
+    if(nthreads < 1)
+        nthreads = 1;
+    if(nthreads > NMEA_PARALLEL_MAXTHREAD)
+        nthreads = NMEA_PARALLEL_MAXTHREAD;
+
+    memset(&job, 0, sizeof(nmeaParallelJOB));
+    job.buff = buff;
+    job.buff_sz = buff_sz;
+    job.chunk_sz = buff_sz / (nthreads * 4);
+
+    if(job.chunk_sz < NMEA_PARALLEL_MINCHUNK)
+        job.chunk_sz = NMEA_PARALLEL_MINCHUNK;
+    if(job.chunk_sz > NMEA_PARALLEL_MAXCHUNK)
+        job.chunk_sz = NMEA_PARALLEL_MAXCHUNK;
+
+    job.nchunks = (int)((buff_sz + job.chunk_sz - 1) / job.chunk_sz);
+    job.nslots = nthreads * 2;
+
+    if(0 == (job.slots = (nmeaParallelCHUNK *)calloc(job.nslots, sizeof(nmeaParallelCHUNK))))
+    {
+        nmea_error("Insufficient memory!");
+        return -1;
+    }
+
+#ifdef NMEA_UNI
+    pthread_mutex_init(&job.lock, 0);
+    pthread_cond_init(&job.cond, 0);
+
+    for(; nstarted < nthreads; ++nstarted)
+    {
+        if(0 != pthread_create(&threads[nstarted], 0, &nmea_parallel_worker, &job))
+            break;
+    }
+
+    if(!nstarted)
+    {
+        nmea_error("Can not start parser threads!");
+        job.failed = 1;
+    }
+
+    for(index = 0; go && index < job.nchunks; ++index)
+    {
+        chunk = &job.slots[index % job.nslots];
+
+        pthread_mutex_lock(&job.lock);
+        while(!job.failed && !chunk->done)
+            pthread_cond_wait(&job.cond, &job.lock);
+        pthread_mutex_unlock(&job.lock);
+
+        if(!chunk->done)
+            break;
+
+        go = nmea_parallel_merge(chunk, info, func, user_data, &nread);
+
+        pthread_mutex_lock(&job.lock);
+        chunk->done = 0;
+        job.merged = index + 1;
+        job.stop = !go;
+        pthread_cond_broadcast(&job.cond);
+        pthread_mutex_unlock(&job.lock);
+    }
+
+    pthread_mutex_lock(&job.lock);
+    job.stop = 1;
+    pthread_cond_broadcast(&job.cond);
+    pthread_mutex_unlock(&job.lock);
+
+    while(nstarted > 0)
+        pthread_join(threads[--nstarted], 0);
+
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.lock);
+#else
+    if(!nmea_parser_init(&parser))
+        job.failed = 1;
+
+    for(index = 0; go && !job.failed && index < job.nchunks; ++index)
+    {
+        if(nmea_parallel_decode(&job, index, &job.slots[0], &parser))
+            go = nmea_parallel_merge(&job.slots[0], info, func, user_data, &nread);
+        else
+            job.failed = 1;
+    }
+
+    if(parser.buffer)
+        nmea_parser_destroy(&parser);
+#endif
+
+    for(index = 0; index < job.nslots; ++index)
+        free(job.slots[index].nodes);
+    free(job.slots);
+
+    if(job.failed)
+        return -1;
+
+    nmea_replay_stat(stat, buff_sz, nread, start);
+
+    return (int)nread;
+}
@@ -16,6 +16,7 @@ void nmea_zero_GPGGA(nmeaGPGGA *pack)
 {
     memset(pack, 0, sizeof(nmeaGPGGA));
     nmea_time_now(&pack->utc);
+    pack->utc_us = nmea_time_to_us(&pack->utc) % NMEA_TIME_DAY_US;
     pack->ns = 'N';
     pack->ew = 'E';
     pack->elv_units = 'M';
@@ -38,6 +39,7 @@ void nmea_zero_GPRMC(nmeaGPRMC *pack)
 {
     memset(pack, 0, sizeof(nmeaGPRMC));
     nmea_time_now(&pack->utc);
+    pack->utc_us = nmea_time_to_us(&pack->utc);
     pack->status = 'V';
     pack->ns = 'N';
     pack->ew = 'E';
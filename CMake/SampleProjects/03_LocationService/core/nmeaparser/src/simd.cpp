@@ -0,0 +1,292 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file tok.h */
+
+#include "tok.h"
+
+#ifdef NMEA_SIMD_X86
+#   include <immintrin.h>
+#endif
+
+/*
+ * Kernels return XOR of scanned bytes as unsigned char, callers convert
+ * it by (int)(char) which is the same as XOR of (int)(char) of every byte.
+ */
+
+/*
+ * portable
+ */
+
+static int nmea_scan_delim_scalar(const char *buff, int buff_sz, unsigned char *res_xor)
+{
+    unsigned char x = 0;
+    int it;
+
+    for(it = 0; it < buff_sz && '$' != buff[it] && '*' != buff[it]; ++it)
+        x ^= (unsigned char)buff[it];
+
+    *res_xor = x;
+
+    return it;
+}
+
+static unsigned char nmea_xor_scalar(const char *buff, int buff_sz)
+{
+    unsigned char x = 0;
+    int it;
+
+    for(it = 0; it < buff_sz; ++it)
+        x ^= (unsigned char)buff[it];
+
+    return x;
+}
+
+#ifdef NMEA_SIMD_X86
+
+/*
+ * SSE2
+ */
+
+__attribute__((target("sse2")))
+static unsigned char nmea_reduce_sse2(__m128i acc)
+{
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 2));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 1));
+    return (unsigned char)_mm_cvtsi128_si32(acc);
+}
+
+__attribute__((target("sse2")))
+static int nmea_scan_delim_sse2(const char *buff, int buff_sz, unsigned char *res_xor)
+{
+    const __m128i dollar = _mm_set1_epi8('$');
+    const __m128i star = _mm_set1_epi8('*');
+    const __m128i iota = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i acc = _mm_setzero_si128();
+    unsigned char x;
+    int it = 0, tail, mask;
+
+    for(; it + 16 <= buff_sz; it += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buff + it));
+        mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, dollar), _mm_cmpeq_epi8(v, star)));
+        if(mask)
+        {
+            /* XOR only bytes in front of delimiter */
+            tail = __builtin_ctz(mask);
+            acc = _mm_xor_si128(acc, _mm_and_si128(v, _mm_cmpgt_epi8(_mm_set1_epi8((char)tail), iota)));
+            *res_xor = nmea_reduce_sse2(acc);
+            return it + tail;
+        }
+        acc = _mm_xor_si128(acc, v);
+    }
+
+    tail = nmea_scan_delim_scalar(buff + it, buff_sz - it, &x);
+    *res_xor = x ^ nmea_reduce_sse2(acc);
+
+    return it + tail;
+}
+
+__attribute__((target("sse2")))
+static unsigned char nmea_xor_sse2(const char *buff, int buff_sz)
+{
+    __m128i acc = _mm_setzero_si128();
+    int it = 0;
+
+    for(; it + 16 <= buff_sz; it += 16)
+        acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *)(buff + it)));
+
+    return nmea_reduce_sse2(acc) ^ nmea_xor_scalar(buff + it, buff_sz - it);
+}
+
+/*
+ * AVX2
+ */
+
+/* AVX2 kernels do not call SSE2 ones to avoid AVX-SSE transition penalties */
+
+__attribute__((target("avx2")))
+static unsigned char nmea_reduce_avx2(__m256i acc)
+{
+    __m128i res = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    res = _mm_xor_si128(res, _mm_srli_si128(res, 8));
+    res = _mm_xor_si128(res, _mm_srli_si128(res, 4));
+    res = _mm_xor_si128(res, _mm_srli_si128(res, 2));
+    res = _mm_xor_si128(res, _mm_srli_si128(res, 1));
+    return (unsigned char)_mm_cvtsi128_si32(res);
+}
+
+__attribute__((target("avx2")))
+static int nmea_scan_delim_avx2(const char *buff, int buff_sz, unsigned char *res_xor)
+{
+    const __m256i dollar = _mm256_set1_epi8('$');
+    const __m256i star = _mm256_set1_epi8('*');
+    const __m256i iota = _mm256_setr_epi8(
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+        16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+    __m256i acc = _mm256_setzero_si256();
+    unsigned char x;
+    int it = 0, tail;
+    unsigned int mask;
+
+    for(; it + 32 <= buff_sz; it += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buff + it));
+        mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, dollar), _mm256_cmpeq_epi8(v, star)));
+        if(mask)
+        {
+            /* XOR only bytes in front of delimiter */
+            tail = __builtin_ctz(mask);
+            acc = _mm256_xor_si256(acc, _mm256_and_si256(v, _mm256_cmpgt_epi8(_mm256_set1_epi8((char)tail), iota)));
+            *res_xor = nmea_reduce_avx2(acc);
+            return it + tail;
+        }
+        acc = _mm256_xor_si256(acc, v);
+    }
+
+    tail = nmea_scan_delim_scalar(buff + it, buff_sz - it, &x);
+    *res_xor = x ^ nmea_reduce_avx2(acc);
+
+    return it + tail;
+}
+
+__attribute__((target("avx2")))
+static unsigned char nmea_xor_avx2(const char *buff, int buff_sz)
+{
+    __m256i acc = _mm256_setzero_si256();
+    int it = 0;
+
+    for(; it + 32 <= buff_sz; it += 32)
+        acc = _mm256_xor_si256(acc, _mm256_loadu_si256((const __m256i *)(buff + it)));
+
+    return nmea_reduce_avx2(acc) ^ nmea_xor_scalar(buff + it, buff_sz - it);
+}
+
+#endif /* NMEA_SIMD_X86 */
+
+/*
+ * dispatch
+ */
+
+static int nmea_simd_supported(int level)
+{
+#ifdef NMEA_SIMD_X86
+    switch(level)
+    {
+    case NMEA_SIMD_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case NMEA_SIMD_SSE2:
+        return __builtin_cpu_supports("sse2");
+    };
+#endif
+    return (NMEA_SIMD_NONE == level);
+}
+
+static int nmea_simd_detect()
+{
+    int level = NMEA_SIMD_AVX2;
+
+#ifdef NMEA_SIMD_X86
+    __builtin_cpu_init();
+#endif
+
+    while(level > NMEA_SIMD_NONE && !nmea_simd_supported(level))
+        level--;
+
+    return level;
+}
+
+static int nmea_simd_current = nmea_simd_detect();
+
+/**
+ * \brief Get instruction set used by framing and checksum kernels
+ * @return Level of instruction set (nmeaSIMDLEVEL)
+ */
+int nmea_simd_level(void)
+{
+    return nmea_simd_current;
+}
+
+/**
+ * \brief Force instruction set used by framing and checksum kernels
+ * Level is lowered to the best one supported by the CPU. By default the
+ * best supported level is selected by CPUID on library load.
+ * @return Selected level (nmeaSIMDLEVEL)
+ */
+int nmea_simd_select(int level)
+{
+    if(level > NMEA_SIMD_AVX2)
+        level = NMEA_SIMD_AVX2;
+
+    while(level > NMEA_SIMD_NONE && !nmea_simd_supported(level))
+        level--;
+
+    nmea_simd_current = (level < NMEA_SIMD_NONE)?NMEA_SIMD_NONE:level;
+
+    return nmea_simd_current;
+}
+
+/**
+ * \brief Find first sentence delimiter ('$' or '*') and XOR bytes before it
+ * @param buff a constant character pointer of buffer.
+ * @param buff_sz buffer size.
+ * @param res_crc a integer pointer for return XOR of bytes before delimiter.
+ * @return Number of bytes before delimiter (buff_sz if there is no one).
+ */
+int nmea_scan_delim(const char *buff, int buff_sz, int *res_crc)
+{
+    unsigned char x = 0;
+    int nread;
+
+    switch(nmea_simd_current)
+    {
+#ifdef NMEA_SIMD_X86
+    case NMEA_SIMD_AVX2:
+        nread = nmea_scan_delim_avx2(buff, buff_sz, &x);
+        break;
+    case NMEA_SIMD_SSE2:
+        nread = nmea_scan_delim_sse2(buff, buff_sz, &x);
+        break;
+#endif
+    default:
+        nread = nmea_scan_delim_scalar(buff, buff_sz, &x);
+        break;
+    };
+
+    *res_crc = (int)(char)x;
+
+    return nread;
+}
+
+/**
+ * \brief Calculate control sum of binary buffer
+ */
+int nmea_calc_crc(const char *buff, int buff_sz)
+{
+    unsigned char x;
+
+    switch(nmea_simd_current)
+    {
+#ifdef NMEA_SIMD_X86
+    case NMEA_SIMD_AVX2:
+        x = nmea_xor_avx2(buff, buff_sz);
+        break;
+    case NMEA_SIMD_SSE2:
+        x = nmea_xor_sse2(buff, buff_sz);
+        break;
+#endif
+    default:
+        x = nmea_xor_scalar(buff, buff_sz);
+        break;
+    };
+
+    return (int)(char)x;
+}
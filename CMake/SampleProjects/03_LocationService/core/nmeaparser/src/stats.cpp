@@ -0,0 +1,445 @@
+/*
+ *
+ * NMEA library
+ * URL: http://nmea.sourceforge.net
+ * Licence: http://www.gnu.org/licenses/lgpl.html
+ *
+ */
+
+/*! \file stats.h */
+
+#include "stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Switch of stage timers and counters at run time, off until nmea_stats_enable(1),
+ * compiled out without NMEA_STATS
+ */
+int nmea_stats_on = 0;
+
+static const char *nmea_stage_names[NMEA_STAGE_LAST] = {
+    "read", "frame", "decode", "merge", "output"
+};
+
+static const char *nmea_counter_names[NMEA_COUNT_LAST] = {
+    "sentences", "crc_fail", "unknown_type", "decode_fail", "buff_overflow", "queue_overflow"
+};
+
+/**
+ * Sampling interval of stage timers
+ */
+static int nmea_stats_interval = NMEA_DEF_SAMPLE;
+
+#ifdef NMEA_STATS
+
+/**
+ * Histogram written by its owner thread only, read by snapshots
+ */
+typedef struct _nmeaHISTLOCAL
+{
+    unsigned long long  count;
+    unsigned long long  sum;
+    unsigned long long  max;
+    unsigned long long  bucket[NMEA_HIST_BUCKETS];
+
+} nmeaHISTLOCAL;
+
+/**
+ * Stage histograms and counters of one thread, kept in a list after the
+ * thread exits so its samples stay in snapshots. Owners update them with
+ * plain relaxed loads and stores, no locked instructions on the hot path.
+ */
+typedef struct _nmeaSTATSBLOCK
+{
+    nmeaHISTLOCAL               stage[NMEA_STAGE_LAST];
+    unsigned long long          counter[NMEA_COUNT_LAST];
+    struct _nmeaSTATSBLOCK     *next;
+
+} nmeaSTATSBLOCK;
+
+__thread int nmea_stats_countdown[NMEA_STAGE_LAST] __attribute__((tls_model("initial-exec")));
+
+static nmeaSTATSBLOCK *nmea_stats_blocks = 0;
+static __thread nmeaSTATSBLOCK *nmea_stats_local __attribute__((tls_model("initial-exec"))) = 0;
+
+static unsigned long long nmea_stats_base_ticks;
+static unsigned long long nmea_stats_base_ns;
+
+static unsigned long long nmea_stats_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/**
+ * \brief Reference point of tick calibration, taken when library is loaded
+ */
+static int nmea_stats_init(void)
+{
+    nmea_stats_base_ticks = nmea_stats_ticks();
+    nmea_stats_base_ns = nmea_stats_clock_ns();
+    return 1;
+}
+
+static int nmea_stats_ready = nmea_stats_init();
+
+/**
+ * \brief Block of calling thread, registered on first use
+ */
+static nmeaSTATSBLOCK *nmea_stats_block(void)
+{
+    nmeaSTATSBLOCK *block = nmea_stats_local;
+
+    if(!block)
+    {
+        if(0 == (block = (nmeaSTATSBLOCK *)calloc(1, sizeof(nmeaSTATSBLOCK))))
+            return 0;
+        block->next = __atomic_load_n(&nmea_stats_blocks, __ATOMIC_RELAXED);
+        while(!__atomic_compare_exchange_n(&nmea_stats_blocks, &block->next, block, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+        nmea_stats_local = block;
+    }
+
+    return block;
+}
+
+/**
+ * \brief Owner side increment, a single writer needs no locked instruction
+ */
+static NMEA_INLINE void nmea_stats_add(unsigned long long *value, unsigned long long delta)
+{
+    __atomic_store_n(value, __atomic_load_n(value, __ATOMIC_RELAXED) + delta, __ATOMIC_RELAXED);
+}
+
+/**
+ * \brief Bucket of value, exact below 2^NMEA_HIST_SUBBITS then NMEA_HIST_SUBBITS significant bits
+ */
+static NMEA_INLINE int nmea_hist_bucket(unsigned long long value)
+{
+    int msb;
+
+    if(value < (1ULL << NMEA_HIST_SUBBITS))
+        return (int)value;
+
+    msb = 63 - __builtin_clzll(value);
+
+    return ((msb - NMEA_HIST_SUBBITS + 1) << NMEA_HIST_SUBBITS) +
+        (int)((value >> (msb - NMEA_HIST_SUBBITS)) & ((1ULL << NMEA_HIST_SUBBITS) - 1));
+}
+
+/**
+ * \brief Middle value of bucket
+ */
+static double nmea_hist_value(int idx)
+{
+    int exp = idx >> NMEA_HIST_SUBBITS;
+    unsigned long long low, width;
+
+    if(exp == 0)
+        return idx;
+
+    width = 1ULL << (exp - 1);
+    low = ((unsigned long long)((1 << NMEA_HIST_SUBBITS) + (idx & ((1 << NMEA_HIST_SUBBITS) - 1)))) << (exp - 1);
+
+    return (double)low + (width - 1) / 2.0;
+}
+
+#endif /* NMEA_STATS */
+
+/**
+ * \brief Tells if stage timers and counters are compiled in (NMEA_STATS)
+ * @return 1 (true) - compiled in or 0 (false) - removed.
+ */
+int nmea_stats_compiled(void)
+{
+#ifdef NMEA_STATS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * \brief Turns stage timers and counters on or off at run time
+ */
+void nmea_stats_enable(int enable)
+{
+    __atomic_store_n(&nmea_stats_on, enable, __ATOMIC_RELAXED);
+}
+
+/**
+ * \brief Sets sampling of stage timers
+ * Counters count every event, stage histograms time one event of every interval.
+ * @param interval 1 - time every event.
+ */
+void nmea_stats_sample(int interval)
+{
+    nmea_stats_interval = interval < 1 ? 1 : interval;
+}
+
+/**
+ * \brief Start of a sampled stage event, called by NMEA_STATS_START once the countdown runs out
+ * @param stage nmeaSTAGE.
+ * @return Ticks of the event start, 0 when the thread has no statistics block.
+ */
+unsigned long long nmea_stats_begin(int stage)
+{
+#ifdef NMEA_STATS
+    nmeaSTATSBLOCK *block = nmea_stats_block();
+
+    if(!block || stage < 0 || stage >= NMEA_STAGE_LAST)
+        return 0;
+
+    nmea_stats_countdown[stage] = nmea_stats_interval;
+
+    return nmea_stats_ticks();
+#else
+    (void)stage;
+    return 0;
+#endif
+}
+
+/**
+ * \brief Adds duration of stage to histogram of calling thread
+ * @param stage nmeaSTAGE.
+ * @param ticks duration in nmea_stats_ticks units.
+ */
+void nmea_stats_record(int stage, unsigned long long ticks)
+{
+#ifdef NMEA_STATS
+    nmeaSTATSBLOCK *block = nmea_stats_block();
+    nmeaHISTLOCAL *hist;
+
+    if(!block || stage < 0 || stage >= NMEA_STAGE_LAST)
+        return;
+
+    hist = &block->stage[stage];
+    nmea_stats_add(&hist->bucket[nmea_hist_bucket(ticks)], 1);
+    nmea_stats_add(&hist->count, 1);
+    nmea_stats_add(&hist->sum, ticks);
+    if(ticks > hist->max)
+        __atomic_store_n(&hist->max, ticks, __ATOMIC_RELAXED);
+#else
+    (void)stage;
+    (void)ticks;
+#endif
+}
+
+/**
+ * \brief Increments counter of calling thread
+ * @param counter nmeaCOUNTER.
+ */
+void nmea_stats_count(int counter)
+{
+#ifdef NMEA_STATS
+    nmeaSTATSBLOCK *block = nmea_stats_block();
+
+    if(block && counter >= 0 && counter < NMEA_COUNT_LAST)
+        nmea_stats_add(&block->counter[counter], 1);
+#else
+    (void)counter;
+#endif
+}
+
+/**
+ * \brief Copies histograms and counters, zero when compiled out
+ * Tick duration is measured against CLOCK_MONOTONIC since library load,
+ * a snapshot taken in the first 10 ms waits for that much of reference.
+ */
+void nmea_stats_snapshot(nmeaSTATS *stats)
+{
+    memset(stats, 0, sizeof(nmeaSTATS));
+    stats->ns_per_tick = 1;
+
+#ifdef NMEA_STATS
+    {
+        nmeaSTATSBLOCK *block;
+        int stage, idx;
+        unsigned long long ticks, ns, max;
+
+        for(block = __atomic_load_n(&nmea_stats_blocks, __ATOMIC_ACQUIRE); block; block = block->next)
+        {
+            for(stage = 0; stage < NMEA_STAGE_LAST; ++stage)
+            {
+                nmeaHISTLOCAL *hist = &block->stage[stage];
+                for(idx = 0; idx < NMEA_HIST_BUCKETS; ++idx)
+                    stats->stage[stage].bucket[idx] += __atomic_load_n(&hist->bucket[idx], __ATOMIC_RELAXED);
+                stats->stage[stage].count += __atomic_load_n(&hist->count, __ATOMIC_RELAXED);
+                stats->stage[stage].sum += __atomic_load_n(&hist->sum, __ATOMIC_RELAXED);
+                max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+                if(max > stats->stage[stage].max)
+                    stats->stage[stage].max = max;
+            }
+            for(idx = 0; idx < NMEA_COUNT_LAST; ++idx)
+                stats->counter[idx] += __atomic_load_n(&block->counter[idx], __ATOMIC_RELAXED);
+        }
+
+#ifdef NMEA_SIMD_X86
+        do
+        {
+            ticks = nmea_stats_ticks();
+            ns = nmea_stats_clock_ns();
+        } while(nmea_stats_ready && ns - nmea_stats_base_ns < 10000000ULL);
+
+        stats->ns_per_tick = (double)(ns - nmea_stats_base_ns) / (double)(ticks - nmea_stats_base_ticks);
+#else
+        (void)ticks;
+        (void)ns;
+        (void)nmea_stats_ready;
+#endif
+    }
+#endif
+}
+
+/**
+ * \brief Clears histograms and counters
+ * Events of other threads recorded during the reset may survive it.
+ */
+void nmea_stats_reset(void)
+{
+#ifdef NMEA_STATS
+    nmeaSTATSBLOCK *block;
+    int stage, idx;
+
+    for(block = __atomic_load_n(&nmea_stats_blocks, __ATOMIC_ACQUIRE); block; block = block->next)
+    {
+        for(stage = 0; stage < NMEA_STAGE_LAST; ++stage)
+        {
+            nmeaHISTLOCAL *hist = &block->stage[stage];
+            for(idx = 0; idx < NMEA_HIST_BUCKETS; ++idx)
+                __atomic_store_n(&hist->bucket[idx], 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&hist->count, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&hist->sum, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&hist->max, 0, __ATOMIC_RELAXED);
+        }
+        for(idx = 0; idx < NMEA_COUNT_LAST; ++idx)
+            __atomic_store_n(&block->counter[idx], 0, __ATOMIC_RELAXED);
+    }
+#endif
+}
+
+/**
+ * \brief Duration of stage below which percent of samples are
+ * @param stats snapshot.
+ * @param stage nmeaSTAGE.
+ * @param percent [0,100].
+ * @return Nanoseconds, 0 without samples.
+ */
+double nmea_stats_percentile(const nmeaSTATS *stats, int stage, double percent)
+{
+#ifdef NMEA_STATS
+    const nmeaHIST *hist;
+    unsigned long long rank, seen = 0;
+    int idx;
+
+    if(stage < 0 || stage >= NMEA_STAGE_LAST || 0 == stats->stage[stage].count)
+        return 0;
+
+    hist = &stats->stage[stage];
+    rank = (unsigned long long)(percent / 100.0 * (double)hist->count + 0.5);
+    if(rank < 1)
+        rank = 1;
+
+    for(idx = 0; idx < NMEA_HIST_BUCKETS; ++idx)
+    {
+        seen += hist->bucket[idx];
+        if(seen >= rank)
+        {
+            double value = nmea_hist_value(idx);
+            if(value > (double)hist->max)
+                value = (double)hist->max;
+            return value * stats->ns_per_tick;
+        }
+    }
+
+    return hist->max * stats->ns_per_tick;
+#else
+    (void)stats;
+    (void)stage;
+    (void)percent;
+    return 0;
+#endif
+}
+
+/**
+ * \brief Mean duration of stage in nanoseconds, 0 without samples
+ */
+double nmea_stats_mean(const nmeaSTATS *stats, int stage)
+{
+    if(stage < 0 || stage >= NMEA_STAGE_LAST || 0 == stats->stage[stage].count)
+        return 0;
+
+    return (double)stats->stage[stage].sum / (double)stats->stage[stage].count * stats->ns_per_tick;
+}
+
+/**
+ * \brief Text table of stage latencies (ns) and counters
+ * @return Number of bytes written (without terminating zero).
+ */
+int nmea_stats_dump(char *buff, int buff_sz)
+{
+    nmeaSTATS stats;
+    int stage, idx, nwritten, total = 0;
+
+    if(buff_sz <= 0)
+        return 0;
+
+    buff[0] = '\0';
+
+    if(!nmea_stats_compiled())
+        return snprintf(buff, buff_sz, "stats: not compiled in (NMEA_STATS)\n");
+
+    nmea_stats_snapshot(&stats);
+
+#define NMEA_STATS_APPEND(...) \
+    do { \
+        nwritten = snprintf(buff + total, buff_sz - total, __VA_ARGS__); \
+        if(nwritten < 0 || nwritten >= buff_sz - total) \
+            return (int)strlen(buff); \
+        total += nwritten; \
+    } while(0)
+
+    NMEA_STATS_APPEND("%-8s %12s %10s %10s %10s %10s %10s %10s\n",
+        "stage", "samples", "mean ns", "p50", "p90", "p99", "p99.9", "max");
+
+    for(stage = 0; stage < NMEA_STAGE_LAST; ++stage)
+    {
+        NMEA_STATS_APPEND("%-8s %12llu %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f\n",
+            nmea_stage_names[stage], stats.stage[stage].count,
+            nmea_stats_mean(&stats, stage),
+            nmea_stats_percentile(&stats, stage, 50),
+            nmea_stats_percentile(&stats, stage, 90),
+            nmea_stats_percentile(&stats, stage, 99),
+            nmea_stats_percentile(&stats, stage, 99.9),
+            stats.stage[stage].max * stats.ns_per_tick);
+    }
+
+    for(idx = 0; idx < NMEA_COUNT_LAST; ++idx)
+        NMEA_STATS_APPEND("%s %s %llu", idx ? "" : "counters:", nmea_counter_names[idx], stats.counter[idx]);
+
+    NMEA_STATS_APPEND("\n");
+
+#undef NMEA_STATS_APPEND
+
+    return total;
+}
+
+/**
+ * \brief Name of stage ("read", "frame", ...)
+ */
+const char *nmea_stats_stage_name(int stage)
+{
+    return (stage >= 0 && stage < NMEA_STAGE_LAST) ? nmea_stage_names[stage] : "";
+}
+
+/**
+ * \brief Name of counter ("sentences", "crc_fail", ...)
+ */
+const char *nmea_stats_counter_name(int counter)
+{
+    return (counter >= 0 && counter < NMEA_COUNT_LAST) ? nmea_counter_names[counter] : "";
+}
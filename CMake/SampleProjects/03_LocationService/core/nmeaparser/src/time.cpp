@@ -25,6 +25,71 @@
 #   include <time.h>
 #endif
 
+/**
+ * \brief Days since 1970-01-01 of a proleptic Gregorian date
+ * @param year years since 1900 (nmeaTIME::year).
+ * @param mon months since January - [0,11].
+ * @param day day of the month - [1,31].
+ * @return Number of days, negative before 1970
+ */
+long long nmea_time_days(int year, int mon, int day)
+{
+    long long y = (long long)year + 1900 - (mon < 2);
+    long long era = ((y >= 0)?y:y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * ((mon < 2)?mon + 10:mon - 2) + 2) / 5 + day - 1;
+
+    return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+}
+
+/**
+ * \brief Convert nmeaTIME to microseconds since 1970-01-01 00:00:00 UTC
+ */
+long long nmea_time_to_us(const nmeaTIME *t)
+{
+    long long sec;
+
+    NMEA_ASSERT(t);
+
+    sec = nmea_time_days(t->year, t->mon, t->day) * 86400 + (t->hour * 60 + t->min) * 60 + t->sec;
+
+    return sec * NMEA_TIME_SEC_US + t->hsec * 10000LL;
+}
+
+/**
+ * \brief Break microseconds since 1970-01-01 00:00:00 UTC down to nmeaTIME
+ * Sub hundredth part of second is truncated.
+ */
+void nmea_time_from_us(long long us, nmeaTIME *t)
+{
+    long long days = us / NMEA_TIME_DAY_US;
+    long long tod = us % NMEA_TIME_DAY_US;
+    long long era, doe, yoe, doy, mp;
+
+    NMEA_ASSERT(t);
+
+    if(tod < 0)
+    {
+        days--;
+        tod += NMEA_TIME_DAY_US;
+    }
+
+    days += 719468;
+    era = ((days >= 0)?days:days - 146096) / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+
+    t->day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    t->mon = (int)((mp < 10)?mp + 2:mp - 10);
+    t->year = (int)(yoe + era * 400 + (t->mon < 2) - 1900);
+    t->hour = (int)(tod / (3600 * NMEA_TIME_SEC_US));
+    t->min = (int)(tod / (60 * NMEA_TIME_SEC_US) % 60);
+    t->sec = (int)(tod / NMEA_TIME_SEC_US % 60);
+    t->hsec = (int)(tod / 10000 % 100);
+}
+
 #ifdef NMEA_WIN
 
 void nmea_time_now(nmeaTIME *stm)
@@ -42,23 +107,58 @@ void nmea_time_now(nmeaTIME *stm)
     stm->hsec = st.wMilliseconds / 10;
 }
 
+long long nmea_time_now_us(void)
+{
+    nmeaTIME now;
+
+    nmea_time_now(&now);
+
+    return nmea_time_to_us(&now);
+}
+
 #else /* NMEA_WIN */
 
+#ifdef CLOCK_REALTIME_COARSE
+#   define NMEA_TIME_CLOCK  CLOCK_REALTIME_COARSE
+#else
+#   define NMEA_TIME_CLOCK  CLOCK_REALTIME
+#endif
+
+/**
+ * \brief Microseconds since 1970-01-01 00:00:00 UTC by coarse real time clock
+ * Resolution is a tick of the kernel (a few milliseconds), no system call
+ * where the clock is served by vDSO.
+ */
+long long nmea_time_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(NMEA_TIME_CLOCK, &ts);
+
+    return (long long)ts.tv_sec * NMEA_TIME_SEC_US + ts.tv_nsec / 1000;
+}
+
+/**
+ * \brief Get time now to nmeaTIME structure
+ * Calendar breakdown of the current second is cached per thread, so within
+ * one second it costs a clock read only.
+ */
 void nmea_time_now(nmeaTIME *stm)
 {
-    time_t lt;
-    struct tm *tt;
-
-    time(&lt);
-    tt = gmtime(&lt);
-
-    stm->year = tt->tm_year;
-    stm->mon = tt->tm_mon;
-    stm->day = tt->tm_mday;
-    stm->hour = tt->tm_hour;
-    stm->min = tt->tm_min;
-    stm->sec = tt->tm_sec;
-    stm->hsec = 0;
+    static __thread long long cached_sec = -1;
+    static __thread nmeaTIME cached;
+    struct timespec ts;
+
+    clock_gettime(NMEA_TIME_CLOCK, &ts);
+
+    if(NMEA_UNLIKELY((long long)ts.tv_sec != cached_sec))
+    {
+        nmea_time_from_us((long long)ts.tv_sec * NMEA_TIME_SEC_US, &cached);
+        cached_sec = (long long)ts.tv_sec;
+    }
+
+    *stm = cached;
+    stm->hsec = (int)(ts.tv_nsec / 10000000);
 }
 
 #endif
@@ -11,6 +11,7 @@
 /*! \file tok.h */
 
 #include "tok.h"
+#include "degree.h"
 
 #include <stdarg.h>
 #include <stdlib.h>
@@ -24,20 +25,6 @@
 #define NMEA_TOKS_WIDTH     (3)
 #define NMEA_TOKS_TYPE      (4)
 
-/**
- * \brief Calculate control sum of binary buffer
- */
-int nmea_calc_crc(const char *buff, int buff_sz)
-{
-    int chsum = 0,
-        it;
-
-    for(it = 0; it < buff_sz; ++it)
-        chsum ^= (int)buff[it];
-
-    return chsum;
-}
-
 /**
  * \brief Convert string to number
  */
@@ -248,3 +235,205 @@ fail:
 
     return tok_count;
 }
+
+/**
+ * \brief Convert token to integer in place (same result as nmea_atoi)
+ * Plain decimal tokens are converted without copying,
+ * anything else goes through nmea_atoi.
+ */
+static int nmea_fast_atoi(const char *str, int str_sz)
+{
+    const char *end = str + str_sz;
+    const char *beg_num;
+    int res = 0, neg = 0;
+
+    if(str_sz >= NMEA_CONVSTR_BUF)
+        return nmea_atoi(str, str_sz, 10);
+
+    if(str < end && ('-' == *str || '+' == *str))
+        neg = ('-' == *str++);
+
+    for(beg_num = str; str < end && *str >= '0' && *str <= '9'; ++str)
+        res = res * 10 + (*str - '0');
+
+    if(str == beg_num || str - beg_num > 9)
+        return nmea_atoi(end - str_sz, str_sz, 10);
+
+    return (neg?-res:res);
+}
+
+/**
+ * \brief Convert token to fraction number in place (same result as nmea_atof)
+ * Fixed-point tokens with up to 15 digits are converted exactly by one
+ * division of two exactly representable values, which gives the same
+ * correctly rounded result as strtod. Anything else goes through nmea_atof.
+ */
+static double nmea_fast_atof(const char *str, int str_sz)
+{
+    static const double pow10_tab[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+        1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+    };
+
+    const char *end = str + str_sz;
+    long long mant = 0;
+    int neg = 0, ndig = 0, nfra = 0;
+
+    if(str_sz >= NMEA_CONVSTR_BUF)
+        return nmea_atof(str, str_sz);
+
+    if(str < end && ('-' == *str || '+' == *str))
+        neg = ('-' == *str++);
+
+    for(; str < end && *str >= '0' && *str <= '9'; ++str, ++ndig)
+        mant = mant * 10 + (*str - '0');
+
+    if(str < end && '.' == *str)
+    {
+        for(++str; str < end && *str >= '0' && *str <= '9'; ++str, ++ndig, ++nfra)
+            mant = mant * 10 + (*str - '0');
+    }
+
+    if(!ndig || ndig > 15 || (str < end && isalpha((unsigned char)*str)))
+        return nmea_atof(end - str_sz, str_sz);
+
+    return (neg?-((double)mant / pow10_tab[nfra]):((double)mant / pow10_tab[nfra]));
+}
+
+/**
+ * \brief Convert NDEG token ([degree][min].[sec/60]) to micro-degrees
+ * Plain unsigned fixed-point tokens are converted by integer arithmetic
+ * without floating point round trip, rounded half up and saturated to int
+ * range. Anything else goes through nmea_atof.
+ */
+int nmea_atoudeg(const char *str, int str_sz)
+{
+    static const long long pow10_tab[] = {
+        1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL,
+        1000000LL, 10000000LL, 100000000LL, 1000000000LL, 10000000000LL
+    };
+
+    const char *end = str + str_sz;
+    long long ipart = 0, fpart = 0, scale;
+    int nint = 0, nfra = 0;
+
+    for(; str < end && *str >= '0' && *str <= '9' && nint < 12; ++str, ++nint)
+        ipart = ipart * 10 + (*str - '0');
+
+    if(str < end && '.' == *str)
+    {
+        for(++str; str < end && *str >= '0' && *str <= '9' && nfra < 10; ++str, ++nfra)
+            fpart = fpart * 10 + (*str - '0');
+    }
+
+    if(!nint || str != end)
+        return nmea_fast_ndeg2udeg(nmea_atof(end - str_sz, str_sz));
+
+    /* minutes scaled by 10^nfra, then to micro-degrees */
+    scale = pow10_tab[nfra];
+    fpart += (ipart % 100) * scale;
+
+    ipart = (ipart / 100) * NMEA_UDEG_SCALE + (fpart * NMEA_UDEG_SCALE + 30 * scale) / (60 * scale);
+
+    return (ipart > INT_MAX)?INT_MAX:(int)ipart;
+}
+
+/**
+ * \brief Analyse sentence by table of fields
+ * Walks the sentence once and converts every field in place. Tokens are
+ * delimited and counted exactly like nmea_scanf does for the equivalent
+ * format string, so both give the same result.
+ * @param buff a constant character pointer of packet buffer.
+ * @param buff_sz buffer size.
+ * @param head literal sentence header (e.g. "$GPGGA,"), '?' matches any character.
+ * @param fields table of fields following the header.
+ * @param nfields number of fields in table.
+ * @param pack base address for field offsets.
+ * @param str (O) pointer to NMEA_FIELD_STR token (untouched if token is empty).
+ * @param str_sz (O) size of NMEA_FIELD_STR token.
+ * @return Number of scanned tokens.
+ */
+int nmea_scan_fields(
+    const char *buff, int buff_sz,
+    const char *head,
+    const nmeaFIELD *fields, int nfields,
+    void *pack,
+    const char **str, int *str_sz
+    )
+{
+    const char *end_buf = buff + buff_sz;
+    const char *beg_tok;
+    const nmeaFIELD *field;
+    char *target;
+    int tok_count = 0, width;
+
+    for(; *head && buff < end_buf; ++head)
+    {
+        if(*buff++ != *head && '?' != *head)
+            return 0;
+    }
+
+    for(field = fields; field < fields + nfields && buff < end_buf; ++field)
+    {
+        beg_tok = buff;
+        target = (char *)pack + field->offset;
+
+        switch(field->type)
+        {
+        case NMEA_FIELD_INT2:
+            if(buff + 2 > end_buf)
+                return tok_count;
+            buff += 2;
+            break;
+        case NMEA_FIELD_CHAR:
+            if(*buff != field->delim)
+                buff++;
+            break;
+        default:
+            if(!field->delim || (0 == (buff = (const char *)memchr(buff, field->delim, end_buf - buff))))
+                buff = end_buf;
+            break;
+        };
+
+        tok_count++;
+
+        if(0 != (width = (int)(buff - beg_tok)))
+        {
+            switch(field->type)
+            {
+            case NMEA_FIELD_CHAR:
+                *target = *beg_tok;
+                break;
+            case NMEA_FIELD_INT:
+                *((int *)target) = nmea_fast_atoi(beg_tok, width);
+                break;
+            case NMEA_FIELD_INT2:
+                /* two digits at fixed offset (ddmmyy), anything else like %2d */
+                if((unsigned int)(beg_tok[0] - '0') < 10 && (unsigned int)(beg_tok[1] - '0') < 10)
+                    *((int *)target) = (beg_tok[0] - '0') * 10 + (beg_tok[1] - '0');
+                else
+                    *((int *)target) = nmea_fast_atoi(beg_tok, width);
+                break;
+            case NMEA_FIELD_DOUBLE:
+                *((double *)target) = nmea_fast_atof(beg_tok, width);
+                break;
+            case NMEA_FIELD_NDEG:
+                *((double *)target) = nmea_fast_atof(beg_tok, width);
+                *((int *)((char *)pack + field->offset_udeg)) = nmea_atoudeg(beg_tok, width);
+                break;
+            case NMEA_FIELD_STR:
+                *str = beg_tok;
+                *str_sz = width;
+                break;
+            };
+        }
+
+        if(field->delim)
+        {
+            if(buff >= end_buf || *buff++ != field->delim)
+                break;
+        }
+    }
+
+    return tok_count;
+}
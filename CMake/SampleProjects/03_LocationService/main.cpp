@@ -1,42 +1,265 @@
 // main.cpp
+//
+// Usage: LocationService [-q] [-b] [-u] [-s name] [-t seconds] [-e ms] [-m types] [source...]
+//   -q, --quiet       no echo of input lines
+//   -b, --binary      fixes as binary FixRecord stream on standard output (implies -q)
+//   -u, --uring       read sources with io_uring multishot reads (read() when unavailable)
+//   -s, --shm name    publish the latest fix in POSIX shared memory segment name (e.g. /locationservice)
+//   -t, --stats sec   collect stage latencies and counters, table to standard error every
+//                     sec seconds (also on SIGUSR1 and at exit); 0 only on SIGUSR1 and at exit
+//   -e, --epoch ms    report a receiver epoch after ms milliseconds when the next one did not
+//                     start (default 1500, 0 waits for the next epoch)
+//   -m, --epoch-mask types
+//                     report an epoch as soon as these sentences arrived (e.g. GGA,GSA,GSV,RMC,VTG),
+//                     one epoch period earlier; sentences outside the list are dropped as late
+//   -                 standard input (default when no source is given)
+//   unix:/path        UNIX stream socket
+//   tcp:host:port     TCP connection
+//   /path             serial port, FIFO or recorded log
 
-#include "service/LocationService.h"
+#include "service/EventLoop.h"
 #include <csignal>
+#include <cstdlib>
 #include <iostream>
+#include <netdb.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
 #include <unistd.h>
 
-volatile sig_atomic_t signalReceived = 0;
+static int connectUnix(const std::string& path)
+{
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        return -1;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static int connectTcp(const std::string& hostPort)
+{
+    size_t colon = hostPort.rfind(':');
+    if (colon == std::string::npos)
+    {
+        return -1;
+    }
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *result = NULL;
+    if (getaddrinfo(hostPort.substr(0, colon).c_str(), hostPort.substr(colon + 1).c_str(), &hints, &result) != 0)
+    {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *it = result; it != NULL && fd < 0; it = it->ai_next)
+    {
+        fd = socket(it->ai_family, it->ai_socktype | SOCK_CLOEXEC, it->ai_protocol);
+        if (fd >= 0 && connect(fd, it->ai_addr, it->ai_addrlen) < 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+static int openDevice(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd >= 0 && isatty(fd))
+    {
+        // Serial receivers keep their line speed, only the line discipline is made raw
+        struct termios tio;
+        if (tcgetattr(fd, &tio) == 0)
+        {
+            cfmakeraw(&tio);
+            tcsetattr(fd, TCSANOW, &tio);
+        }
+    }
+    return fd;
+}
+
+static int openSource(const std::string& spec)
+{
+    if (spec == "-")
+    {
+        return STDIN_FILENO;
+    }
+    if (spec.compare(0, 5, "unix:") == 0)
+    {
+        return connectUnix(spec.substr(5));
+    }
+    if (spec.compare(0, 4, "tcp:") == 0)
+    {
+        return connectTcp(spec.substr(4));
+    }
+    return openDevice(spec);
+}
+
+// Options followed by a value
+static bool takesValue(const char *option)
+{
+    static const char *const options[] = { "-s", "--shm", "-t", "--stats", "-e", "--epoch", "-m", "--epoch-mask" };
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); ++i)
+    {
+        if (strcmp(option, options[i]) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
-void signalHandler(int signal)
+// Comma separated sentence types as packet mask, -1 for an unknown type
+static int parseEpochMask(const std::string& types)
 {
-    signalReceived = signal;
+    static const struct { const char *name; int ptype; } known[] = {
+        { "GGA", GPGGA }, { "GSA", GPGSA }, { "GSV", GPGSV }, { "RMC", GPRMC }, { "VTG", GPVTG }
+    };
+    int mask = 0;
+    size_t begin = 0;
+    while (begin <= types.size())
+    {
+        size_t end = types.find(',', begin);
+        end = (end == std::string::npos) ? types.size() : end;
+        const std::string type = types.substr(begin, end - begin);
+        int ptype = 0;
+        for (size_t i = 0; i < sizeof(known) / sizeof(known[0]) && ptype == 0; ++i)
+        {
+            if (type == known[i].name)
+            {
+                ptype = known[i].ptype;
+            }
+        }
+        if (ptype == 0)
+        {
+            return -1;
+        }
+        mask |= ptype;
+        begin = end + 1;
+    }
+    return mask;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    LocationService service;
+    // Now the process is daemonized
+    // Signals are blocked here and received by the event loop
+    FixSnapshot snapshot;
+    FixRecordWriter records(STDOUT_FILENO);
+    EventLoop loop;
+    bool binary = false;
+    bool stats = false;
 
-    // Set up signal handling
-    struct sigaction action;
-    action.sa_handler = signalHandler;
-    sigemptyset(&action.sa_mask);
-    action.sa_flags = 0;
-    sigaction(SIGINT, &action, NULL);
+    int first = 1;
+    for (; first < argc; ++first)
+    {
+        if (first + 1 >= argc && takesValue(argv[first]))
+        {
+            std::cerr << argv[first] << ": option requires an argument" << std::endl;
+            return 1;
+        }
 
-    // Wait for the signal to exit
-    while (signalReceived == 0)
+        if (strcmp(argv[first], "-q") == 0 || strcmp(argv[first], "--quiet") == 0)
+        {
+            loop.setQuiet(true);
+        }
+        else if (strcmp(argv[first], "-b") == 0 || strcmp(argv[first], "--binary") == 0)
+        {
+            // Nothing but records may reach standard output
+            binary = true;
+            loop.setQuiet(true);
+            loop.setRecordWriter(&records);
+        }
+        else if (strcmp(argv[first], "-u") == 0 || strcmp(argv[first], "--uring") == 0)
+        {
+            if (!loop.enableUring())
+            {
+                std::cerr << "io_uring not available, sources are read with read()" << std::endl;
+            }
+        }
+        else if (strcmp(argv[first], "-s") == 0 || strcmp(argv[first], "--shm") == 0)
+        {
+            if (!snapshot.createShared(argv[++first]))
+            {
+                return 1;
+            }
+            loop.setSnapshot(&snapshot);
+        }
+        else if (strcmp(argv[first], "-t") == 0 || strcmp(argv[first], "--stats") == 0)
+        {
+            stats = true;
+            nmea_stats_enable(1);
+            loop.setStatsInterval(atol(argv[++first]) * 1000);
+        }
+        else if (strcmp(argv[first], "-e") == 0 || strcmp(argv[first], "--epoch") == 0)
+        {
+            loop.setEpochTimeout(atoi(argv[++first]));
+        }
+        else if (strcmp(argv[first], "-m") == 0 || strcmp(argv[first], "--epoch-mask") == 0)
+        {
+            int mask = parseEpochMask(argv[++first]);
+            if (mask < 0)
+            {
+                std::cerr << "Unknown sentence type in epoch mask " << argv[first] << std::endl;
+                return 1;
+            }
+            loop.setEpochMask(mask);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc <= first)
+    {
+        loop.addSource(STDIN_FILENO, "stdin");
+    }
+    for (int i = first; i < argc; ++i)
     {
-        // Now the process is daemonized
-        // Read from stdin and parse NMEA messages
-        std::string input;
-        while (std::getline(std::cin, input))
+        int fd = openSource(argv[i]);
+        if (fd < 0 || !loop.addSource(fd, argv[i]))
         {
-            std::cout << "Receive user input: " << input << std::endl;
-            service.parseNMEAMessage(input);
+            std::cerr << "Cannot open source " << argv[i] << ": " << strerror(errno) << std::endl;
+            if (fd > STDIN_FILENO)
+            {
+                close(fd);
+            }
         }
     }
 
-    std::cout << "Received SIGINT. Cleaning up and exiting." << std::endl;
+    // Wait for the signal or end of every source to exit
+    int signal = loop.run();
+    if (stats)
+    {
+        char table[2048];
+        std::cerr << std::string(table, nmea_stats_dump(table, sizeof(table)));
+    }
+    std::ostream& status = binary ? std::cerr : std::cout;
+    if (signal == SIGINT)
+    {
+        status << "Received SIGINT. Cleaning up and exiting." << std::endl;
+    }
+    else if (signal == SIGTERM)
+    {
+        status << "Received SIGTERM. Cleaning up and exiting." << std::endl;
+    }
 
-    return 0;
+    return signal < 0 ? 1 : 0;
 }
@@ -0,0 +1,502 @@
+// EventLoop.cpp
+
+#include "EventLoop.h"
+#include "Timing.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+
+static const int kMaxEvents = 256;
+// Open epochs are checked for their timeout this often
+static const long kEpochPollMs = 100;
+
+EventLoop::EventLoop(OutputBuffer& output)
+    : output(output), quiet(false), snapshot(NULL), recordWriter(NULL),
+      statsIntervalMs(0), nextStatsMs(0), epochTimeoutMs(NMEA_DEF_EPOCH_TIMEOUT), epochMask(NMEA_DEF_EPOCH_MASK), epochsPending(false), nextEpochMs(0),
+      epollFd(epoll_create1(EPOLL_CLOEXEC)), signalFd(-1), epollPending(false), lines(0), bytes(0)
+{
+    if (epollFd < 0)
+    {
+        perror("epoll_create1");
+        return;
+    }
+
+    // Signals are blocked and delivered through the loop instead of interrupting it
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+
+    signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd < 0)
+    {
+        perror("signalfd");
+        return;
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event);
+}
+
+EventLoop::~EventLoop()
+{
+    while (!sources.empty())
+    {
+        closeSource(sources.begin()->second.get());
+    }
+    flushOutput();
+    if (signalFd >= 0)
+    {
+        close(signalFd);
+    }
+    if (epollFd >= 0)
+    {
+        close(epollFd);
+    }
+}
+
+void EventLoop::setQuiet(bool quiet)
+{
+    this->quiet = quiet;
+}
+
+void EventLoop::setSnapshot(FixSnapshot* snapshot)
+{
+    this->snapshot = snapshot;
+    for (auto& entry : sources)
+    {
+        entry.second->service.setSnapshot(snapshot);
+    }
+}
+
+void EventLoop::setRecordWriter(FixRecordWriter* writer)
+{
+    recordWriter = writer;
+    for (auto& entry : sources)
+    {
+        entry.second->service.setRecordWriter(writer);
+    }
+}
+
+void EventLoop::setStatsInterval(long intervalMs)
+{
+    statsIntervalMs = intervalMs;
+    nextStatsMs = monotonicMs() + intervalMs;
+}
+
+void EventLoop::setEpochTimeout(int timeoutMs)
+{
+    epochTimeoutMs = timeoutMs;
+}
+
+void EventLoop::setEpochMask(int mask)
+{
+    epochMask = mask;
+}
+
+bool EventLoop::enableUring()
+{
+    if (epollFd < 0)
+    {
+        return false;
+    }
+
+    // Signals and sources left to read() still arrive through the epoll set
+    std::unique_ptr<UringReader> reader(new UringReader);
+    if (!reader->valid() || !reader->poll(epollFd, NULL))
+    {
+        return false;
+    }
+    uring = std::move(reader);
+    return true;
+}
+
+bool EventLoop::addSource(int fd, const std::string& name)
+{
+    if (epollFd < 0 || fd < 0 || sources.count(fd))
+    {
+        return false;
+    }
+
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        perror("fcntl");
+        return false;
+    }
+
+    std::unique_ptr<Source> source(new Source);
+    source->fd = fd;
+    source->pollable = true;
+    source->name = name;
+    source->buffer.resize(kSourceBufferSize);
+    source->used = 0;
+    source->service.setOutput(&output);
+    source->service.setSnapshot(snapshot);
+    source->service.setRecordWriter(recordWriter);
+    source->service.setEpochTimeout(epochTimeoutMs);
+    source->service.setEpochMask(epochMask);
+
+    // Regular files have no multishot reads, they stay on read()
+    struct stat st;
+    source->uring = uring && fstat(fd, &st) == 0 && !S_ISREG(st.st_mode) && uring->add(fd, source.get());
+    if (!source->uring && !watchSource(source.get()))
+    {
+        return false;
+    }
+
+    sources[fd] = std::move(source);
+    return true;
+}
+
+int EventLoop::run()
+{
+    std::vector<struct epoll_event> events(kMaxEvents);
+
+    while (!sources.empty())
+    {
+        // Do not sleep while regular files still have data to read or past the output flush time
+        long timeout = unpollable.empty() ? flushTimeout() : 0;
+        bool epollReady = true;
+        if (uring)
+        {
+            // Reads of io_uring sources and readiness of the epoll set arrive in one wait
+            if (uring->wait(epollPending ? 0 : timeout) < 0)
+            {
+                perror("io_uring_enter");
+                return -1;
+            }
+            epollReady = epollPending;
+            uring->drain([&](const UringReader::Completion& completion) {
+                if (completion.tag != NULL)
+                {
+                    readUring(static_cast<Source *>(completion.tag), completion);
+                    return;
+                }
+                epollReady = true;
+                if (!completion.more)
+                {
+                    uring->poll(epollFd, NULL);
+                }
+            });
+            timeout = 0;
+        }
+
+        int count = epollReady ? epoll_wait(epollFd, events.data(), kMaxEvents, timeout) : 0;
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("epoll_wait");
+            return -1;
+        }
+        // Sources still readable after a partial read do not wake the poll of the epoll set again
+        epollPending = count > 0;
+
+        for (int i = 0; i < count; ++i)
+        {
+            Source *source = static_cast<Source *>(events[i].data.ptr);
+            if (source == NULL)
+            {
+                struct signalfd_siginfo info;
+                if (read(signalFd, &info, sizeof(info)) != sizeof(info))
+                {
+                    continue;
+                }
+                if (info.ssi_signo == SIGUSR1)
+                {
+                    dumpStats();
+                    continue;
+                }
+                flushOutput();
+                return static_cast<int>(info.ssi_signo);
+            }
+            if (!readSource(*source))
+            {
+                closeSource(source);
+            }
+        }
+
+        for (size_t i = 0; i < unpollable.size();)
+        {
+            if (readSource(*unpollable[i]))
+            {
+                ++i;
+            }
+            else
+            {
+                closeSource(unpollable[i]);
+            }
+        }
+
+        output.poll();
+        if (recordWriter)
+        {
+            recordWriter->poll();
+        }
+        if (statsIntervalMs > 0 && monotonicMs() >= nextStatsMs)
+        {
+            dumpStats();
+            nextStatsMs += statsIntervalMs;
+        }
+        if (epochsPending && monotonicMs() >= nextEpochMs)
+        {
+            pollEpochs();
+        }
+    }
+
+    flushOutput();
+    return 0;
+}
+
+size_t EventLoop::sourceCount() const
+{
+    return sources.size();
+}
+
+unsigned long long EventLoop::lineCount() const
+{
+    return lines;
+}
+
+unsigned long long EventLoop::byteCount() const
+{
+    return bytes;
+}
+
+bool EventLoop::watchSource(Source* source)
+{
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.ptr = source;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, source->fd, &event) < 0)
+    {
+        if (errno != EPERM)
+        {
+            perror("epoll_ctl");
+            return false;
+        }
+        source->pollable = false;
+        unpollable.push_back(source);
+    }
+    return true;
+}
+
+// Returns false when the source reached end of stream or failed
+bool EventLoop::readSource(Source& source)
+{
+    NMEA_STATS_START(start, NMEA_STAGE_READ);
+    ssize_t nread = read(source.fd, source.buffer.data() + source.used, source.buffer.size() - source.used);
+    NMEA_STATS_STOP(NMEA_STAGE_READ, start);
+
+    if (nread > 0)
+    {
+        bytes += nread;
+        source.used += nread;
+        dispatchLines(source, false);
+        if (source.used == source.buffer.size())
+        {
+            // Line longer than the buffer is handed over in pieces
+            dispatchLines(source, true);
+        }
+        return true;
+    }
+    if (nread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return true;
+    }
+    // EIO is how the slave side of a pseudo-terminal reports hang up of the master
+    if (nread < 0 && errno != EIO)
+    {
+        perror(source.name.c_str());
+    }
+
+    dispatchLines(source, true);
+    return false;
+}
+
+// Completion of a multishot read, the read is armed again when the kernel ended it
+void EventLoop::readUring(Source* source, const UringReader::Completion& completion)
+{
+    if (completion.result > 0)
+    {
+        bytes += completion.result;
+        consume(*source, completion.data, completion.result);
+        if (completion.more || uring->rearm(source->fd, source))
+        {
+            return;
+        }
+    }
+    else if (completion.result == -ENOBUFS)
+    {
+        // Every provided buffer was taken in this batch, they are free again by the next wait
+        if (uring->rearm(source->fd, source))
+        {
+            return;
+        }
+    }
+    else if (completion.result == -EINVAL || completion.result == -EOPNOTSUPP || completion.result == -EBADFD)
+    {
+        // Kernel without multishot reads of this kind of file
+        source->uring = false;
+        if (watchSource(source))
+        {
+            return;
+        }
+    }
+    else if (completion.result < 0 && completion.result != -EIO)
+    {
+        errno = static_cast<int>(-completion.result);
+        perror(source->name.c_str());
+    }
+
+    dispatchLines(*source, true);
+    closeSource(source);
+}
+
+// Appends bytes read into a provided buffer to the line buffer of source
+void EventLoop::consume(Source& source, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        size_t count = std::min(size, source.buffer.size() - source.used);
+        memcpy(source.buffer.data() + source.used, data, count);
+        source.used += count;
+        data += count;
+        size -= count;
+        dispatchLines(source, false);
+        if (source.used == source.buffer.size())
+        {
+            // Line longer than the buffer is handed over in pieces
+            dispatchLines(source, true);
+        }
+    }
+}
+
+// Hands complete lines to the service, flush also hands over the trailing partial line
+void EventLoop::dispatchLines(Source& source, bool flush)
+{
+    const char *begin = source.buffer.data();
+    const char *end = begin + source.used;
+
+    while (begin < end)
+    {
+        const char *tail = static_cast<const char *>(memchr(begin, '\n', end - begin));
+        if (tail == NULL && !flush)
+        {
+            break;
+        }
+        tail = tail ? tail : end;
+        const char *next = (tail < end) ? tail + 1 : end;
+
+        if (!quiet)
+        {
+            output.append("Receive user input: ");
+            output.append(begin, tail - begin);
+            output.append("\n");
+        }
+        // Parser frames sentences itself, so the line goes with its line end
+        source.service.parseNMEAMessage(begin, next - begin);
+        epochsPending = true;
+        lines++;
+
+        begin = next;
+    }
+
+    source.used = end - begin;
+    memmove(source.buffer.data(), begin, source.used);
+}
+
+void EventLoop::closeSource(Source* source)
+{
+    // io_uring sources are not in the epoll set
+    if (!source->pollable)
+    {
+        unpollable.erase(std::remove(unpollable.begin(), unpollable.end(), source), unpollable.end());
+    }
+    else if (!source->uring)
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, source->fd, NULL);
+    }
+
+    // Whatever arrived of the last epoch is reported
+    source->service.finishEpoch();
+
+    int fd = source->fd;
+    close(fd);
+    sources.erase(fd);
+}
+
+// Nearest flush time of text and binary output or of the next stats dump
+long EventLoop::flushTimeout() const
+{
+    long timeout = output.flushTimeout();
+    long recordTimeout = recordWriter ? recordWriter->flushTimeout() : -1;
+    if (timeout < 0 || (recordTimeout >= 0 && recordTimeout < timeout))
+    {
+        timeout = recordTimeout;
+    }
+    if (statsIntervalMs > 0)
+    {
+        long long left = nextStatsMs - monotonicMs();
+        long statsTimeout = left > 0 ? static_cast<long>(left) : 0;
+        if (timeout < 0 || statsTimeout < timeout)
+        {
+            timeout = statsTimeout;
+        }
+    }
+    if (epochsPending && epochTimeoutMs > 0)
+    {
+        long long left = nextEpochMs - monotonicMs();
+        long epochTimeout = left > 0 ? static_cast<long>(left) : 0;
+        if (timeout < 0 || epochTimeout < timeout)
+        {
+            timeout = epochTimeout;
+        }
+    }
+    return timeout;
+}
+
+// Reports epochs whose timeout expired, the next check is due only while some are incomplete
+void EventLoop::pollEpochs()
+{
+    epochsPending = false;
+    for (auto& entry : sources)
+    {
+        if (entry.second->service.pollEpoch())
+        {
+            epochsPending = true;
+        }
+    }
+    nextEpochMs = monotonicMs() + kEpochPollMs;
+}
+
+void EventLoop::flushOutput()
+{
+    output.flush();
+    if (recordWriter)
+    {
+        recordWriter->flush();
+    }
+}
+
+void EventLoop::dumpStats()
+{
+    char table[2048];
+    int size = nmea_stats_dump(table, sizeof(table));
+    if (size > 0 && write(STDERR_FILENO, table, size) < 0)
+    {
+        perror("stats");
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LocationService.h"
+#include "OutputBuffer.h"
+#include "UringReader.h"
+
+// Single threaded epoll loop over many NMEA sources (serial ports, sockets,
+// pipes, pseudo-terminals). Every source owns its LocationService, so parser
+// state never mixes between receivers. SIGINT and SIGTERM are taken through
+// a signalfd and stop the loop. Echo of input lines and fix reports of all
+// sources are batched in one OutputBuffer. With io_uring enabled, sources
+// are read by multishot reads and the epoll set is polled through the same
+// ring, so a batch over all sources costs one io_uring_enter instead of
+// epoll_wait plus a read() per ready source.
+class EventLoop
+{
+public:
+    static const size_t kSourceBufferSize = 4096;
+
+    explicit EventLoop(OutputBuffer& output = OutputBuffer::standardOutput());
+    ~EventLoop();
+
+    // Quiet mode drops the per-line echo of input
+    void setQuiet(bool quiet);
+    // Fixes of every source are published to snapshot (NULL: each source keeps its own)
+    void setSnapshot(FixSnapshot* snapshot);
+    // Fixes of every source go to writer as binary records instead of text (NULL: text)
+    void setRecordWriter(FixRecordWriter* writer);
+    // Stage latency and counter table (nmea_stats_dump) to standard error every interval, 0 never.
+    // SIGUSR1 asks for the table at any time.
+    void setStatsInterval(long intervalMs);
+    // Epochs of sources added afterwards are reported after timeoutMs (0 never) when no next one started
+    void setEpochTimeout(int timeoutMs);
+    // Packets completing an epoch of sources added afterwards (LocationService::setEpochMask)
+    void setEpochMask(int mask);
+
+    // Sources added afterwards are read through io_uring, false when the kernel
+    // has no io_uring and they are read() as before. run() must be called by this thread.
+    bool enableUring();
+
+    // Takes ownership of fd and switches it to non-blocking mode
+    bool addSource(int fd, const std::string& name);
+    // Runs until a signal arrives or every source is closed, returns the signal number or 0
+    int run();
+
+    size_t sourceCount() const;
+    unsigned long long lineCount() const;
+    unsigned long long byteCount() const;
+
+private:
+    struct Source
+    {
+        int fd;
+        bool pollable;
+        bool uring;
+        std::string name;
+        std::vector<char> buffer;
+        size_t used;
+        LocationService service;
+    };
+
+    bool watchSource(Source* source);
+    bool readSource(Source& source);
+    void readUring(Source* source, const UringReader::Completion& completion);
+    void consume(Source& source, const char* data, size_t size);
+    void dispatchLines(Source& source, bool flush);
+    void closeSource(Source* source);
+    long flushTimeout() const;
+    void pollEpochs();
+    void flushOutput();
+    void dumpStats();
+
+    OutputBuffer& output;
+    bool quiet;
+    FixSnapshot* snapshot;
+    FixRecordWriter* recordWriter;
+    long statsIntervalMs;
+    long long nextStatsMs;
+    int epochTimeoutMs;
+    int epochMask;
+    bool epochsPending;
+    long long nextEpochMs;
+    int epollFd;
+    int signalFd;
+    std::unique_ptr<UringReader> uring;
+    bool epollPending;
+    std::unordered_map<int, std::unique_ptr<Source>> sources;
+    std::vector<Source*> unpollable; // regular files are always readable and cannot be polled
+    unsigned long long lines;
+    unsigned long long bytes;
+};
+
+#endif // EVENTLOOP_H
@@ -0,0 +1,60 @@
+// FixRecord.cpp
+
+#include "FixRecord.h"
+
+#include <cmath>
+#include <cstring>
+
+static const char kStreamMagic[8] = { 'N', 'M', 'E', 'A', 'F', 'I', 'X', '\0' };
+
+static uint8_t clampByte(int value)
+{
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+FixRecord FixRecord::fromFix(const LocationFix& fix)
+{
+    FixRecord record;
+    record.utcUs = fix.utcUs;
+    record.latUdeg = static_cast<int32_t>(std::lround(fix.lat * 1e6));
+    record.lonUdeg = static_cast<int32_t>(std::lround(fix.lon * 1e6));
+    record.elv = static_cast<float>(fix.elv);
+    record.speed = static_cast<float>(fix.speed);
+    record.direction = static_cast<float>(fix.direction);
+    record.sig = clampByte(fix.sig);
+    record.fix = clampByte(fix.fix);
+    record.satinuse = clampByte(fix.satinuse);
+    record.satinview = clampByte(fix.satinview);
+    return record;
+}
+
+LocationFix FixRecord::toFix() const
+{
+    LocationFix result;
+    result.utcUs = utcUs;
+    result.lat = latUdeg * 1e-6;
+    result.lon = lonUdeg * 1e-6;
+    result.elv = elv;
+    result.speed = speed;
+    result.direction = direction;
+    result.sig = sig;
+    result.fix = fix;
+    result.satinuse = satinuse;
+    result.satinview = satinview;
+    result.ingestNs = 0;
+    return result;
+}
+
+FixStreamHeader FixStreamHeader::current()
+{
+    FixStreamHeader header;
+    memcpy(header.magic, kStreamMagic, sizeof(header.magic));
+    header.version = kVersion;
+    header.recordSize = sizeof(FixRecord);
+    return header;
+}
+
+bool FixStreamHeader::valid() const
+{
+    return memcmp(magic, kStreamMagic, sizeof(magic)) == 0 && version == kVersion && recordSize == sizeof(FixRecord);
+}
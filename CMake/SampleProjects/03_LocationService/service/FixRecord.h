@@ -0,0 +1,42 @@
+#ifndef FIXRECORD_H
+#define FIXRECORD_H
+#include <cstdint>
+
+#include "LocationFix.h"
+
+// Fixed layout binary fix, 32 bytes in host byte order. A stream starts
+// with one FixStreamHeader followed by records back to back, so readers
+// index fields directly instead of parsing text.
+struct FixRecord
+{
+    int64_t utcUs;      // microseconds since 1970-01-01 UTC
+    int32_t latUdeg;    // micro-degrees, negative south
+    int32_t lonUdeg;    // micro-degrees, negative west
+    float elv;          // meters above mean sea level
+    float speed;        // km/h
+    float direction;    // degrees true
+    uint8_t sig;        // nmeaINFO::sig
+    uint8_t fix;        // nmeaINFO::fix
+    uint8_t satinuse;
+    uint8_t satinview;
+
+    static FixRecord fromFix(const LocationFix& fix);
+    LocationFix toFix() const;
+};
+
+struct FixStreamHeader
+{
+    static const uint32_t kVersion = 1;
+
+    char magic[8];       // "NMEAFIX\0"
+    uint32_t version;    // reads as 0x01000000 on a host of the other byte order
+    uint32_t recordSize; // sizeof(FixRecord)
+
+    static FixStreamHeader current();
+    bool valid() const;
+};
+
+static_assert(sizeof(FixRecord) == 32, "FixRecord layout changed");
+static_assert(sizeof(FixStreamHeader) == 16, "FixStreamHeader layout changed");
+
+#endif // FIXRECORD_H
@@ -0,0 +1,100 @@
+// FixRecordReader.cpp
+
+#include "FixRecordReader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+FixRecordReader::FixRecordReader(int fd)
+    : fd(fd), headerRead(false), partialSize(0), records(0)
+{
+}
+
+ssize_t FixRecordReader::read(FixRecord* array, size_t max)
+{
+    if (max == 0)
+    {
+        return 0;
+    }
+    if (!headerRead)
+    {
+        const int status = readHeader();
+        if (status <= 0)
+        {
+            return status;
+        }
+    }
+
+    char* bytes = reinterpret_cast<char*>(array);
+    const size_t capacity = max * sizeof(FixRecord);
+    size_t used = partialSize;
+    memcpy(bytes, partial, partialSize);
+
+    while (used < sizeof(FixRecord))
+    {
+        ssize_t nread = ::read(fd, bytes + used, capacity - used);
+        if (nread < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (nread < 0)
+        {
+            partialSize = used;
+            memcpy(partial, bytes, used);
+            return -1;
+        }
+        if (nread == 0)
+        {
+            // A record cut by the end of stream is dropped
+            partialSize = 0;
+            return 0;
+        }
+        used += nread;
+    }
+
+    const size_t count = used / sizeof(FixRecord);
+    partialSize = used % sizeof(FixRecord);
+    memcpy(partial, bytes + count * sizeof(FixRecord), partialSize);
+    records += count;
+    return static_cast<ssize_t>(count);
+}
+
+unsigned long long FixRecordReader::recordCount() const
+{
+    return records;
+}
+
+// 1 once a valid header was read, 0 at end of an empty stream, -1 otherwise
+int FixRecordReader::readHeader()
+{
+    FixStreamHeader header;
+    char* bytes = reinterpret_cast<char*>(&header);
+    size_t used = 0;
+
+    while (used < sizeof(header))
+    {
+        ssize_t nread = ::read(fd, bytes + used, sizeof(header) - used);
+        if (nread < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (nread == 0 && used == 0)
+        {
+            return 0;
+        }
+        if (nread <= 0)
+        {
+            return -1;
+        }
+        used += nread;
+    }
+
+    headerRead = header.valid();
+    if (!headerRead)
+    {
+        errno = EPROTO;
+        return -1;
+    }
+    return 1;
+}
@@ -0,0 +1,31 @@
+#ifndef FIXRECORDREADER_H
+#define FIXRECORDREADER_H
+#include <cstddef>
+#include <sys/types.h>
+
+#include "FixRecord.h"
+
+// Consumer side of a FixRecordWriter stream on a blocking fd. Checks the
+// stream header, then reads records straight into the array of the
+// caller; a record split across reads is carried over to the next call.
+class FixRecordReader
+{
+public:
+    explicit FixRecordReader(int fd);
+
+    // Blocks until at least one record and returns the number read,
+    // 0 at end of stream, -1 on read error or a stream that is not a fix record stream
+    ssize_t read(FixRecord* records, size_t max);
+    unsigned long long recordCount() const;
+
+private:
+    int readHeader();
+
+    int fd;
+    bool headerRead;
+    size_t partialSize;
+    char partial[sizeof(FixRecord)];
+    unsigned long long records;
+};
+
+#endif // FIXRECORDREADER_H
@@ -0,0 +1,201 @@
+// FixRecordWriter.cpp
+
+#include "FixRecordWriter.h"
+#include "Timing.h"
+
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+FixRecordWriter::FixRecordWriter(int fd, size_t batchRecords, long flushIntervalMs)
+    : fd(fd), batchRecords(batchRecords), flushIntervalMs(flushIntervalMs), headerWritten(false),
+      broken(false), streamBytes(0), firstPendingMs(0), writes(0), records(0), dropped(0)
+{
+    batch.reserve(batchRecords);
+}
+
+FixRecordWriter::~FixRecordWriter()
+{
+    flush();
+}
+
+void FixRecordWriter::append(const LocationFix& fix)
+{
+    append(FixRecord::fromFix(fix));
+}
+
+void FixRecordWriter::append(const FixRecord& record)
+{
+    if (batch.empty())
+    {
+        firstPendingMs = monotonicMs();
+    }
+    batch.push_back(record);
+    if (batch.size() >= batchRecords)
+    {
+        flush();
+    }
+}
+
+void FixRecordWriter::write(const FixRecord* array, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    FixStreamHeader header = FixStreamHeader::current();
+    struct iovec iov[3];
+    int iovcnt = 0;
+    if (!headerWritten)
+    {
+        iov[iovcnt].iov_base = &header;
+        iov[iovcnt++].iov_len = sizeof(header);
+    }
+    if (!batch.empty())
+    {
+        iov[iovcnt].iov_base = batch.data();
+        iov[iovcnt++].iov_len = batch.size() * sizeof(FixRecord);
+    }
+    iov[iovcnt].iov_base = const_cast<FixRecord*>(array);
+    iov[iovcnt++].iov_len = count * sizeof(FixRecord);
+
+    writeAll(iov, iovcnt, batch.size() + count);
+}
+
+void FixRecordWriter::poll()
+{
+    if (!batch.empty() && flushTimeout() == 0)
+    {
+        flush();
+    }
+}
+
+void FixRecordWriter::flush()
+{
+    if (batch.empty())
+    {
+        return;
+    }
+
+    FixStreamHeader header = FixStreamHeader::current();
+    struct iovec iov[2];
+    int iovcnt = 0;
+    if (!headerWritten)
+    {
+        iov[iovcnt].iov_base = &header;
+        iov[iovcnt++].iov_len = sizeof(header);
+    }
+    iov[iovcnt].iov_base = batch.data();
+    iov[iovcnt++].iov_len = batch.size() * sizeof(FixRecord);
+
+    writeAll(iov, iovcnt, batch.size());
+}
+
+size_t FixRecordWriter::pending() const
+{
+    return batch.size();
+}
+
+long FixRecordWriter::flushTimeout() const
+{
+    if (batch.empty())
+    {
+        return -1;
+    }
+    long long left = firstPendingMs + flushIntervalMs - monotonicMs();
+    return left > 0 ? static_cast<long>(left) : 0;
+}
+
+unsigned long long FixRecordWriter::writeCount() const
+{
+    return writes;
+}
+
+unsigned long long FixRecordWriter::recordCount() const
+{
+    return records;
+}
+
+unsigned long long FixRecordWriter::droppedCount() const
+{
+    return dropped;
+}
+
+bool FixRecordWriter::isBroken() const
+{
+    return broken;
+}
+
+// Nothing or whole header and records went out so far
+bool FixRecordWriter::atRecordBoundary() const
+{
+    return streamBytes == 0 ||
+           (streamBytes >= sizeof(FixStreamHeader) && (streamBytes - sizeof(FixStreamHeader)) % sizeof(FixRecord) == 0);
+}
+
+// Whole records in the stream so far, a cut one is not counted
+unsigned long long FixRecordWriter::streamRecords() const
+{
+    if (streamBytes < sizeof(FixStreamHeader))
+    {
+        return 0;
+    }
+    return (streamBytes - sizeof(FixStreamHeader)) / sizeof(FixRecord);
+}
+
+// Writes every iovec carrying count records, the header is sent once and the batch is emptied
+void FixRecordWriter::writeAll(struct iovec* iov, int iovcnt, size_t count)
+{
+    unsigned long long before = streamRecords();
+    while (iovcnt > 0 && !broken)
+    {
+        ssize_t nwritten = writev(fd, iov, iovcnt);
+        if (nwritten < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (nwritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            if (atRecordBoundary())
+            {
+                // Consumer is behind, the rest of the batch is dropped rather than blocking the parser
+                break;
+            }
+            // A cut record would shift every following one for the reader, its rest is waited for
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            if (::poll(&pfd, 1, kRecordWaitMs) > 0 || errno == EINTR)
+            {
+                continue;
+            }
+            broken = true;
+            break;
+        }
+        if (nwritten <= 0)
+        {
+            // Reader closed the stream or the descriptor failed
+            broken = true;
+            break;
+        }
+        writes++;
+        streamBytes += static_cast<unsigned long long>(nwritten);
+
+        size_t done = static_cast<size_t>(nwritten);
+        while (iovcnt > 0 && done >= iov->iov_len)
+        {
+            done -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0)
+        {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+            iov->iov_len -= done;
+        }
+    }
+    unsigned long long written = streamRecords() - before;
+    records += written;
+    dropped += count - written;
+    headerWritten = streamBytes > 0;
+    batch.clear();
+}
@@ -0,0 +1,67 @@
+#ifndef FIXRECORDWRITER_H
+#define FIXRECORDWRITER_H
+#include <cstddef>
+#include <sys/uio.h>
+#include <vector>
+
+#include "FixRecord.h"
+
+// Streams binary fix records to a pipe, file or socket. Records are
+// batched like OutputBuffer batches text and written with writev, which
+// also puts the stream header in front of the first batch and sends
+// arrays of the caller without copying them into the batch first.
+// Records a full non-blocking descriptor does not take are dropped whole:
+// a record cut by a short write is finished first, so the reader never
+// loses alignment. After a write error the stream is broken and nothing
+// more is written.
+class FixRecordWriter
+{
+public:
+    static const size_t kDefaultBatchRecords = 256;
+    static const long kDefaultFlushIntervalMs = 100;
+    // Longest wait for a full descriptor to take the rest of a cut record
+    static const int kRecordWaitMs = 1000;
+
+    explicit FixRecordWriter(int fd, size_t batchRecords = kDefaultBatchRecords,
+                             long flushIntervalMs = kDefaultFlushIntervalMs);
+    ~FixRecordWriter();
+
+    void append(const LocationFix& fix);
+    void append(const FixRecord& record);
+    // Written at once together with pending records
+    void write(const FixRecord* records, size_t count);
+    // Flushes if one of thresholds is reached
+    void poll();
+    void flush();
+
+    size_t pending() const;
+    // Milliseconds until the time threshold of pending records, -1 when nothing is pending
+    long flushTimeout() const;
+    unsigned long long writeCount() const;
+    // Records that reached the descriptor whole
+    unsigned long long recordCount() const;
+    // Records given to the writer but never written: dropped by a full
+    // non-blocking descriptor, cut, or pending when the stream broke
+    unsigned long long droppedCount() const;
+    // True after a write error or a record that could not be finished
+    bool isBroken() const;
+
+private:
+    void writeAll(struct iovec* iov, int iovcnt, size_t count);
+    bool atRecordBoundary() const;
+    unsigned long long streamRecords() const;
+
+    int fd;
+    size_t batchRecords;
+    long flushIntervalMs;
+    bool headerWritten;
+    bool broken;
+    unsigned long long streamBytes;
+    std::vector<FixRecord> batch;
+    long long firstPendingMs;
+    unsigned long long writes;
+    unsigned long long records;
+    unsigned long long dropped;
+};
+
+#endif // FIXRECORDWRITER_H
@@ -0,0 +1,125 @@
+// FixSnapshot.cpp
+
+#include "FixSnapshot.h"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FixSnapshot::FixSnapshot()
+    : segment(&local), writable(true)
+{
+}
+
+FixSnapshot::~FixSnapshot()
+{
+    unmapShared();
+}
+
+bool FixSnapshot::createShared(const std::string& name)
+{
+    return mapShared(name, true);
+}
+
+bool FixSnapshot::openShared(const std::string& name)
+{
+    return mapShared(name, false);
+}
+
+bool FixSnapshot::removeShared(const std::string& name)
+{
+    return shm_unlink(name.c_str()) == 0;
+}
+
+void FixSnapshot::publish(const LocationFix& fix)
+{
+    if (writable)
+    {
+        segment->fix.store(fix);
+    }
+}
+
+bool FixSnapshot::read(LocationFix& fix) const
+{
+    return segment->fix.load(fix);
+}
+
+uint64_t FixSnapshot::sequence() const
+{
+    return segment->fix.sequence();
+}
+
+bool FixSnapshot::shared() const
+{
+    return segment != &local;
+}
+
+bool FixSnapshot::mapShared(const std::string& name, bool create)
+{
+    int fd = create ? shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)
+                    : shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        perror(name.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (create && st.st_size != static_cast<off_t>(sizeof(Segment)) &&
+                               ftruncate(fd, sizeof(Segment)) < 0))
+    {
+        perror(name.c_str());
+        close(fd);
+        return false;
+    }
+    if (!create && st.st_size < static_cast<off_t>(sizeof(Segment)))
+    {
+        fprintf(stderr, "%s: not a fix snapshot segment\n", name.c_str());
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(NULL, sizeof(Segment), create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        perror(name.c_str());
+        return false;
+    }
+
+    Segment* mapped = static_cast<Segment*>(mapping);
+    if (create)
+    {
+        // A segment left by an earlier run keeps its last fix for readers still attached
+        if (mapped->magic.load(std::memory_order_acquire) != Segment::kMagic ||
+            mapped->fixSize != sizeof(LocationFix))
+        {
+            new (mapped) Segment();
+        }
+    }
+    else if (mapped->magic.load(std::memory_order_acquire) != Segment::kMagic ||
+             mapped->fixSize != sizeof(LocationFix))
+    {
+        fprintf(stderr, "%s: not a fix snapshot segment\n", name.c_str());
+        munmap(mapping, sizeof(Segment));
+        return false;
+    }
+
+    unmapShared();
+    segment = mapped;
+    writable = create;
+    return true;
+}
+
+void FixSnapshot::unmapShared()
+{
+    if (shared())
+    {
+        munmap(segment, sizeof(Segment));
+        segment = &local;
+        writable = true;
+    }
+}
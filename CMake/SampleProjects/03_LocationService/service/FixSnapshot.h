@@ -0,0 +1,58 @@
+#ifndef FIXSNAPSHOT_H
+#define FIXSNAPSHOT_H
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "LocationFix.h"
+#include "Seqlock.h"
+
+// Latest published fix. Lives in process memory, or in a POSIX shared
+// memory segment (shm_open name such as "/locationservice") so other
+// processes on the host read the position straight from the mapping.
+// One thread publishes, readers never block it.
+class FixSnapshot
+{
+public:
+    FixSnapshot();
+    ~FixSnapshot();
+
+    FixSnapshot(const FixSnapshot&) = delete;
+    FixSnapshot& operator=(const FixSnapshot&) = delete;
+
+    // Publisher side: moves the snapshot into a new or reused segment
+    bool createShared(const std::string& name);
+    // Reader side: maps the segment another process created, read only
+    bool openShared(const std::string& name);
+    // Removes the segment name, mappings stay valid
+    static bool removeShared(const std::string& name);
+
+    // Ignored on a snapshot opened with openShared
+    void publish(const LocationFix& fix);
+    // False until the first fix is published
+    bool read(LocationFix& fix) const;
+    // Number of fixes published so far
+    uint64_t sequence() const;
+    bool shared() const;
+
+private:
+    struct Segment
+    {
+        static const uint32_t kMagic = 0x4e4d4542; // "NMEB", slots carry their version
+
+        Segment() : magic(kMagic), fixSize(sizeof(LocationFix)) {}
+
+        std::atomic<uint32_t> magic;
+        uint32_t fixSize;
+        Seqlock<LocationFix> fix;
+    };
+
+    bool mapShared(const std::string& name, bool create);
+    void unmapShared();
+
+    Segment local;
+    Segment* segment;
+    bool writable;
+};
+
+#endif // FIXSNAPSHOT_H
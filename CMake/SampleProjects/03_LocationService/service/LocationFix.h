@@ -0,0 +1,22 @@
+#ifndef LOCATIONFIX_H
+#define LOCATIONFIX_H
+
+#include "nmea.h"
+
+// One completed epoch of a receiver as handed to publishers
+struct LocationFix
+{
+    long long utcUs;    // microseconds since 1970-01-01 UTC (nmeaINFO::utc_us)
+    double lat;         // degrees, negative south
+    double lon;         // degrees, negative west
+    double elv;         // meters above mean sea level
+    double speed;       // km/h
+    double direction;   // degrees true
+    int sig;            // nmeaINFO::sig
+    int fix;            // nmeaINFO::fix
+    int satinuse;
+    int satinview;
+    long long ingestNs; // monotonic time the bytes completing the epoch arrived, 0 if unknown
+};
+
+#endif // LOCATIONFIX_H
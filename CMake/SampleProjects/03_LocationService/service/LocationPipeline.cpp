@@ -0,0 +1,168 @@
+// LocationPipeline.cpp
+
+#include "LocationPipeline.h"
+#include "Timing.h"
+
+#include <algorithm>
+
+LocationPipeline::LocationPipeline(OutputBuffer& output, size_t rawCapacity, size_t fixCapacity, Overflow overflow)
+    : output(output), overflow(overflow), rawRing(rawCapacity), fixRing(fixCapacity), currentIngestNs(0),
+      stopping(false), parseDone(false), rawChunks(0), rawStalls(0), rawDroppedBytes(0),
+      fixes(0), fixDrops(0), published(0)
+{
+    // Parse stage only forwards fixes, publishers see them on their own thread
+    service.setFixHandler([this](const LocationFix& fix) {
+        LocationFix* slot = fixRing.acquire();
+        fixes.fetch_add(1, std::memory_order_relaxed);
+        if (slot == NULL)
+        {
+            fixDrops.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        *slot = fix;
+        slot->ingestNs = currentIngestNs;
+        fixRing.publish();
+    });
+
+    parseThread = std::thread(&LocationPipeline::parseStage, this);
+    publishThread = std::thread(&LocationPipeline::publishStage, this);
+}
+
+LocationPipeline::~LocationPipeline()
+{
+    stop();
+}
+
+void LocationPipeline::setFixHandler(LocationService::FixHandler handler)
+{
+    publishHandler = handler;
+}
+
+void LocationPipeline::setEpochMask(int mask)
+{
+    service.setEpochMask(mask);
+}
+
+size_t LocationPipeline::submit(const char* data, size_t size)
+{
+    const long long ingestNs = monotonicNs();
+    size_t accepted = 0;
+    bool stalled = false;
+    unsigned idle = 0;
+
+    while (accepted < size)
+    {
+        RawChunk* chunk = rawRing.acquire();
+        if (chunk == NULL)
+        {
+            if (!stalled)
+            {
+                rawStalls.fetch_add(1, std::memory_order_relaxed);
+                stalled = true;
+            }
+            if (overflow == kDrop)
+            {
+                rawDroppedBytes.fetch_add(size - accepted, std::memory_order_relaxed);
+                break;
+            }
+            backoff(idle);
+            continue;
+        }
+
+        const size_t part = std::min(size - accepted, kRawChunkSize);
+        memcpy(chunk->data, data + accepted, part);
+        chunk->size = static_cast<long long>(part);
+        chunk->ingestNs = ingestNs;
+        rawRing.publish();
+        rawChunks.fetch_add(1, std::memory_order_relaxed);
+        accepted += part;
+        idle = 0;
+    }
+
+    return accepted;
+}
+
+void LocationPipeline::stop()
+{
+    if (stopping.exchange(true))
+    {
+        return;
+    }
+    parseThread.join();
+    publishThread.join();
+    output.flush();
+}
+
+LocationPipeline::Stats LocationPipeline::stats() const
+{
+    Stats result;
+    result.rawChunks = rawChunks.load(std::memory_order_relaxed);
+    result.rawStalls = rawStalls.load(std::memory_order_relaxed);
+    result.rawDroppedBytes = rawDroppedBytes.load(std::memory_order_relaxed);
+    result.fixes = fixes.load(std::memory_order_relaxed);
+    result.fixDrops = fixDrops.load(std::memory_order_relaxed);
+    result.published = published.load(std::memory_order_relaxed);
+    return result;
+}
+
+void LocationPipeline::parseStage()
+{
+    unsigned idle = 0;
+
+    for (;;)
+    {
+        RawChunk* chunk = rawRing.front();
+        if (chunk == NULL)
+        {
+            // Stop is seen only after the ring was found empty, so nothing submitted before it is lost
+            if (stopping.load(std::memory_order_acquire) && rawRing.front() == NULL)
+            {
+                break;
+            }
+            backoff(idle);
+            continue;
+        }
+
+        currentIngestNs = chunk->ingestNs;
+        service.parseNMEAMessage(chunk->data, static_cast<size_t>(chunk->size));
+        rawRing.release();
+        idle = 0;
+    }
+
+    // Whatever arrived of the last epoch is reported
+    service.finishEpoch();
+    parseDone.store(true, std::memory_order_release);
+}
+
+void LocationPipeline::publishStage()
+{
+    unsigned idle = 0;
+    char report[128];
+
+    for (;;)
+    {
+        LocationFix* fix = fixRing.front();
+        if (fix == NULL)
+        {
+            if (parseDone.load(std::memory_order_acquire) && fixRing.front() == NULL)
+            {
+                break;
+            }
+            output.poll();
+            backoff(idle);
+            continue;
+        }
+
+        if (publishHandler)
+        {
+            publishHandler(*fix);
+        }
+        else
+        {
+            output.append(report, LocationService::formatFix(*fix, report, sizeof(report)));
+        }
+        fixRing.release();
+        published.fetch_add(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
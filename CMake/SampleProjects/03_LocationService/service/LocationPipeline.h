@@ -0,0 +1,86 @@
+#ifndef LOCATIONPIPELINE_H
+#define LOCATIONPIPELINE_H
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+#include "LocationService.h"
+#include "OutputBuffer.h"
+#include "SpscRing.h"
+
+// LocationService split into three stages so a slow consumer never stalls
+// reading from the receiver:
+//   I/O (caller of submit) -> raw byte ring -> parse thread -> fix ring -> publish thread
+// The raw ring applies backpressure to the I/O stage (or drops chunks in
+// Drop mode), the fix ring drops fixes when publishers fall behind, so the
+// parse stage keeps its pace. Every drop and stall is counted.
+// Part of the locationservice library for embedders with a single source.
+// The LocationService daemon does not use it: its EventLoop serves many
+// sources, signals, epoch timers and the record writer from one thread.
+class LocationPipeline
+{
+public:
+    enum Overflow
+    {
+        kBlock, // submit waits for free slots
+        kDrop   // submit drops what does not fit
+    };
+
+    struct Stats
+    {
+        unsigned long long rawChunks;
+        unsigned long long rawStalls;      // submit found the raw ring full
+        unsigned long long rawDroppedBytes;
+        unsigned long long fixes;          // fixes completed by the parse stage
+        unsigned long long fixDrops;       // fixes lost because the fix ring was full
+        unsigned long long published;
+    };
+
+    static constexpr size_t kRawChunkSize = 4096 - 2 * sizeof(long long);
+
+    explicit LocationPipeline(OutputBuffer& output = OutputBuffer::standardOutput(),
+                              size_t rawCapacity = 256, size_t fixCapacity = 1024, Overflow overflow = kBlock);
+    ~LocationPipeline();
+
+    // Publish stage handler, runs on the publish thread (text report to output by default).
+    // Both threads read their settings without synchronization: setFixHandler and
+    // setEpochMask must be called before the first submit.
+    void setFixHandler(LocationService::FixHandler handler);
+    void setEpochMask(int mask);
+
+    // I/O stage, copies bytes into the raw ring. Returns bytes accepted, less than size only in Drop mode.
+    size_t submit(const char* data, size_t size);
+    // Parses and publishes everything submitted so far, then stops both threads
+    void stop();
+
+    Stats stats() const;
+
+private:
+    struct RawChunk
+    {
+        long long ingestNs;
+        long long size;
+        char data[kRawChunkSize];
+    };
+
+    void parseStage();
+    void publishStage();
+
+    OutputBuffer& output;
+    Overflow overflow;
+    LocationService service;
+    LocationService::FixHandler publishHandler;
+    SpscRing<RawChunk> rawRing;
+    SpscRing<LocationFix> fixRing;
+    long long currentIngestNs;
+
+    alignas(64) std::atomic<bool> stopping;
+    std::atomic<bool> parseDone;
+    std::atomic<unsigned long long> rawChunks, rawStalls, rawDroppedBytes;
+    std::atomic<unsigned long long> fixes, fixDrops, published;
+
+    std::thread parseThread;
+    std::thread publishThread;
+};
+
+#endif // LOCATIONPIPELINE_H
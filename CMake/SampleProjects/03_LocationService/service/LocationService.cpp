@@ -1,12 +1,17 @@
 // LocationService.cpp
 
 #include "LocationService.h"
+#include "Timing.h"
 
 #include "nmea.h"
 
+#include <algorithm>
+#include <climits>
+
 LocationService::LocationService()
+    : output(&OutputBuffer::standardOutput()), recordWriter(NULL), fixes(0), snapshot(&ownSnapshot)
 {
-    nmea_zero_INFO(&info);
+    nmea_epoch_init(&epoch, NMEA_DEF_EPOCH_MASK, NMEA_DEF_EPOCH_TIMEOUT);
     nmea_parser_init(&parser);
 }
 
@@ -15,23 +20,140 @@ LocationService::~LocationService()
     nmea_parser_destroy(&parser);
 }
 
-void LocationService::parseNMEAMessage(const std::string& message)
+void LocationService::parseNMEAMessage(std::string_view message)
+{
+    parseNMEAMessage(message.data(), message.size());
+}
+
+void LocationService::parseNMEAMessage(const char* message, size_t size)
+{
+    int nparse, ptype;
+    void *pack = NULL;
+    // One clock read per call, epoch timeouts need no finer resolution
+    const long long nowMs = monotonicMs();
+
+    while (size > 0)
+    {
+        nparse = nmea_parser_real_push(&parser, message, size > INT_MAX ? INT_MAX : static_cast<int>(size));
+        message += nparse;
+        size -= nparse;
+
+        while ((ptype = nmea_parser_pop(&parser, &pack)) != GPNON)
+        {
+            if (nmea_epoch_push(&epoch, ptype, pack, nowMs))
+            {
+                reportEpochs();
+            }
+        }
+    }
+}
+
+void LocationService::setOutput(OutputBuffer* output)
+{
+    this->output = output;
+}
+
+void LocationService::setRecordWriter(FixRecordWriter* writer)
 {
-    // nmea_parse(&parser, message.c_str(), message.length(), &info);
+    recordWriter = writer;
+}
 
-    const char *buff[] = {
-        "$GPRMC,173843,A,3349.896,N,11808.521,W,000.0,360.0,230108,013.4,E*69\r\n",
-        "$GPGGA,111609.14,5001.27,N,3613.06,E,3,08,0.0,10.2,M,0.0,M,0.0,0000*70\r\n",
-        "$GPGSV,2,1,08,01,05,005,80,02,05,050,80,03,05,095,80,04,05,140,80*7f\r\n",
-        "$GPGSV,2,2,08,05,05,185,80,06,05,230,80,07,05,275,80,08,05,320,80*71\r\n",
-        "$GPGSA,A,3,01,02,03,04,05,06,07,08,00,00,00,00,0.0,0.0,0.0*3a\r\n",
-        "$GPRMC,111609.14,A,5001.27,N,3613.06,E,11.2,0.0,261206,0.0,E*50\r\n",
-        "$GPVTG,217.5,T,208.8,M,000.00,N,000.01,K*4C\r\n"
-    };
+void LocationService::setFixHandler(FixHandler handler)
+{
+    fixHandler = handler;
+}
 
-    int it;
-    for(it = 0; it < 6; ++it)
-        nmea_parse(&parser, buff[it], (int)strlen(buff[it]), &info);
+void LocationService::setEpochMask(int mask)
+{
+    epoch.require = mask > 0 ? mask : NMEA_DEF_EPOCH_MASK;
+}
+
+void LocationService::setEpochTimeout(int timeoutMs)
+{
+    epoch.timeout = std::max(timeoutMs, 0);
+}
+
+bool LocationService::pollEpoch()
+{
+    if (nmea_epoch_poll(&epoch, monotonicMs()))
+    {
+        reportEpochs();
+    }
+    return nmea_epoch_pending(&epoch) != 0;
+}
+
+void LocationService::finishEpoch()
+{
+    if (nmea_epoch_flush(&epoch))
+    {
+        reportEpochs();
+    }
+}
+
+void LocationService::setSnapshot(FixSnapshot* snapshot)
+{
+    this->snapshot = snapshot ? snapshot : &ownSnapshot;
+}
+
+bool LocationService::getLatestFix(LocationFix& fix) const
+{
+    return snapshot->read(fix);
+}
+
+unsigned long long LocationService::fixCount() const
+{
+    return fixes;
+}
+
+size_t LocationService::formatFix(const LocationFix& fix, char* text, size_t size)
+{
+    int nwritten = snprintf(text, size, "lat: %g lon: %g alt: %g\n", fix.lat, fix.lon, fix.elv);
+    return nwritten < 0 ? 0 : std::min(static_cast<size_t>(nwritten), size - 1);
+}
+
+// Epochs without position (e.g. only GSV) are not reported
+void LocationService::reportEpochs()
+{
+    const nmeaINFO *info;
+    while ((info = nmea_epoch_pop(&epoch)) != NULL)
+    {
+        if (info->smask & (GPGGA | GPRMC))
+        {
+            reportFix(*info);
+        }
+    }
+}
+
+void LocationService::reportFix(const nmeaINFO& info)
+{
+    LocationFix fix;
+    fix.utcUs = info.utc_us;
+    fix.lat = nmea_fast_ndeg2degree(info.lat);
+    fix.lon = nmea_fast_ndeg2degree(info.lon);
+    fix.elv = info.elv;
+    fix.speed = info.speed;
+    fix.direction = info.direction;
+    fix.sig = info.sig;
+    fix.fix = info.fix;
+    fix.satinuse = info.satinfo.inuse;
+    fix.satinview = info.satinfo.inview;
+    fix.ingestNs = 0;
+    fixes++;
+    NMEA_STATS_START(start, NMEA_STAGE_OUTPUT);
+    snapshot->publish(fix);
 
-    std::cout << "lat: " << nmea_ndeg2degree(info.lat) << " lon: " << nmea_ndeg2degree(info.lon) << " alt: " << info.elv << std::endl;
+    if (fixHandler)
+    {
+        fixHandler(fix);
+    }
+    else if (recordWriter)
+    {
+        recordWriter->append(fix);
+    }
+    else
+    {
+        char report[128];
+        output->append(report, formatFix(fix, report, sizeof(report)));
+    }
+    NMEA_STATS_STOP(NMEA_STAGE_OUTPUT, start);
 }
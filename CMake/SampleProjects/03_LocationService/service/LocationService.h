@@ -5,21 +5,65 @@
 #include <sys/types.h>
 #include <signal.h>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <string>
+#include <string_view>
 
 #include "nmea.h"
+#include "FixRecordWriter.h"
+#include "FixSnapshot.h"
+#include "LocationFix.h"
+#include "OutputBuffer.h"
 
 class LocationService
 {
 public:
+    typedef std::function<void(const LocationFix&)> FixHandler;
+
     LocationService();
     ~LocationService();
-    void parseNMEAMessage(const std::string& message);
+    // Bytes are fed incrementally, sentences may be split across calls
+    void parseNMEAMessage(std::string_view message);
+    void parseNMEAMessage(const char* message, size_t size);
+    // Fix reports go to the shared standard output buffer unless redirected
+    void setOutput(OutputBuffer* output);
+    // Fix reports are binary records to writer instead of text (NULL: back to text)
+    void setRecordWriter(FixRecordWriter* writer);
+    // Completed fixes go to the handler instead of the text output
+    void setFixHandler(FixHandler handler);
+    // Sentences of one receiver epoch (same UTC time) make one fix, reported when the next
+    // epoch starts. With a mask it is reported as soon as every packet of the mask arrived;
+    // the mask must list every sentence of the receiver, later ones are counted and dropped.
+    void setEpochMask(int mask);
+    // Epoch is reported after timeoutMs (0 never) when no next epoch started, checked on input and by pollEpoch()
+    void setEpochTimeout(int timeoutMs);
+    // Reports the current epoch when its timeout expired, true while an epoch is incomplete
+    bool pollEpoch();
+    // Reports the current epoch even if incomplete, at the end of input
+    void finishEpoch();
+    // Every fix is also published to a snapshot, the service's own one unless replaced
+    // (e.g. by a shared memory snapshot). The parsing thread is its only writer.
+    void setSnapshot(FixSnapshot* snapshot);
+    // Latest published fix, wait-free and callable from any thread
+    bool getLatestFix(LocationFix& fix) const;
+    unsigned long long fixCount() const;
+
+    // Text report of fix ("lat: ... lon: ... alt: ...\n"), returns its size
+    static size_t formatFix(const LocationFix& fix, char* text, size_t size);
 
 private:
+    void reportEpochs();
+    void reportFix(const nmeaINFO& info);
+
     pid_t daemonPid;
-    nmeaINFO info;
+    OutputBuffer* output;
+    FixRecordWriter* recordWriter;
+    FixHandler fixHandler;
+    unsigned long long fixes;
+    FixSnapshot ownSnapshot;
+    FixSnapshot* snapshot;
+    nmeaEPOCH epoch;
     nmeaPARSER parser;
 };
 
@@ -0,0 +1,224 @@
+// LocationServicePool.cpp
+
+#include "LocationServicePool.h"
+#include "Timing.h"
+
+#include <algorithm>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+// Device IDs are often sequential, mix them before taking the worker
+static uint64_t mixDeviceId(uint64_t id)
+{
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    id *= 0xc4ceb9fe1a85ec53ULL;
+    id ^= id >> 33;
+    return id;
+}
+
+LocationServicePool::LocationServicePool(size_t workerCount, bool pinned, size_t queueCapacity)
+    : epochMask(NMEA_DEF_EPOCH_MASK), stopping(false), stalls(0)
+{
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    workerCount = std::max<size_t>(workerCount, 1);
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back(new Worker(queueCapacity));
+    }
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        workers[i]->thread = std::thread(&LocationServicePool::run, this, i);
+        if (pinned && cpus > 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(i % cpus, &set);
+            pthread_setaffinity_np(workers[i]->thread.native_handle(), sizeof(set), &set);
+        }
+    }
+}
+
+LocationServicePool::~LocationServicePool()
+{
+    stop();
+}
+
+void LocationServicePool::setFixHandler(FixHandler handler)
+{
+    fixHandler = handler;
+}
+
+void LocationServicePool::setEpochMask(int mask)
+{
+    epochMask = mask;
+}
+
+size_t LocationServicePool::workerCount() const
+{
+    return workers.size();
+}
+
+size_t LocationServicePool::workerOf(uint64_t deviceId) const
+{
+    return static_cast<size_t>(mixDeviceId(deviceId) % workers.size());
+}
+
+void LocationServicePool::submit(uint64_t deviceId, const char* data, size_t size)
+{
+    Worker& worker = *workers[workerOf(deviceId)];
+    const long long ingestNs = monotonicNs();
+    bool stalled = false;
+    unsigned idle = 0;
+
+    while (size > 0)
+    {
+        Chunk* chunk = worker.queue.acquire();
+        if (chunk == NULL)
+        {
+            if (!stalled)
+            {
+                stalls.fetch_add(1, std::memory_order_relaxed);
+                stalled = true;
+            }
+            backoff(idle);
+            continue;
+        }
+
+        const size_t part = std::min(size, kChunkSize);
+        chunk->deviceId = deviceId;
+        chunk->ingestNs = ingestNs;
+        chunk->size = static_cast<long long>(part);
+        memcpy(chunk->data, data, part);
+        worker.queue.publish();
+
+        data += part;
+        size -= part;
+        idle = 0;
+    }
+}
+
+void LocationServicePool::stop()
+{
+    if (stopping.exchange(true))
+    {
+        return;
+    }
+    for (std::unique_ptr<Worker>& worker : workers)
+    {
+        worker->thread.join();
+    }
+}
+
+bool LocationServicePool::getFix(uint64_t deviceId, LocationFix& fix) const
+{
+    const Worker& worker = *workers[workerOf(deviceId)];
+    std::lock_guard<std::mutex> guard(worker.fixLock);
+
+    auto it = worker.devices.find(deviceId);
+    if (it == worker.devices.end() || !it->second->hasFix)
+    {
+        return false;
+    }
+    fix = it->second->latest;
+    return true;
+}
+
+void LocationServicePool::forEachFix(const std::function<void(uint64_t deviceId, const LocationFix& fix)>& visit) const
+{
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        std::lock_guard<std::mutex> guard(worker->fixLock);
+        for (const auto& entry : worker->devices)
+        {
+            if (entry.second->hasFix)
+            {
+                visit(entry.first, entry.second->latest);
+            }
+        }
+    }
+}
+
+LocationServicePool::Stats LocationServicePool::stats() const
+{
+    Stats result = {};
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        {
+            std::lock_guard<std::mutex> guard(worker->fixLock);
+            result.devices += worker->devices.size();
+        }
+        result.chunks += worker->chunks.load(std::memory_order_relaxed);
+        result.fixes += worker->fixes.load(std::memory_order_relaxed);
+    }
+    result.stalls = stalls.load(std::memory_order_relaxed);
+    return result;
+}
+
+LocationServicePool::Device& LocationServicePool::device(Worker& worker, size_t index, uint64_t deviceId)
+{
+    auto it = worker.devices.find(deviceId);
+    if (it != worker.devices.end())
+    {
+        return *it->second;
+    }
+
+    std::unique_ptr<Device> created(new Device);
+    Device* device = created.get();
+    device->hasFix = false;
+    device->service.setEpochMask(epochMask);
+    device->service.setFixHandler([this, &worker, index, device, deviceId](const LocationFix& fix) {
+        {
+            std::lock_guard<std::mutex> guard(worker.fixLock);
+            device->latest = fix;
+            device->latest.ingestNs = worker.currentIngestNs;
+            device->hasFix = true;
+        }
+        worker.fixes.fetch_add(1, std::memory_order_relaxed);
+        if (fixHandler)
+        {
+            fixHandler(index, deviceId, device->latest);
+        }
+    });
+
+    std::lock_guard<std::mutex> guard(worker.fixLock);
+    worker.devices[deviceId] = std::move(created);
+    return *device;
+}
+
+void LocationServicePool::run(size_t index)
+{
+    Worker& worker = *workers[index];
+    unsigned idle = 0;
+
+    for (;;)
+    {
+        Chunk* chunk = worker.queue.front();
+        if (chunk == NULL)
+        {
+            // Stop is seen only after the ring was found empty, so nothing submitted before it is lost
+            if (stopping.load(std::memory_order_acquire) && worker.queue.front() == NULL)
+            {
+                break;
+            }
+            backoff(idle);
+            continue;
+        }
+
+        Device& target = device(worker, index, chunk->deviceId);
+        worker.currentIngestNs = chunk->ingestNs;
+        target.service.parseNMEAMessage(chunk->data, static_cast<size_t>(chunk->size));
+        worker.queue.release();
+        worker.chunks.fetch_add(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+
+    // Whatever arrived of the last epoch of every device is reported, only this thread changes the map
+    for (auto& entry : worker.devices)
+    {
+        entry.second->service.finishEpoch();
+    }
+}
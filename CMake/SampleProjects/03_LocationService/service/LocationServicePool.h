@@ -0,0 +1,99 @@
+#ifndef LOCATIONSERVICEPOOL_H
+#define LOCATIONSERVICEPOOL_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "LocationFix.h"
+#include "LocationService.h"
+#include "SpscRing.h"
+
+// Many receivers served by N worker threads. A device ID is hashed to one
+// worker, which owns the LocationService (parser and nmeaINFO) and the
+// latest fix of every device it serves, so workers share no parser state
+// and no locks. Bytes reach a worker through its own SPSC ring from the one
+// I/O thread calling submit(). Queries take the lock of one worker only.
+// Part of the locationservice library. The LocationService daemon does not
+// use it, it serves its sources on one thread.
+class LocationServicePool
+{
+public:
+    // Runs on the worker thread that completed the fix
+    typedef std::function<void(size_t worker, uint64_t deviceId, const LocationFix& fix)> FixHandler;
+
+    struct Stats
+    {
+        size_t devices;
+        unsigned long long chunks;
+        unsigned long long stalls;  // submit found the ring of a worker full
+        unsigned long long fixes;
+    };
+
+    static constexpr size_t kChunkSize = 1024 - 3 * sizeof(long long);
+
+    explicit LocationServicePool(size_t workers, bool pinned = true, size_t queueCapacity = 1024);
+    ~LocationServicePool();
+
+    // Set before the first submit
+    void setFixHandler(FixHandler handler);
+    void setEpochMask(int mask);
+
+    // I/O thread only: queues bytes of device for its worker, waits while the worker is full
+    void submit(uint64_t deviceId, const char* data, size_t size);
+    // Processes everything submitted so far and stops the workers
+    void stop();
+
+    size_t workerCount() const;
+    size_t workerOf(uint64_t deviceId) const;
+
+    // Aggregated queries, callable from any thread
+    bool getFix(uint64_t deviceId, LocationFix& fix) const;
+    void forEachFix(const std::function<void(uint64_t deviceId, const LocationFix& fix)>& visit) const;
+    Stats stats() const;
+
+private:
+    struct Chunk
+    {
+        uint64_t deviceId;
+        long long ingestNs;
+        long long size;
+        char data[kChunkSize];
+    };
+
+    struct Device
+    {
+        LocationService service;
+        LocationFix latest;
+        bool hasFix;
+    };
+
+    struct Worker
+    {
+        explicit Worker(size_t queueCapacity) : queue(queueCapacity), currentIngestNs(0), chunks(0), fixes(0) {}
+
+        SpscRing<Chunk> queue;
+        long long currentIngestNs;
+        std::unordered_map<uint64_t, std::unique_ptr<Device>> devices;
+        mutable std::mutex fixLock; // guards latest fixes against queries only
+        std::atomic<unsigned long long> chunks;
+        std::atomic<unsigned long long> fixes;
+        std::thread thread;
+    };
+
+    void run(size_t index);
+    Device& device(Worker& worker, size_t index, uint64_t deviceId);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    FixHandler fixHandler;
+    int epochMask;
+    std::atomic<bool> stopping;
+    std::atomic<unsigned long long> stalls;
+};
+
+#endif // LOCATIONSERVICEPOOL_H
@@ -0,0 +1,92 @@
+// OutputBuffer.cpp
+
+#include "OutputBuffer.h"
+#include "Timing.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+OutputBuffer::OutputBuffer(int fd, size_t flushSize, long flushIntervalMs)
+    : fd(fd), flushSize(flushSize), flushIntervalMs(flushIntervalMs), firstPendingMs(0), writes(0)
+{
+    buffer.reserve(flushSize);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    flush();
+}
+
+OutputBuffer& OutputBuffer::standardOutput()
+{
+    static OutputBuffer output(STDOUT_FILENO);
+    return output;
+}
+
+void OutputBuffer::append(std::string_view text)
+{
+    append(text.data(), text.size());
+}
+
+void OutputBuffer::append(const char* text, size_t size)
+{
+    if (buffer.empty())
+    {
+        firstPendingMs = monotonicMs();
+    }
+    buffer.insert(buffer.end(), text, text + size);
+    if (buffer.size() >= flushSize)
+    {
+        flush();
+    }
+}
+
+void OutputBuffer::poll()
+{
+    if (!buffer.empty() && flushTimeout() == 0)
+    {
+        flush();
+    }
+}
+
+void OutputBuffer::flush()
+{
+    size_t done = 0;
+    while (done < buffer.size())
+    {
+        ssize_t nwritten = write(fd, buffer.data() + done, buffer.size() - done);
+        if (nwritten < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (nwritten <= 0)
+        {
+            // Reader went away, reports are dropped rather than blocking the parser
+            break;
+        }
+        done += nwritten;
+        writes++;
+    }
+    buffer.clear();
+}
+
+size_t OutputBuffer::pending() const
+{
+    return buffer.size();
+}
+
+long OutputBuffer::flushTimeout() const
+{
+    if (buffer.empty())
+    {
+        return -1;
+    }
+    long long left = firstPendingMs + flushIntervalMs - monotonicMs();
+    return left > 0 ? static_cast<long>(left) : 0;
+}
+
+unsigned long long OutputBuffer::writeCount() const
+{
+    return writes;
+}
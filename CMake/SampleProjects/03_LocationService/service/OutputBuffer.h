@@ -0,0 +1,42 @@
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Batches text reports into one write() per flush instead of a flush per line.
+// Pending bytes are written once the size threshold is reached or the oldest
+// pending byte is older than the time threshold.
+class OutputBuffer
+{
+public:
+    static const size_t kDefaultFlushSize = 64 * 1024;
+    static const long kDefaultFlushIntervalMs = 100;
+
+    explicit OutputBuffer(int fd, size_t flushSize = kDefaultFlushSize, long flushIntervalMs = kDefaultFlushIntervalMs);
+    ~OutputBuffer();
+
+    // Shared buffer of standard output used by default
+    static OutputBuffer& standardOutput();
+
+    void append(std::string_view text);
+    void append(const char* text, size_t size);
+    // Flushes if one of thresholds is reached
+    void poll();
+    void flush();
+
+    size_t pending() const;
+    // Milliseconds until the time threshold of pending bytes, -1 when nothing is pending
+    long flushTimeout() const;
+    unsigned long long writeCount() const;
+
+private:
+    int fd;
+    size_t flushSize;
+    long flushIntervalMs;
+    std::vector<char> buffer;
+    long long firstPendingMs;
+    unsigned long long writes;
+};
+
+#endif // OUTPUTBUFFER_H
@@ -0,0 +1,109 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Latest value of a trivially copyable T for one writer and any number of
+// readers. Two seqlock protected slots are written alternately and a
+// version names the last complete one, so a reader only retries when the
+// writer published twice during its copy; it never waits for a write in
+// progress. Each slot also carries the version it holds: a reader delayed
+// past two stores would otherwise copy a newer value than the version it
+// loaded and return an older one on its next load. Only lock-free atomics are used and all-zero memory is a valid
+// empty state, so the object may be placed in shared memory.
+template <typename T>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock value must be trivially copyable");
+
+public:
+    static const size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    Seqlock() : version(0)
+    {
+        for (Slot& slot : slots)
+        {
+            slot.seq.store(0, std::memory_order_relaxed);
+            slot.version.store(0, std::memory_order_relaxed);
+            for (std::atomic<uint64_t>& word : slot.words)
+            {
+                word.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Writer only
+    void store(const T& value)
+    {
+        uint64_t words[kWords] = {};
+        memcpy(words, &value, sizeof(T));
+
+        const uint64_t next = version.load(std::memory_order_relaxed) + 1;
+        Slot& slot = slots[next & 1];
+        const uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.version.store(next, std::memory_order_relaxed);
+        for (size_t i = 0; i < kWords; ++i)
+        {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.seq.store(seq + 2, std::memory_order_release);
+        version.store(next, std::memory_order_release);
+    }
+
+    // Any thread or process: false until the first store
+    bool load(T& value) const
+    {
+        uint64_t words[kWords];
+
+        for (;;)
+        {
+            const uint64_t current = version.load(std::memory_order_acquire);
+            if (current == 0)
+            {
+                return false;
+            }
+
+            const Slot& slot = slots[current & 1];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if ((seq & 1) == 0)
+            {
+                const uint64_t held = slot.version.load(std::memory_order_relaxed);
+                for (size_t i = 0; i < kWords; ++i)
+                {
+                    words[i] = slot.words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                // The slot may hold version current + 2 already, that one is returned after a retry
+                if (slot.seq.load(std::memory_order_relaxed) == seq && held == current)
+                {
+                    memcpy(&value, words, sizeof(T));
+                    return true;
+                }
+            }
+        }
+    }
+
+    // Number of values stored so far
+    uint64_t sequence() const
+    {
+        return version.load(std::memory_order_acquire);
+    }
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> version;
+        std::atomic<uint64_t> words[kWords];
+    };
+
+    alignas(64) std::atomic<uint64_t> version;
+    Slot slots[2];
+};
+
+#endif // SEQLOCK_H
@@ -0,0 +1,119 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free ring for exactly one producer and one consumer thread.
+// Slots are written and read in place (acquire/publish, front/release), so
+// large elements are never copied through the ring. Producer and consumer
+// indices live on separate cache lines, each side keeps a cached copy of
+// the other index and touches the shared one only when the cache says full
+// or empty.
+template <typename T>
+class SpscRing
+{
+public:
+    static const size_t kCacheLine = 64;
+
+    explicit SpscRing(size_t capacity)
+        : head(0), cachedTail(0), tail(0), cachedHead(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // Producer: free slot to fill or NULL when the ring is full
+    T* acquire()
+    {
+        const size_t current = head.load(std::memory_order_relaxed);
+        if (current - cachedTail == slots.size())
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (current - cachedTail == slots.size())
+            {
+                return NULL;
+            }
+        }
+        return &slots[current & mask];
+    }
+
+    // Producer: hands the acquired slot to the consumer
+    void publish()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: oldest published slot or NULL when the ring is empty
+    T* front()
+    {
+        const size_t current = tail.load(std::memory_order_relaxed);
+        if (current == cachedHead)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (current == cachedHead)
+            {
+                return NULL;
+            }
+        }
+        return &slots[current & mask];
+    }
+
+    // Consumer: gives the front slot back to the producer
+    void release()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool tryPush(const T& value)
+    {
+        T* slot = acquire();
+        if (slot == NULL)
+        {
+            return false;
+        }
+        *slot = value;
+        publish();
+        return true;
+    }
+
+    bool tryPop(T& value)
+    {
+        T* slot = front();
+        if (slot == NULL)
+        {
+            return false;
+        }
+        value = *slot;
+        release();
+        return true;
+    }
+
+    size_t capacity() const
+    {
+        return slots.size();
+    }
+
+    // Approximate when called concurrently with both sides
+    size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+
+    alignas(kCacheLine) std::atomic<size_t> head; // written by producer
+    size_t cachedTail;
+    alignas(kCacheLine) std::atomic<size_t> tail; // written by consumer
+    size_t cachedHead;
+    char padding[kCacheLine - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,44 @@
+#ifndef TIMING_H
+#define TIMING_H
+#include <ctime>
+#include <thread>
+
+// Coarse monotonic clock of flush intervals, epoch timeouts and stats
+// periods: a few milliseconds of resolution, no system call on Linux.
+inline long long monotonicMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Ingest timestamps of fix latency
+inline long long monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Spins first, then yields, then sleeps while a polling thread has nothing to do.
+// idle counts the empty polls in a row, the caller resets it after some work.
+inline void backoff(unsigned& idle)
+{
+    if (++idle < 64)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    else if (idle < 256)
+    {
+        std::this_thread::yield();
+    }
+    else
+    {
+        struct timespec ts = { 0, 50000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+#endif // TIMING_H
@@ -0,0 +1,322 @@
+// UringReader.cpp
+
+#include "UringReader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Multishot read of any pollable file, Linux 6.7 (headers may predate it)
+#ifndef IORING_OP_READ_MULTISHOT
+#define IORING_OP_READ_MULTISHOT (IORING_OP_SENDMSG_ZC + 1)
+#endif
+
+static const unsigned kSubmitEntries = 256;
+// Every source may end its multishot read with -ENOBUFS in one batch
+static const unsigned kCompleteEntries = 4096;
+static const unsigned short kBufferGroup = 0;
+
+static unsigned roundUpPowerOfTwo(unsigned value)
+{
+    unsigned result = 1;
+    while (result < value && result < 32768)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+UringReader::UringReader(unsigned bufferCount, size_t bufferSize)
+    : ringFd(-1), enabled(false), sqRing(MAP_FAILED), sqRingSize(0), cqRing(MAP_FAILED), cqRingSize(0),
+      sqes(NULL), sqesSize(0), sqHead(NULL), sqTail(NULL), sqMask(0), sqArray(NULL),
+      cqHead(NULL), cqTail(NULL), cqMask(0), cqes(NULL), sqPending(0),
+      bufferRing(NULL), bufferRingSize(0), buffers(NULL), bufferCount(roundUpPowerOfTwo(bufferCount)),
+      bufferSize(bufferSize), bufferTail(0), enters(0), completions(0)
+{
+    // Completions are run only when the owner waits, the ring is enabled by the first submitting thread
+    struct io_uring_params params = {};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_R_DISABLED | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    params.cq_entries = kCompleteEntries;
+    ringFd = static_cast<int>(syscall(__NR_io_uring_setup, kSubmitEntries, &params));
+    if (ringFd < 0 && errno == EINVAL)
+    {
+        // Before Linux 6.1 completions run on any transition to the kernel
+        params = io_uring_params();
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_R_DISABLED;
+        params.cq_entries = kCompleteEntries;
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, kSubmitEntries, &params));
+    }
+    if (ringFd < 0)
+    {
+        return;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        sqRingSize = cqRingSize = (sqRingSize > cqRingSize) ? sqRingSize : cqRingSize;
+    }
+    sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    cqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? sqRing :
+        mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqeMap = mmap(NULL, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqeMap == MAP_FAILED)
+    {
+        close(ringFd);
+        ringFd = -1;
+        return;
+    }
+    sqes = static_cast<struct io_uring_sqe *>(sqeMap);
+
+    char *sq = static_cast<char *>(sqRing);
+    char *cq = static_cast<char *>(cqRing);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    for (unsigned i = 0; i <= sqMask; ++i)
+    {
+        sqArray[i] = i;
+    }
+
+    // Provided buffer ring: the kernel picks a free buffer per completed read
+    bufferRingSize = this->bufferCount * sizeof(struct io_uring_buf);
+    void *ringMap = mmap(NULL, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void *bufferMap = mmap(NULL, this->bufferCount * bufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    struct io_uring_buf_reg reg = {};
+    reg.ring_addr = reinterpret_cast<unsigned long>(ringMap);
+    reg.ring_entries = this->bufferCount;
+    reg.bgid = kBufferGroup;
+    if (ringMap == MAP_FAILED || bufferMap == MAP_FAILED ||
+        syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        if (ringMap != MAP_FAILED)
+        {
+            munmap(ringMap, bufferRingSize);
+        }
+        if (bufferMap != MAP_FAILED)
+        {
+            munmap(bufferMap, this->bufferCount * bufferSize);
+        }
+        close(ringFd);
+        ringFd = -1;
+        return;
+    }
+    bufferRing = static_cast<struct io_uring_buf_ring *>(ringMap);
+    buffers = static_cast<char *>(bufferMap);
+    for (unsigned i = 0; i < this->bufferCount; ++i)
+    {
+        recycle(static_cast<unsigned short>(i));
+    }
+}
+
+UringReader::~UringReader()
+{
+    if (ringFd >= 0)
+    {
+        // Pinned buffer ring is released before its memory
+        struct io_uring_buf_reg reg = {};
+        reg.bgid = kBufferGroup;
+        syscall(__NR_io_uring_register, ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        close(ringFd);
+        munmap(bufferRing, bufferRingSize);
+        munmap(buffers, bufferCount * bufferSize);
+        munmap(sqes, sqesSize);
+        if (cqRing != sqRing)
+        {
+            munmap(cqRing, cqRingSize);
+        }
+        munmap(sqRing, sqRingSize);
+    }
+}
+
+bool UringReader::valid() const
+{
+    return ringFd >= 0;
+}
+
+bool UringReader::add(int fd, void* tag)
+{
+    struct stat st;
+    if (ringFd < 0 || fd < 0 || fstat(fd, &st) != 0)
+    {
+        return false;
+    }
+
+    if (opcodes.size() <= static_cast<size_t>(fd))
+    {
+        opcodes.resize(fd + 1);
+    }
+    opcodes[fd] = S_ISSOCK(st.st_mode) ? IORING_OP_RECV : IORING_OP_READ_MULTISHOT;
+    return arm(fd, tag, opcodes[fd]);
+}
+
+bool UringReader::rearm(int fd, void* tag)
+{
+    return fd >= 0 && static_cast<size_t>(fd) < opcodes.size() && arm(fd, tag, opcodes[fd]);
+}
+
+bool UringReader::poll(int fd, void* tag)
+{
+    struct io_uring_sqe *sqe = (ringFd >= 0) ? nextSqe() : NULL;
+    if (sqe == NULL)
+    {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = reinterpret_cast<unsigned long>(tag);
+    return true;
+}
+
+int UringReader::wait(long timeoutMs)
+{
+    // Completions already reaped into the queue are not waited for
+    bool ready = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE) != *cqHead;
+
+    struct __kernel_timespec ts = {};
+    struct io_uring_getevents_arg arg = {};
+    if (timeoutMs > 0)
+    {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (timeoutMs % 1000) * 1000000;
+        arg.ts = reinterpret_cast<unsigned long>(&ts);
+    }
+
+    int result = enter(sqPending, (timeoutMs == 0 || ready) ? 0 : 1, IORING_ENTER_GETEVENTS, &arg, sizeof(arg));
+    if (result < 0 && (errno == ETIME || errno == EINTR || errno == EBUSY))
+    {
+        return 0;
+    }
+    return result < 0 ? -1 : 0;
+}
+
+size_t UringReader::drain(const std::function<void(const Completion&)>& handler)
+{
+    size_t count = 0;
+    unsigned head = *cqHead;
+    unsigned tail;
+
+    while (head != (tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)))
+    {
+        for (; head != tail; ++head)
+        {
+            const struct io_uring_cqe *cqe = &cqes[head & cqMask];
+            const bool hasBuffer = (cqe->flags & IORING_CQE_F_BUFFER) != 0;
+            const unsigned short bufferId = static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+
+            Completion completion;
+            completion.tag = reinterpret_cast<void *>(static_cast<unsigned long>(cqe->user_data));
+            completion.data = hasBuffer ? buffers + bufferId * bufferSize : NULL;
+            completion.result = cqe->res;
+            completion.more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+            __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+            handler(completion);
+            if (hasBuffer)
+            {
+                recycle(bufferId);
+            }
+            count++;
+        }
+    }
+
+    completions += count;
+    return count;
+}
+
+unsigned long long UringReader::enterCount() const
+{
+    return enters;
+}
+
+unsigned long long UringReader::completionCount() const
+{
+    return completions;
+}
+
+bool UringReader::arm(int fd, void* tag, unsigned char opcode)
+{
+    struct io_uring_sqe *sqe = (ringFd >= 0) ? nextSqe() : NULL;
+    if (sqe == NULL)
+    {
+        return false;
+    }
+
+    sqe->opcode = opcode;
+    if (opcode == IORING_OP_RECV)
+    {
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+    }
+    sqe->fd = fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = reinterpret_cast<unsigned long>(tag);
+    return true;
+}
+
+struct io_uring_sqe* UringReader::nextSqe()
+{
+    // Queue is full only when many requests are armed before a wait
+    if (sqPending > sqMask && enter(sqPending, 0, 0, NULL, 0) < 0)
+    {
+        return NULL;
+    }
+
+    unsigned tail = *sqTail;
+    struct io_uring_sqe *sqe = &sqes[tail & sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    sqPending++;
+    return sqe;
+}
+
+int UringReader::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize)
+{
+    if (!enabled)
+    {
+        if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_ENABLE_RINGS, NULL, 0) != 0)
+        {
+            return -1;
+        }
+        enabled = true;
+    }
+    if (arg != NULL)
+    {
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+
+    enters++;
+    int result = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, arg, argSize));
+    if (result >= 0)
+    {
+        sqPending -= static_cast<unsigned>(result) < sqPending ? static_cast<unsigned>(result) : sqPending;
+    }
+    return result;
+}
+
+void UringReader::recycle(unsigned short bufferId)
+{
+    // Ring tail shares memory with the reserved field of the first entry, fields are set one by one.
+    // Entries are indexed by hand: C++ places the flexible bufs array of the header after an empty struct.
+    struct io_uring_buf *buf = reinterpret_cast<struct io_uring_buf *>(bufferRing) + (bufferTail & (bufferCount - 1));
+    buf->addr = reinterpret_cast<unsigned long>(buffers + bufferId * bufferSize);
+    buf->len = static_cast<unsigned>(bufferSize);
+    buf->bid = bufferId;
+    bufferTail++;
+    __atomic_store_n(&bufferRing->tail, bufferTail, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,88 @@
+#ifndef URINGREADER_H
+#define URINGREADER_H
+#include <cstddef>
+#include <functional>
+#include <sys/types.h>
+#include <vector>
+
+// Multishot reads of many descriptors through one io_uring (raw syscalls, no
+// liburing). Reads land in a ring of provided buffers shared by all
+// descriptors and stay armed between completions, completions are reaped
+// from shared memory, so one io_uring_enter submits, waits and collects a
+// batch over any number of sources. The ring belongs to the thread that
+// first submits to it, normally the one calling wait().
+class UringReader
+{
+public:
+    static const unsigned kDefaultBufferCount = 64;
+    static const size_t kDefaultBufferSize = 16 * 1024;
+
+    struct Completion
+    {
+        void* tag;
+        const char* data;
+        // Bytes read, 0 at end of stream, -errno on error; poll mask for poll()
+        ssize_t result;
+        // Request stays armed, otherwise add() or poll() it again to keep receiving
+        bool more;
+    };
+
+    explicit UringReader(unsigned bufferCount = kDefaultBufferCount, size_t bufferSize = kDefaultBufferSize);
+    ~UringReader();
+
+    // False when the kernel has no io_uring or provided buffer rings
+    bool valid() const;
+
+    // Arms a multishot receive (sockets) or read (other pollable descriptors).
+    // A kernel without multishot reads of fd completes with -EINVAL, -EOPNOTSUPP or -EBADFD.
+    bool add(int fd, void* tag);
+    // Arms fd again after its read ended, with the operation chosen by add()
+    bool rearm(int fd, void* tag);
+    // Arms a multishot poll for input of fd
+    bool poll(int fd, void* tag);
+    // Submits armed requests and waits up to timeoutMs (-1 forever, 0 not at all)
+    // for a completion, returns -1 with errno on failure
+    int wait(long timeoutMs);
+    // Hands over every reaped completion, its buffer is reused once handler returns
+    size_t drain(const std::function<void(const Completion&)>& handler);
+
+    unsigned long long enterCount() const;
+    unsigned long long completionCount() const;
+
+private:
+    bool arm(int fd, void* tag, unsigned char opcode);
+    struct io_uring_sqe* nextSqe();
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize);
+    void recycle(unsigned short bufferId);
+
+    int ringFd;
+    bool enabled;
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    struct io_uring_sqe* sqes;
+    size_t sqesSize;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe* cqes;
+    unsigned sqPending;
+    std::vector<unsigned char> opcodes; // by descriptor
+
+    struct io_uring_buf_ring* bufferRing;
+    size_t bufferRingSize;
+    char* buffers;
+    unsigned bufferCount;
+    size_t bufferSize;
+    unsigned short bufferTail;
+
+    unsigned long long enters;
+    unsigned long long completions;
+};
+
+#endif // URINGREADER_H
@@ -0,0 +1,258 @@
+// nmea_corpus.cpp
+//
+// Standard data sets for the parser benchmarks, the same bytes on every run.
+//
+// Usage: nmea_corpus [-s seed] [-d devices] [-n epochs] [-e every] directory
+//   -s, --seed n      seed of the device random sequences (default 1)
+//   -d, --devices n   receivers multiplexed into each data set (default 8)
+//   -n, --epochs n    epochs per device (default 5000)
+//   -e, --every n     noisy.nmea corrupts about one sentence of n (default 50)
+//
+// Writes into directory:
+//   clean.nmea        GGA, GSA, GSV, RMC and VTG of NMEA_GEN_ROTATE and
+//                     NMEA_GEN_POS_RANDMOVE devices, epoch by epoch
+//   noisy.nmea        clean.nmea with a checksum digit or a payload digit
+//                     changed, so those sentences fail the CRC check
+//   gsv.nmea          GGA, GSV and RMC of devices tracking 24 satellites,
+//                     six packet GSV sequences
+//
+// Every device is an nmeaGENCONTEXT of (seed, device) with a virtual clock
+// starting 2024-01-01 00:00:00 UTC, one epoch a second.
+
+#include "nmea.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+static const long long kStartMs = 1704067200000LL;
+static const int kGsvSatellites = 24;
+
+struct Options
+{
+    unsigned long long seed = 1;
+    long devices = 8;
+    long epochs = 5000;
+    long every = 50;
+};
+
+struct Device
+{
+    nmeaGENCONTEXT ctx;
+    nmeaINFO info;
+    nmeaGENERATOR *gen = NULL;
+};
+
+// Receivers advanced epoch by epoch, the output of one epoch of every device after another
+class Multiplexer
+{
+public:
+    Multiplexer(const Options& options, int type, int satellites) : devices(static_cast<size_t>(options.devices))
+    {
+        for (size_t dev = 0; dev < devices.size(); ++dev)
+        {
+            Device& device = devices[dev];
+            const int devType = type >= 0 ? type : ((dev % 2) ? NMEA_GEN_POS_RANDMOVE : NMEA_GEN_ROTATE);
+            nmea_gen_context_init(&device.ctx, options.seed, dev, kStartMs, 1000);
+            nmea_zero_INFO(&device.info);
+            device.gen = nmea_create_generator(devType, &device.info);
+
+            nmeaPOS pos;
+            nmea_info2pos(&device.info, &pos);
+            nmea_move_horz(&pos, &pos, nmea_random_from(&device.ctx.rnd, 0, 360), nmea_random_from(&device.ctx.rnd, 0, 50));
+            nmea_pos2info(&pos, &device.info);
+
+            if (satellites > 0)
+            {
+                nmeaSATINFO& sat = device.info.satinfo;
+                sat.inview = satellites;
+                sat.inuse = 0;
+                for (int it = 0; it < satellites; ++it)
+                {
+                    sat.sat[it].id = it + 1;
+                    sat.sat[it].in_use = (it < 12) ? 1 : 0;
+                    sat.sat[it].elv = static_cast<int>(nmea_random_from(&device.ctx.rnd, 5, 85));
+                    sat.sat[it].azimuth = it * 360 / satellites;
+                    sat.sat[it].sig = static_cast<int>(nmea_random_from(&device.ctx.rnd, 20, 50));
+                    sat.inuse += sat.sat[it].in_use;
+                }
+            }
+        }
+    }
+
+    ~Multiplexer()
+    {
+        for (Device& device : devices)
+        {
+            nmea_destroy_generator(device.gen);
+        }
+    }
+
+    // Appends the next epoch of every device
+    void epoch(std::string& out, int mask)
+    {
+        char buff[8192];
+        for (Device& device : devices)
+        {
+            const int size = nmea_generate_ctx(buff, sizeof(buff), &device.info, device.gen, &device.ctx, mask);
+            out.append(buff, static_cast<size_t>(size));
+        }
+    }
+
+private:
+    std::vector<Device> devices;
+};
+
+// Changes one digit of the sentence at line, the checksum then never matches
+static void corrupt(char *line, size_t length, nmeaRANDOM *rnd)
+{
+    const char *star = static_cast<const char *>(memchr(line, '*', length));
+    if (star == NULL)
+    {
+        return;
+    }
+
+    if (nmea_random_next(rnd) & 1)
+    {
+        // Checksum digit, stays a hex digit
+        char *digit = line + (star - line) + 1 + static_cast<size_t>(nmea_random_next(rnd) & 1);
+        *digit = (*digit == '0') ? '1' : '0';
+        return;
+    }
+
+    std::vector<size_t> digits;
+    for (size_t it = 1; line + it < star; ++it)
+    {
+        if (line[it] >= '0' && line[it] <= '9')
+        {
+            digits.push_back(it);
+        }
+    }
+    if (digits.empty())
+    {
+        return;
+    }
+    char& digit = line[digits[nmea_random_next(rnd) % digits.size()]];
+    digit = static_cast<char>('0' + (digit - '0' + 1) % 10);
+}
+
+static long corruptStream(std::string& stream, long every, unsigned long long seed)
+{
+    nmeaRANDOM rnd;
+    long corrupted = 0;
+    nmea_random_seed(&rnd, seed ^ 0x6e6f697379ULL);
+    for (size_t line = 0; line < stream.size();)
+    {
+        const char *tail = static_cast<const char *>(memchr(stream.data() + line, '\n', stream.size() - line));
+        const size_t end = tail ? static_cast<size_t>(tail - stream.data()) + 1 : stream.size();
+        if (nmea_random_next(&rnd) % static_cast<unsigned long long>(every) == 0)
+        {
+            corrupt(&stream[line], end - line, &rnd);
+            corrupted++;
+        }
+        line = end;
+    }
+    return corrupted;
+}
+
+static bool writeFile(const std::string& path, const std::string& data)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+    {
+        std::cerr << "Cannot write " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    const bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && written;
+}
+
+static long lineCount(const std::string& data)
+{
+    long lines = 0;
+    for (const char *line = data.data(), *end = line + data.size(); (line = static_cast<const char *>(memchr(line, '\n', end - line))) != NULL; ++line)
+    {
+        lines++;
+    }
+    return lines;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    int first = 1;
+    for (; first + 1 < argc; first += 2)
+    {
+        const char *option = argv[first];
+        const char *value = argv[first + 1];
+        if (strcmp(option, "-s") == 0 || strcmp(option, "--seed") == 0)
+        {
+            options.seed = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(option, "-d") == 0 || strcmp(option, "--devices") == 0)
+        {
+            options.devices = atol(value);
+        }
+        else if (strcmp(option, "-n") == 0 || strcmp(option, "--epochs") == 0)
+        {
+            options.epochs = atol(value);
+        }
+        else if (strcmp(option, "-e") == 0 || strcmp(option, "--every") == 0)
+        {
+            options.every = atol(value);
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (first + 1 != argc || options.devices < 1 || options.epochs < 1 || options.every < 1)
+    {
+        std::cerr << "Usage: nmea_corpus [-s seed] [-d devices] [-n epochs] [-e every] directory" << std::endl;
+        return 1;
+    }
+
+    const std::string dir = argv[first];
+    if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST)
+    {
+        std::cerr << "Cannot create " << dir << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::string clean;
+    {
+        Multiplexer mux(options, -1, 0);
+        for (long it = 0; it < options.epochs; ++it)
+        {
+            mux.epoch(clean, GPGGA | GPGSA | GPGSV | GPRMC | GPVTG);
+        }
+    }
+
+    std::string gsv;
+    {
+        Multiplexer mux(options, NMEA_GEN_ROTATE, kGsvSatellites);
+        for (long it = 0; it < options.epochs; ++it)
+        {
+            mux.epoch(gsv, GPGGA | GPGSV | GPRMC);
+        }
+    }
+
+    std::string noisy = clean;
+    const long corrupted = corruptStream(noisy, options.every, options.seed);
+
+    if (!writeFile(dir + "/clean.nmea", clean) || !writeFile(dir + "/noisy.nmea", noisy) || !writeFile(dir + "/gsv.nmea", gsv))
+    {
+        return 1;
+    }
+
+    printf("clean.nmea %ld sentences %zu bytes\n", lineCount(clean), clean.size());
+    printf("noisy.nmea %ld sentences %zu bytes, %ld corrupted\n", lineCount(noisy), noisy.size(), corrupted);
+    printf("gsv.nmea   %ld sentences %zu bytes\n", lineCount(gsv), gsv.size());
+    return 0;
+}
@@ -0,0 +1,474 @@
+// nmea_feed.cpp
+//
+// Synthetic receivers for load tests of LocationService.
+//
+// Usage: nmea_feed [-d devices] [-j threads] [-r rate] [-n epochs] [-t seconds]
+//                  [-g rotate|randmove|mixed] [-m GGA,GSA,GSV,RMC,VTG] [-s seed]
+//                  [-c seconds] [-i ms] [output...]
+//   -d, --devices n   simulated receivers (default 1000)
+//   -j, --threads n   generating threads, every thread owns a share of the devices (default 1)
+//   -r, --rate n      aggregate sentences per second over all outputs (default 0, as fast as possible)
+//   -n, --epochs n    epochs per device (default 0, until -t, SIGINT or the reader goes away)
+//   -t, --time sec    stop after sec seconds
+//   -g, --gen type    NMEA_GEN_ROTATE, NMEA_GEN_POS_RANDMOVE or both in turn per device (default mixed)
+//   -m, --mask list   sentences of an epoch (default all five)
+//   -s, --seed n      seed of the device random sequences (default 1)
+//   -c, --clock sec   virtual time of the first epoch in seconds since 1970 (default now)
+//   -i, --interval ms virtual time between epochs of a device (default 1000)
+//   -                 standard output, a file or a pipe (default when no output is given)
+//   unix:/path        listen on UNIX stream socket path and feed the first client
+//                     (e.g. LocationService unix:/path)
+//   exec:command      run command with one end of a socketpair as its standard input
+//                     (e.g. "exec:LocationService -q")
+//   /path             file (truncated) or FIFO
+//
+// Devices are spread over the outputs, device d writes to output d % outputs.
+// Whole epochs of a device are written at once, so every output stays a
+// valid NMEA stream whatever the number of threads. Every device has its own
+// nmeaGENCONTEXT, with -c its sentences do not depend on -j or on the run.
+
+#include "nmea.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const size_t kBatchBytes = 64 * 1024;
+
+static std::atomic<bool> stopping(false);
+
+static void onSignal(int)
+{
+    stopping.store(true, std::memory_order_relaxed);
+}
+
+static long long nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleepUntil(long long deadlineNs)
+{
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000LL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR && !stopping.load(std::memory_order_relaxed))
+    {
+    }
+}
+
+// One stream written by every thread, batches of whole epochs under the lock
+struct Output
+{
+    std::string name;
+    int fd = -1;
+    pid_t child = -1;
+    std::mutex lock;
+
+    bool write(const std::string& batch)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (size_t done = 0; done < batch.size();)
+        {
+            ssize_t count = ::write(fd, batch.data() + done, batch.size() - done);
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (count <= 0)
+            {
+                return false;
+            }
+            done += static_cast<size_t>(count);
+        }
+        return true;
+    }
+};
+
+static int listenUnix(const std::string& path)
+{
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    int server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server < 0)
+    {
+        return -1;
+    }
+    unlink(path.c_str());
+    if (bind(server, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 || listen(server, 1) < 0)
+    {
+        close(server);
+        return -1;
+    }
+
+    std::cerr << "Waiting for a client on " << path << std::endl;
+    int fd = accept4(server, NULL, NULL, SOCK_CLOEXEC);
+    close(server);
+    unlink(path.c_str());
+    return fd;
+}
+
+static int execCommand(const std::string& command, pid_t& child)
+{
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) < 0)
+    {
+        return -1;
+    }
+
+    child = fork();
+    if (child == 0)
+    {
+        dup2(pair[1], STDIN_FILENO);
+        execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char *>(NULL));
+        _exit(127);
+    }
+    close(pair[1]);
+    if (child < 0)
+    {
+        close(pair[0]);
+        return -1;
+    }
+    shutdown(pair[0], SHUT_RD);
+    return pair[0];
+}
+
+static int openOutput(Output& output)
+{
+    const std::string& spec = output.name;
+    if (spec == "-")
+    {
+        return STDOUT_FILENO;
+    }
+    if (spec.compare(0, 5, "unix:") == 0)
+    {
+        return listenUnix(spec.substr(5));
+    }
+    if (spec.compare(0, 5, "exec:") == 0)
+    {
+        return execCommand(spec.substr(5), output.child);
+    }
+    return open(spec.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+}
+
+static int parseMask(const char *list)
+{
+    static const struct
+    {
+        const char *name;
+        int type;
+    } types[] = { { "GGA", GPGGA }, { "GSA", GPGSA }, { "GSV", GPGSV }, { "RMC", GPRMC }, { "VTG", GPVTG } };
+
+    int mask = 0;
+    for (const char *field = list; *field;)
+    {
+        size_t length = strcspn(field, ",");
+        int type = 0;
+        for (const auto& entry : types)
+        {
+            if (length == 3 && strncmp(field, entry.name, 3) == 0)
+            {
+                type = entry.type;
+            }
+        }
+        if (type == 0)
+        {
+            return 0;
+        }
+        mask |= type;
+        field += length + (field[length] == ',' ? 1 : 0);
+    }
+    return mask;
+}
+
+struct Options
+{
+    long devices = 1000;
+    long threads = 1;
+    double rate = 0;
+    long epochs = 0;
+    double seconds = 0;
+    int gen = -1; // -1 alternates NMEA_GEN_ROTATE and NMEA_GEN_POS_RANDMOVE
+    int mask = GPGGA | GPGSA | GPGSV | GPRMC | GPVTG;
+    unsigned long long seed = 1;
+    long long startMs = -1;
+    int interval = 1000;
+};
+
+struct Totals
+{
+    std::atomic<unsigned long long> sentences{0};
+    std::atomic<unsigned long long> bytes{0};
+    std::atomic<bool> failed{false};
+};
+
+struct Device
+{
+    nmeaINFO info;
+    nmeaGENCONTEXT ctx;
+    nmeaGENERATOR *gen = NULL;
+    Output *output = NULL;
+};
+
+// Devices [first, last) of one thread
+static void runThread(const Options& options, long first, long last,
+                      std::vector<Output>& outputs, long long deadlineNs, Totals& totals)
+{
+    std::vector<Device> devices(static_cast<size_t>(last - first));
+    for (long dev = first; dev < last; ++dev)
+    {
+        Device& device = devices[static_cast<size_t>(dev - first)];
+        const int type = options.gen >= 0 ? options.gen : ((dev % 2) ? NMEA_GEN_POS_RANDMOVE : NMEA_GEN_ROTATE);
+        nmea_gen_context_init(&device.ctx, options.seed, static_cast<unsigned long long>(dev), options.startMs, options.interval);
+        nmea_zero_INFO(&device.info);
+        device.gen = nmea_create_generator(type, &device.info);
+        device.output = &outputs[static_cast<size_t>(dev) % outputs.size()];
+
+        // Receivers scattered up to 50 km around the default position
+        nmeaPOS pos;
+        nmea_info2pos(&device.info, &pos);
+        nmea_move_horz(&pos, &pos, nmea_random_from(&device.ctx.rnd, 0, 360), nmea_random_from(&device.ctx.rnd, 0, 50));
+        nmea_pos2info(&pos, &device.info);
+    }
+
+    // Sentences of about a millisecond per batch when paced, so pacing stays smooth
+    const double rate = options.rate / static_cast<double>(options.threads);
+    const unsigned long long batchSentences = rate > 0 ? static_cast<unsigned long long>(rate / 1000) + 1 : ~0ULL;
+    std::vector<std::string> batches(outputs.size());
+    std::vector<unsigned long long> batched(outputs.size(), 0);
+    for (std::string& batch : batches)
+    {
+        batch.reserve(kBatchBytes + 8192);
+    }
+
+    unsigned long long sentences = 0;
+    unsigned long long bytes = 0;
+    const long long startNs = nowNs();
+    char buff[8192];
+    bool running = !devices.empty();
+
+    auto flush = [&](size_t out) -> bool
+    {
+        if (batches[out].empty())
+        {
+            return true;
+        }
+        sentences += batched[out];
+        bytes += batches[out].size();
+        if (rate > 0)
+        {
+            sleepUntil(startNs + static_cast<long long>(static_cast<double>(sentences) * 1e9 / rate));
+        }
+        bool written = outputs[out].write(batches[out]);
+        batches[out].clear();
+        batched[out] = 0;
+        return written;
+    };
+
+    for (long epoch = 0; running && (options.epochs <= 0 || epoch < options.epochs); ++epoch)
+    {
+        for (Device& device : devices)
+        {
+            const int size = nmea_generate_ctx(buff, sizeof(buff), &device.info, device.gen, &device.ctx, options.mask);
+            const size_t out = static_cast<size_t>(device.output - outputs.data());
+            batches[out].append(buff, static_cast<size_t>(size));
+            for (const char *line = buff, *end = buff + size; (line = static_cast<const char *>(memchr(line, '\n', end - line))) != NULL; ++line)
+            {
+                batched[out]++;
+            }
+
+            if (batches[out].size() >= kBatchBytes || batched[out] >= batchSentences)
+            {
+                if (!flush(out))
+                {
+                    totals.failed.store(true, std::memory_order_relaxed);
+                    stopping.store(true, std::memory_order_relaxed);
+                }
+                if (stopping.load(std::memory_order_relaxed) || (deadlineNs > 0 && nowNs() >= deadlineNs))
+                {
+                    running = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Partial epochs of the last round are still whole per device
+    for (size_t out = 0; out < outputs.size(); ++out)
+    {
+        if (!totals.failed.load(std::memory_order_relaxed) && !flush(out))
+        {
+            totals.failed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    for (Device& device : devices)
+    {
+        nmea_destroy_generator(device.gen);
+    }
+    totals.sentences += sentences;
+    totals.bytes += bytes;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    int first = 1;
+    for (; first + 1 < argc; first += 2)
+    {
+        const char *option = argv[first];
+        const char *value = argv[first + 1];
+        if (strcmp(option, "-d") == 0 || strcmp(option, "--devices") == 0)
+        {
+            options.devices = atol(value);
+        }
+        else if (strcmp(option, "-j") == 0 || strcmp(option, "--threads") == 0)
+        {
+            options.threads = atol(value);
+        }
+        else if (strcmp(option, "-r") == 0 || strcmp(option, "--rate") == 0)
+        {
+            options.rate = atof(value);
+        }
+        else if (strcmp(option, "-n") == 0 || strcmp(option, "--epochs") == 0)
+        {
+            options.epochs = atol(value);
+        }
+        else if (strcmp(option, "-t") == 0 || strcmp(option, "--time") == 0)
+        {
+            options.seconds = atof(value);
+        }
+        else if (strcmp(option, "-g") == 0 || strcmp(option, "--gen") == 0)
+        {
+            if (strcmp(value, "rotate") == 0)
+            {
+                options.gen = NMEA_GEN_ROTATE;
+            }
+            else if (strcmp(value, "randmove") == 0)
+            {
+                options.gen = NMEA_GEN_POS_RANDMOVE;
+            }
+            else if (strcmp(value, "mixed") == 0)
+            {
+                options.gen = -1;
+            }
+            else
+            {
+                std::cerr << "Unknown generator " << value << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(option, "-m") == 0 || strcmp(option, "--mask") == 0)
+        {
+            if ((options.mask = parseMask(value)) == 0)
+            {
+                std::cerr << "Bad sentence list " << value << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(option, "-s") == 0 || strcmp(option, "--seed") == 0)
+        {
+            options.seed = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(option, "-c") == 0 || strcmp(option, "--clock") == 0)
+        {
+            options.startMs = atoll(value) * 1000;
+        }
+        else if (strcmp(option, "-i") == 0 || strcmp(option, "--interval") == 0)
+        {
+            options.interval = atoi(value);
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (options.devices < 1 || options.threads < 1)
+    {
+        std::cerr << "At least one device and one thread are needed" << std::endl;
+        return 1;
+    }
+    options.threads = std::min(options.threads, options.devices);
+    if (options.startMs < 0)
+    {
+        options.startMs = static_cast<long long>(time(NULL)) * 1000;
+    }
+
+    std::vector<Output> outputs(first < argc ? static_cast<size_t>(argc - first) : 1);
+    for (size_t i = 0; i < outputs.size(); ++i)
+    {
+        outputs[i].name = first < argc ? argv[first + static_cast<int>(i)] : "-";
+        if ((outputs[i].fd = openOutput(outputs[i])) < 0)
+        {
+            std::cerr << "Cannot open output " << outputs[i].name << ": " << strerror(errno) << std::endl;
+            return 1;
+        }
+    }
+
+    // A reader going away ends the feed instead of killing it
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    Totals totals;
+    const long long startNs = nowNs();
+    const long long deadlineNs = options.seconds > 0 ? startNs + static_cast<long long>(options.seconds * 1e9) : 0;
+    std::vector<std::thread> threads;
+    for (long t = 0; t < options.threads; ++t)
+    {
+        const long from = options.devices * t / options.threads;
+        const long to = options.devices * (t + 1) / options.threads;
+        threads.emplace_back(runThread, std::cref(options), from, to, std::ref(outputs), deadlineNs, std::ref(totals));
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    const double seconds = static_cast<double>(nowNs() - startNs) / 1e9;
+
+    int status = totals.failed.load() ? 1 : 0;
+    for (Output& output : outputs)
+    {
+        if (output.fd != STDOUT_FILENO)
+        {
+            close(output.fd);
+        }
+        int childStatus = 0;
+        if (output.child > 0 && waitpid(output.child, &childStatus, 0) == output.child && childStatus != 0)
+        {
+            status = 1;
+        }
+    }
+
+    const unsigned long long sentences = totals.sentences.load();
+    const unsigned long long bytes = totals.bytes.load();
+    fprintf(stderr, "%ld devices %ld threads: %llu sentences %llu bytes in %.3f s, %.0f sentences/s %.1f MB/s%s\n",
+            options.devices, options.threads, sentences, bytes, seconds,
+            seconds > 0 ? sentences / seconds : 0.0, seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0,
+            totals.failed.load() ? ", output closed" : "");
+    return status;
+}